@@ -6,41 +6,96 @@ in vec3 v_normal;
 in vec2 v_uv;
 uniform float unif_time;
 uniform vec3 unif_view_pos;
-uniform float unif_textured_color;
-uniform float unif_textured_normal;
+#ifdef KGFW_TEXTURED
 uniform sampler2D unif_texture_color;
+#endif
+#ifdef KGFW_NORMAL_MAPPED
 uniform sampler2D unif_texture_normal;
+#endif
+#ifdef KGFW_LIT
+/* clustered lights, every cluster lists the lights whose bounds touch it */
+uniform mat4 unif_v;
+uniform vec4 unif_cluster_viewport;
+uniform vec2 unif_cluster_depth;
+uniform samplerBuffer unif_lights;
+uniform usamplerBuffer unif_clusters;
+uniform usamplerBuffer unif_light_indices;
+#endif
 out vec4 out_color;
 
+#ifdef KGFW_NORMAL_MAPPED
+/* there are no vertex tangents, so the tangent frame is rebuilt from screen space derivatives */
+vec3 perturb_normal(vec3 normal) {
+	vec3 dp1 = dFdx(v_pos);
+	vec3 dp2 = dFdy(v_pos);
+	vec2 duv1 = dFdx(v_uv);
+	vec2 duv2 = dFdy(v_uv);
+
+	vec3 dp2perp = cross(dp2, normal);
+	vec3 dp1perp = cross(normal, dp1);
+	vec3 t = dp2perp * duv1.x + dp1perp * duv2.x;
+	vec3 b = dp2perp * duv1.y + dp1perp * duv2.y;
+	float invmax = inversesqrt(max(dot(t, t), dot(b, b)));
+
+	vec3 sampled = texture(unif_texture_normal, v_uv).xyz * 2 - 1;
+	return normalize(mat3(t * invmax, b * invmax, normal) * sampled);
+}
+#endif
+
 void main() {
-	vec4 tex = texture(unif_texture_color, v_uv);
-	vec4 col = mix(vec4((v_normal + 1) / 2, 1), tex, unif_textured_color);
+#ifdef KGFW_TEXTURED
+	vec4 col = texture(unif_texture_color, v_uv);
 	if (col.a == 0) {
 		discard;
 	}
+#else
+	vec4 col = vec4((v_normal + 1) / 2, 1);
+#endif
 
-	vec3 light_pos = vec3(0, 100, 0);
-	float light_power = 2000;
-	vec3 dir = light_pos - v_pos;
-	float dist = length(dir);
-	dir = normalize(dir);
-	vec3 light_color = vec3(1, 1, 1);
-	vec3 ambient_color = vec3(1, 1, 1);
+#ifdef KGFW_DEPTH_ONLY
+	/* depth pre-pass, only the alpha test above matters */
+	out_color = vec4(0);
+#elif !defined(KGFW_LIT)
+	out_color = vec4(col.xyz, 1);
+#else
+	vec3 normal = normalize(v_normal);
+#ifdef KGFW_NORMAL_MAPPED
+	normal = perturb_normal(normal);
+#endif
 
+	vec3 ambient_color = vec3(1, 1, 1);
 	float ambience = 0.6;
 	float diffusion = 1;
 	float shiny = 2;
 
-	float lambertian = max(dot(dir, v_normal), 0) * diffusion;
-	
-	float specular = 0;
-	if (lambertian > 0) {
-		vec3 view_dir = normalize(-v_pos);
-		vec3 half_dir = normalize(dir + view_dir);
-		float spec = max(dot(half_dir, v_normal), 0);
-		specular = pow(spec, shiny);
+	float view_z = -(unif_v * vec4(v_pos, 1)).z;
+	uvec2 tile = uvec2(clamp((gl_FragCoord.xy - unif_cluster_viewport.xy) / unif_cluster_viewport.zw, 0.0, 0.9999) * vec2(KGFW_CLUSTERS.xy));
+	uint slice = uint(clamp(log(max(view_z, 0.0001)) * unif_cluster_depth.x + unif_cluster_depth.y, 0.0, float(KGFW_CLUSTERS.z - 1u)));
+	uvec2 cluster = texelFetch(unif_clusters, int(tile.x + KGFW_CLUSTERS.x * (tile.y + KGFW_CLUSTERS.y * slice))).xy;
+
+	vec3 view_dir = normalize(unif_view_pos - v_pos);
+	vec3 light = ambient_color * ambience;
+	for (uint i = 0u; i < cluster.y; ++i) {
+		int index = int(texelFetch(unif_light_indices, int(cluster.x + i)).r);
+		vec4 pos_radius = texelFetch(unif_lights, index * 2);
+		vec3 light_color = texelFetch(unif_lights, index * 2 + 1).rgb;
+
+		vec3 dir = pos_radius.xyz - v_pos;
+		float dist2 = max(dot(dir, dir), 0.0001);
+		dir *= inversesqrt(dist2);
+		float window = clamp(1 - pow(dist2 / (pos_radius.w * pos_radius.w), 2), 0, 1);
+		float attenuation = window * window / dist2;
+
+		float lambertian = max(dot(dir, normal), 0) * diffusion;
+		float specular = 0;
+		if (lambertian > 0) {
+			vec3 half_dir = normalize(dir + view_dir);
+			specular = pow(max(dot(half_dir, normal), 0), shiny);
+		}
+
+		light += light_color * (lambertian + specular) * attenuation;
 	}
 
-	vec3 color = col.xyz * ((ambient_color * ambience) + (light_color * lambertian * light_power / (dist * dist)) + (light_color * specular * light_power / (dist * dist)));
-	out_color = vec4(color, 1);/*vec4((v_normal + 1) / 2, 1);*//*vec4(v_pos, 1);*//*vec4(v_uv, 0, 1);*/
+	out_color = vec4(col.xyz * light, 1);
+#endif
 }
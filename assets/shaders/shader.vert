@@ -4,18 +4,25 @@ layout (location = 0) in vec3 in_pos;
 layout (location = 1) in vec3 in_color;
 layout (location = 2) in vec3 in_normal;
 layout (location = 3) in vec2 in_uv;
+#ifdef KGFW_INSTANCED
+layout (location = 4) in mat4 in_m;
+#define MODEL in_m
+#else
 uniform mat4 unif_m;
+#define MODEL unif_m
+#endif
 uniform mat4 unif_vp;
-uniform mat4 unif_m_r;
 out vec3 v_pos;
 out vec3 v_color;
 out vec3 v_normal;
 out vec2 v_uv;
+/* the depth pre-pass relies on every variant producing bit identical depth */
+invariant gl_Position;
 
 void main() {
-	gl_Position = unif_vp * unif_m * vec4(in_pos, 1.0);
-	v_pos = vec3(unif_m * vec4(in_pos, 1.0));
+	gl_Position = unif_vp * MODEL * vec4(in_pos, 1.0);
+	v_pos = vec3(MODEL * vec4(in_pos, 1.0));
 	v_color = in_color;
-	v_normal = normalize(vec3(unif_m * vec4(in_normal, 0.0)));
+	v_normal = normalize(vec3(MODEL * vec4(in_normal, 0.0)));
 	v_uv = in_uv;
 }
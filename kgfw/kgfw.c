@@ -3,13 +3,21 @@
 #if (KGFW_OPENGL == 33 || defined(KGFW_VULKAN) || KGFW_DIRECTX == 11)
 
 #include "kgfw.h"
+#include "koml/koml.h"
 #include <GLFW/glfw3.h>
 #include <time.h>
 #include <stdlib.h>
 
 static void glfw_error(int error, const char * desc);
+static void * koml_alloc(size_t size);
+static void * koml_realloc(void * p, size_t size);
 
 int kgfw_init(void) {
+	if (kgfw_memory_init() != 0) {
+		return 3;
+	}
+	koml_allocator_set(koml_alloc, koml_realloc, kgfw_memory_free);
+
 	glfwSetErrorCallback(glfw_error);
 
 	if (glfwInit() != GLFW_TRUE) {
@@ -17,17 +25,25 @@ int kgfw_init(void) {
 	}
 	glfwSetTime(0);
 
+	if (kgfw_frame_alloc_init() != 0) {
+		glfwTerminate();
+		return 2;
+	}
+
 	srand(time(NULL));
 
 	return 0;
 }
 
 void kgfw_deinit(void) {
+	kgfw_frame_alloc_deinit();
 	glfwTerminate();
+	kgfw_memory_deinit();
 }
 
 int kgfw_update(void) {
-	glfwPollEvents();
+	kgfw_frame_wait();
+	kgfw_frame_alloc_reset();
 
 	return 0;
 }
@@ -35,4 +51,12 @@ int kgfw_update(void) {
 static void glfw_error(int error, const char * desc) {
 	kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "[GLFW] %i 0x%X: %s", error, error, desc);
 }
+
+static void * koml_alloc(size_t size) {
+	return kgfw_memory_alloc(size, KGFW_MEMORY_TAG_KOML);
+}
+
+static void * koml_realloc(void * p, size_t size) {
+	return kgfw_memory_realloc(p, size, KGFW_MEMORY_TAG_KOML);
+}
 #endif
\ No newline at end of file
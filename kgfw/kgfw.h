@@ -6,11 +6,16 @@
 #include "kgfw_commands.h"
 #include "kgfw_console.h"
 #include "kgfw_ecs.h"
+#include "kgfw_frame.h"
 #include "kgfw_graphics.h"
 #include "kgfw_hash.h"
 #include "kgfw_input.h"
 #include "kgfw_log.h"
 #include "kgfw_list.h"
+#include "kgfw_math.h"
+#include "kgfw_memory.h"
+#include "kgfw_mesh.h"
+#include "kgfw_pipeline.h"
 #include "kgfw_time.h"
 #include "kgfw_transform.h"
 #include "kgfw_uuid.h"
@@ -3,6 +3,7 @@
 #include "kwav/kwav.h"
 #include "koml/koml.h"
 #include "kgfw_hash.h"
+#include "kgfw_memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,10 +31,32 @@ struct {
 	struct {
 		ALuint * bo;
 		kgfw_hash_t * names;
+		/* names are compared after the hash matches so collisions cannot play the wrong sound */
+		char ** strings;
 		unsigned long long int length;
 	} buffers;
 } static state;
 
+static char * buffer_name_copy(const char * name) {
+	unsigned long long int len = strlen(name);
+	char * copy = kgfw_memory_alloc(len + 1, KGFW_MEMORY_TAG_AUDIO);
+	if (copy != NULL) {
+		memcpy(copy, name, len + 1);
+	}
+
+	return copy;
+}
+
+static long long int buffer_find(kgfw_hash_t hash, const char * name) {
+	for (unsigned long long int i = 0; i < state.buffers.length; ++i) {
+		if (state.buffers.names[i] == hash && state.buffers.strings[i] != NULL && strcmp(state.buffers.strings[i], name) == 0) {
+			return (long long int) i;
+		}
+	}
+
+	return -1;
+}
+
 #define AL_ERROR_CHECK(ret) { ALCenum error = alGetError(); if (error != AL_NO_ERROR) { kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "[OpenAL] error %i %x at (%s:%u)", error, error, __FILE__, __LINE__); return ret; } }
 #define AL_ERROR_CHECK_VOID() { ALCenum error = alGetError(); if (error != AL_NO_ERROR) { kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "[OpenAL] error %i %x at (%s:%u)", error, error, __FILE__, __LINE__); return; } }
 #define AL_ERROR_CHECK_NO_RETURN() { ALCenum error = alGetError(); if (error != AL_NO_ERROR) { kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "[OpenAL] error %i %x at (%s:%u)", error, error, __FILE__, __LINE__); } }
@@ -83,7 +106,7 @@ int kgfw_audio_init(void) {
 		file.size = ftell(fp);
 		fseek(fp, 0L, SEEK_SET);
 
-		file.buffer = malloc(file.size);
+		file.buffer = kgfw_memory_alloc(file.size, KGFW_MEMORY_TAG_AUDIO);
 		if (file.buffer == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to alloc buffer for \"config.koml\"");
 			return 1;
@@ -98,7 +121,10 @@ int kgfw_audio_init(void) {
 	}
 
 	koml_table_t ktable;
-	if (koml_table_load(&ktable, file.buffer, file.size) != 0) {
+	int loaded = koml_table_load(&ktable, file.buffer, file.size);
+	kgfw_memory_free(file.buffer);
+	file.buffer = NULL;
+	if (loaded != 0) {
 		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to load koml table from \"config.koml\"");
 		return 1;
 	}
@@ -108,13 +134,14 @@ int kgfw_audio_init(void) {
 	state.buffers.length = 0;
 	if (files != NULL && files->type == KOML_TYPE_ARRAY && files->data.array.type == KOML_TYPE_STRING) {
 		state.buffers.length = files->data.array.length;
-		state.buffers.bo = malloc(sizeof(ALuint) * files->data.array.length);
+		state.buffers.bo = kgfw_memory_alloc(sizeof(ALuint) * files->data.array.length, KGFW_MEMORY_TAG_AUDIO);
 		if (state.buffers.bo == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to alloc audio buffers");
 			return 1;
 		}
-		state.buffers.names = malloc(sizeof(kgfw_hash_t) * files->data.array.length);
-		if (state.buffers.names == NULL) {
+		state.buffers.names = kgfw_memory_alloc(sizeof(kgfw_hash_t) * files->data.array.length, KGFW_MEMORY_TAG_AUDIO);
+		state.buffers.strings = kgfw_memory_calloc(files->data.array.length, sizeof(char *), KGFW_MEMORY_TAG_AUDIO);
+		if (state.buffers.names == NULL || state.buffers.strings == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to alloc audio buffers");
 			return 1;
 		}
@@ -128,8 +155,10 @@ int kgfw_audio_init(void) {
 		for (unsigned long long int i = 0; i < files->data.array.length; ++i) {
 			if (names != NULL) {
 				state.buffers.names[i] = kgfw_hash(names->data.array.elements.string[i]);
+				state.buffers.strings[i] = buffer_name_copy(names->data.array.elements.string[i]);
 			} else {
 				state.buffers.names[i] = kgfw_hash(files->data.array.elements.string[i]);
+				state.buffers.strings[i] = buffer_name_copy(files->data.array.elements.string[i]);
 				kgfw_logf(KGFW_LOG_SEVERITY_WARN, "audio file %s has no given name, assuming file name", files->data.array.elements.string[i]);
 			}
 
@@ -144,7 +173,7 @@ int kgfw_audio_init(void) {
 				file.size = ftell(fp);
 				fseek(fp, 0L, SEEK_SET);
 
-				file.buffer = malloc(file.size);
+				file.buffer = kgfw_memory_alloc(file.size, KGFW_MEMORY_TAG_AUDIO);
 				if (file.buffer == NULL) {
 					kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to alloc buffer for \"%s\"", files->data.array.elements.string[i]);
 					return 1;
@@ -163,7 +192,7 @@ int kgfw_audio_init(void) {
 				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "wav loading failed");
 				return 1;
 			}
-			kwav.data = malloc(kwav.header.datasize);
+			kwav.data = kgfw_memory_alloc(kwav.header.datasize, KGFW_MEMORY_TAG_AUDIO);
 			if (kwav.data == NULL) {
 				return 1;
 			}
@@ -199,32 +228,44 @@ int kgfw_audio_init(void) {
 
 			alBufferData(state.buffers.bo[i], format, kwav.data, kwav.header.datasize, kwav.header.rate);
 			AL_ERROR_CHECK(6);
-			free(file.buffer);
-			free(kwav.data);
+			kgfw_memory_free(file.buffer);
+			kgfw_memory_free(kwav.data);
 		}
 	} else {
 		//kgfw_logf(KGFW_LOG_SEVERITY_WARN, "no config.koml with audio files");
 	}
 
+	koml_table_destroy(&ktable);
 	return 0;
 }
 
 int kgfw_audio_load(char * filename, char * name) {
 	kgfw_hash_t hash = kgfw_hash(name);
-	for (unsigned long long int i = 0; i < state.buffers.length; ++i) {
-		if (state.buffers.names[i] == hash) {
-			return -1;
-		}
+	if (buffer_find(hash, name) >= 0) {
+		return -1;
 	}
 
+	char * string = buffer_name_copy(name);
+	if (string == NULL) {
+		return 1;
+	}
+
+	char ** strings = kgfw_memory_realloc(state.buffers.strings, sizeof(char *) * (state.buffers.length + 1), KGFW_MEMORY_TAG_AUDIO);
+	if (strings == NULL) {
+		kgfw_memory_free(string);
+		return 1;
+	}
+	state.buffers.strings = strings;
+	state.buffers.strings[state.buffers.length] = string;
+
 	++state.buffers.length;
 	if (state.buffers.bo == NULL) {
-		state.buffers.bo = malloc(sizeof(ALuint) * state.buffers.length);
+		state.buffers.bo = kgfw_memory_alloc(sizeof(ALuint) * state.buffers.length, KGFW_MEMORY_TAG_AUDIO);
 		if (state.buffers.bo == NULL) {
 			return 1;
 		}
 	} else {
-		ALuint * p = realloc(state.buffers.bo, sizeof(ALuint) * state.buffers.length);
+		ALuint * p = kgfw_memory_realloc(state.buffers.bo, sizeof(ALuint) * state.buffers.length, KGFW_MEMORY_TAG_AUDIO);
 		if (p == NULL) {
 			return 2;
 		}
@@ -232,12 +273,12 @@ int kgfw_audio_load(char * filename, char * name) {
 	}
 
 	if (state.buffers.names == NULL) {
-		state.buffers.names = malloc(sizeof(kgfw_hash_t) * state.buffers.length);
+		state.buffers.names = kgfw_memory_alloc(sizeof(kgfw_hash_t) * state.buffers.length, KGFW_MEMORY_TAG_AUDIO);
 		if (state.buffers.names == NULL) {
 			return 3;
 		}
 	} else {
-		kgfw_hash_t * p = realloc(state.buffers.names, sizeof(kgfw_hash_t) * state.buffers.length);
+		kgfw_hash_t * p = kgfw_memory_realloc(state.buffers.names, sizeof(kgfw_hash_t) * state.buffers.length, KGFW_MEMORY_TAG_AUDIO);
 		if (p == NULL) {
 			return 4;
 		}
@@ -264,7 +305,7 @@ int kgfw_audio_load(char * filename, char * name) {
 		file.size = ftell(fp);
 		fseek(fp, 0L, SEEK_SET);
 
-		file.buffer = malloc(file.size);
+		file.buffer = kgfw_memory_alloc(file.size, KGFW_MEMORY_TAG_AUDIO);
 		if (file.buffer == NULL) {
 			return 6;
 		}
@@ -282,7 +323,7 @@ int kgfw_audio_load(char * filename, char * name) {
 	if (kwav_load(&kwav, file.buffer, file.size) != 0) {
 		return 8;
 	}
-	kwav.data = malloc(kwav.header.datasize);
+	kwav.data = kgfw_memory_alloc(kwav.header.datasize, KGFW_MEMORY_TAG_AUDIO);
 	if (kwav.data == NULL) {
 		return 9;
 	}
@@ -317,8 +358,8 @@ int kgfw_audio_load(char * filename, char * name) {
 	kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "0x%x %u %u", format, kwav.header.datasize, kwav.header.rate);
 	alBufferData(state.buffers.bo[state.buffers.length - 1], format, kwav.data, kwav.header.datasize, kwav.header.rate);
 	AL_ERROR_CHECK(12);
-	free(file.buffer);
-	free(kwav.data);
+	kgfw_memory_free(file.buffer);
+	kgfw_memory_free(kwav.data);
 
 	return 0;
 }
@@ -337,18 +378,16 @@ void kgfw_audio_update(void) {
 }
 
 int kgfw_audio_play_sound(char * name, float x, float y, float z, float gain, float pitch, unsigned char loop, unsigned char relative) {
-	kgfw_hash_t hash = kgfw_hash(name);
-	unsigned long long int bo = 0;
-	for (unsigned long long int i = 0; i < state.buffers.length; ++i) {
-		if (hash == state.buffers.names[i]) {
-			bo = state.buffers.bo[i];
-			goto find_available_source;
-		}
-	}
+	return kgfw_audio_play_sound_hashed(kgfw_hash(name), name, x, y, z, gain, pitch, loop, relative);
+}
 
-	return 1;
+int kgfw_audio_play_sound_hashed(kgfw_hash_t hash, const char * name, float x, float y, float z, float gain, float pitch, unsigned char loop, unsigned char relative) {
+	long long int buffer = buffer_find(hash, name);
+	if (buffer < 0) {
+		return 1;
+	}
+	unsigned long long int bo = state.buffers.bo[buffer];
 
-find_available_source:
 	for (unsigned long long int i = 0; i < SOURCE_NUM; ++i) {
 		if (state.sources.buffers[i] == 0) {
 			state.sources.buffers[i] = bo;
@@ -378,8 +417,12 @@ find_available_source:
 void kgfw_audio_deinit(void) {
 	alSourcePausev(SOURCE_NUM, state.sources.so);
 	alDeleteBuffers(state.buffers.length, state.buffers.bo);
-	free(state.buffers.bo);
-	free(state.buffers.names);
+	kgfw_memory_free(state.buffers.bo);
+	kgfw_memory_free(state.buffers.names);
+	for (unsigned long long int i = 0; state.buffers.strings != NULL && i < state.buffers.length; ++i) {
+		kgfw_memory_free(state.buffers.strings[i]);
+	}
+	kgfw_memory_free(state.buffers.strings);
 	alDeleteSources(SOURCE_NUM, state.sources.so);
 	alcMakeContextCurrent(NULL);
 	alcDestroyContext(state.context);
@@ -2,8 +2,11 @@
 #define KRISVERS_KGFW_AUDIO_H
 
 #include "kgfw_defines.h"
+#include "kgfw_hash.h"
 
 KGFW_PUBLIC int kgfw_audio_play_sound(char * name, float x, float y, float z, float gain, float pitch, unsigned char loop, unsigned char relative);
+/* hash must be kgfw_hash(name), use KGFW_HASH_CHARS for names known at compile time */
+KGFW_PUBLIC int kgfw_audio_play_sound_hashed(kgfw_hash_t hash, const char * name, float x, float y, float z, float gain, float pitch, unsigned char loop, unsigned char relative);
 KGFW_PUBLIC int kgfw_audio_load(char * filename, char * name);
 KGFW_PUBLIC void kgfw_audio_update(void);
 KGFW_PUBLIC int kgfw_audio_init(void);
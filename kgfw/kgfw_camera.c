@@ -9,9 +9,10 @@ void kgfw_camera_perspective(kgfw_camera_t * camera, mat4x4 outm) {
 	}
 
 	if (!camera->tp) {
-		mat4x4_rotate_X(outm, outm, -camera->rot[0] * 3.141592f / 180.0f);
-		mat4x4_rotate_Y(outm, outm, camera->rot[1] * 3.141592f / 180.0f);
-		mat4x4_rotate_Z(outm, outm, -camera->rot[2] * 3.141592f / 180.0f);
+		float rot[3] = { -camera->rot[0], camera->rot[1], -camera->rot[2] };
+		kgfw_mat4_t r;
+		kgfw_mat4_rotation_quat(&r, kgfw_quat_cache_get(&camera->rotation, rot));
+		kgfw_mat4_mul((kgfw_mat4_t *) outm, (kgfw_mat4_t *) outm, &r);
 	}
 }
 
@@ -2,6 +2,7 @@
 #define KRISVERS_KGFW_CAMERA_H
 
 #include "kgfw_defines.h"
+#include "kgfw_math.h"
 #include <linmath.h>
 
 typedef struct kgfw_camera {
@@ -16,6 +17,8 @@ typedef struct kgfw_camera {
 	unsigned char ortho;
 	unsigned char tp;
 	vec3 focus;
+	/* of the negated pitch and roll used by kgfw_camera_perspective */
+	kgfw_quat_cache_t rotation;
 } kgfw_camera_t;
 
 void kgfw_camera_perspective(kgfw_camera_t * camera, mat4x4 outm);
@@ -1,6 +1,8 @@
 #include "kgfw_commands.h"
 #include "kgfw_console.h"
 #include "kgfw_audio.h"
+#include "kgfw_frame.h"
+#include "kgfw_memory.h"
 #include "kgfw_log.h"
 #include <string.h>
 #include <stdlib.h>
@@ -200,7 +202,7 @@ static int exec_command(int argc, char ** argv) {
 
 	unsigned long long int len = strlen(cvar) + 1;
 	unsigned long long int whitespaces = 0;
-	char * cpy = malloc(len + 1);
+	char * cpy = kgfw_frame_alloc(len + 1);
 	if (cpy == NULL) {
 		return 0;
 	}
@@ -213,7 +215,7 @@ static int exec_command(int argc, char ** argv) {
 		}
 	}
 
-	char ** cargv = malloc(whitespaces * sizeof(char *));
+	char ** cargv = kgfw_frame_alloc(whitespaces * sizeof(char *));
 	if (cargv == NULL) {
 		kgfw_log(KGFW_LOG_SEVERITY_ERROR, "buffer allocation error");
 		return 0;
@@ -253,9 +255,57 @@ static int exec_command(int argc, char ** argv) {
 		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no command found \"%s\"", cargv[0]);
 	}
 
-	free(cpy);
-	free(cargv);
+	return 0;
+}
+
+static int mem_command(int argc, char ** argv) {
+	kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "%-10s %14s %14s %12s %10s", "tag", "current", "peak", "allocations", "live");
+	for (unsigned int i = 0; i < KGFW_MEMORY_TAG_COUNT; ++i) {
+		kgfw_memory_stats_t stats;
+		kgfw_memory_stats(i, &stats);
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "%-10s %14llu %14llu %12llu %10llu", kgfw_memory_tag_name(i), stats.current, stats.peak, stats.allocations, stats.live);
+	}
+	return 0;
+}
+
+static int frame_command(int argc, char ** argv) {
+	char * subcommands = "subcommands:    cap    unfocused    ondemand    tick    steps    memory";
+	kgfw_frame_settings_t settings;
+	kgfw_frame_settings_get(&settings);
+	if (argc < 2) {
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "cap %.1f    unfocused %.1f    ondemand %u    tick %.1f    steps %u", settings.cap, settings.cap_unfocused, settings.on_demand, settings.tick_rate, settings.tick_steps_max);
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "%s", subcommands);
+		return 0;
+	}
+
+	if (strcmp("memory", argv[1]) == 0) {
+		kgfw_frame_alloc_stats_t stats;
+		kgfw_frame_alloc_stats(&stats);
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arena %llu    used %llu    high water %llu    overflows %llu", stats.size, stats.used, stats.high_water, stats.overflows);
+		return 0;
+	}
+
+	if (argc < 3) {
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments:    [value]    0 disables");
+		return 0;
+	}
+
+	if (strcmp("cap", argv[1]) == 0) {
+		settings.cap = strtod(argv[2], NULL);
+	} else if (strcmp("unfocused", argv[1]) == 0) {
+		settings.cap_unfocused = strtod(argv[2], NULL);
+	} else if (strcmp("ondemand", argv[1]) == 0) {
+		settings.on_demand = (argv[2][0] == '1');
+	} else if (strcmp("tick", argv[1]) == 0) {
+		settings.tick_rate = strtod(argv[2], NULL);
+	} else if (strcmp("steps", argv[1]) == 0) {
+		settings.tick_steps_max = strtoul(argv[2], NULL, 10);
+	} else {
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "%s", subcommands);
+		return 0;
+	}
 
+	kgfw_frame_settings_set(&settings);
 	return 0;
 }
 
@@ -267,6 +317,8 @@ int kgfw_commands_init(void) {
 	kgfw_console_register_command("new", new_command);
 	kgfw_console_register_command("test", test_command);
 	kgfw_console_register_command("exec", exec_command);
+	kgfw_console_register_command("frame", frame_command);
+	kgfw_console_register_command("mem", mem_command);
 
 	return 0;
 }
@@ -2,6 +2,8 @@
 #include "kgfw_input.h"
 #include "kgfw_log.h"
 #include "kgfw_hash.h"
+#include "kgfw_frame.h"
+#include "kgfw_memory.h"
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
@@ -18,6 +20,7 @@ static char * command_names[COMMAND_NUM];
 static unsigned long long int commands_length = 0;
 
 static kgfw_hash_t console_var_hashes[VAR_NUM];
+static char * console_var_names[VAR_NUM];
 static char * console_vars[VAR_NUM];
 static unsigned long long int console_vars_length = 0;
 
@@ -32,12 +35,13 @@ int kgfw_console_init(void) {
 
 void kgfw_console_deinit(void) {
 	for (unsigned long long int i = 0; i < commands_length; ++i) {
-		free(command_names[i]);
+		kgfw_memory_free(command_names[i]);
 	}
 	for (unsigned long long int i = 0; i < console_vars_length; ++i) {
 		if (console_vars[i] != NULL) {
-			free(console_vars[i]);
+			kgfw_memory_free(console_vars[i]);
 		}
+		kgfw_memory_free(console_var_names[i]);
 	}
 }
 
@@ -47,7 +51,7 @@ int kgfw_console_run(int argc, char ** argv) {
 	}
 	kgfw_hash_t hash = kgfw_hash(argv[0]);
 	for (unsigned long long int i = 0; i < commands_length; ++i) {
-		if (command_hashes[i] == hash) {
+		if (command_hashes[i] == hash && strcmp(command_names[i], argv[0]) == 0) {
 			if (commands[i] != NULL) {
 				commands[i](argc, argv);
 				return 0;
@@ -66,7 +70,7 @@ int kgfw_console_register_command(char * name, kgfw_console_command_callback com
 	commands[commands_length++] = command;
 	command_hashes[commands_length - 1] = kgfw_hash(name);
 	unsigned long long int len = strlen(name);
-	command_names[commands_length - 1] = malloc(len + 1);
+	command_names[commands_length - 1] = kgfw_memory_alloc(len + 1, KGFW_MEMORY_TAG_CONSOLE);
 	if (command_names[commands_length - 1] == NULL) {
 		--commands_length;
 		return 1;
@@ -81,7 +85,7 @@ char * kgfw_console_var(char * name) {
 	kgfw_hash_t hash = kgfw_hash(name);
 
 	for (unsigned long long int i = 0; i < console_vars_length; ++i) {
-		if (console_var_hashes[i] == hash) {
+		if (console_var_hashes[i] == hash && strcmp(console_var_names[i], name) == 0) {
 			return console_vars[i];
 		}
 	}
@@ -94,17 +98,26 @@ int kgfw_console_create_var(char * name, char * value) {
 		return 1;
 	}
 
+	unsigned long long int name_len = strlen(name);
+	char * n = kgfw_memory_alloc(name_len + 1, KGFW_MEMORY_TAG_CONSOLE);
+	if (n == NULL) {
+		return 1;
+	}
+	memcpy(n, name, name_len + 1);
+
 	char * p = NULL;
 	if (value == NULL) {
-		p = malloc(1);
+		p = kgfw_memory_alloc(1, KGFW_MEMORY_TAG_CONSOLE);
 		if (p == NULL) {
+			kgfw_memory_free(n);
 			return 1;
 		}
 		p[0] = '\0';
 	} else {
 		unsigned long long int len = strlen(value);
-		p = malloc(len + 1);
+		p = kgfw_memory_alloc(len + 1, KGFW_MEMORY_TAG_CONSOLE);
 		if (p == NULL) {
+			kgfw_memory_free(n);
 			return 1;
 		}
 
@@ -117,6 +130,7 @@ int kgfw_console_create_var(char * name, char * value) {
 		}
 	}
 
+	console_var_names[console_vars_length] = n;
 	console_vars[console_vars_length++] = p;
 
 	kgfw_hash_t hash = kgfw_hash(name);
@@ -129,16 +143,16 @@ int kgfw_console_set_var(char * name, char * value) {
 	kgfw_hash_t hash = kgfw_hash(name);
 
 	for (unsigned long long int i = 0; i < console_vars_length; ++i) {
-		if (console_var_hashes[i] == hash) {
+		if (console_var_hashes[i] == hash && strcmp(console_var_names[i], name) == 0) {
 			unsigned long long int len = strlen(value);
 			char * p = NULL;
 			if (console_vars[i] == NULL) {
-				p = malloc(len + 1);
+				p = kgfw_memory_alloc(len + 1, KGFW_MEMORY_TAG_CONSOLE);
 				if (p == NULL) {
 					return 1;
 				}
 			} else {
-				p = realloc(console_vars[i], len + 1);
+				p = kgfw_memory_realloc(console_vars[i], len + 1, KGFW_MEMORY_TAG_CONSOLE);
 				if (p == NULL) {
 					return 1;
 				}
@@ -349,7 +363,7 @@ static void console_key_callback(kgfw_input_key_enum key, unsigned char action)
 			return;
 		}
 		state.buffer[state.length - 1] = '\0';
-		char ** argv = malloc(state.whitespaces * sizeof(char *));
+		char ** argv = kgfw_frame_alloc(state.whitespaces * sizeof(char *));
 		if (argv == NULL) {
 			kgfw_log(KGFW_LOG_SEVERITY_ERROR, "buffer allocation error");
 			state.length = 0;
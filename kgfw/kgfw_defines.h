@@ -76,6 +76,21 @@
 #define KGFW_BORLANDC 1
 #endif
 
+#if defined(KGFW_MSVC)
+#define KGFW_ALIGN(n) __declspec(align(n))
+#else
+#define KGFW_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
+/* simd macros */
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define KGFW_SSE 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define KGFW_NEON 1
+#endif
+
 /* dynamic libray macros */
 #if defined(KGFW_DYNAMIC_EXPORT)
 #if defined(KGFW_WINDOWS)
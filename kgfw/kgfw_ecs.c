@@ -1,6 +1,7 @@
 #include "kgfw_ecs.h"
 #include "kgfw_hash.h"
 #include "kgfw_log.h"
+#include "kgfw_memory.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -86,7 +87,7 @@ static void default_system_destroy(struct kgfw_system * self) {
 }
 
 int kgfw_ecs_init(void) {
-	kgfw_system_t * default_system = malloc(sizeof(kgfw_system_t));
+	kgfw_system_t * default_system = kgfw_memory_alloc(sizeof(kgfw_system_t), KGFW_MEMORY_TAG_ECS);
 	if (default_system == NULL) {
 		return 1;
 	}
@@ -97,7 +98,7 @@ int kgfw_ecs_init(void) {
 	default_system->destroy = default_system_destroy;
 
 	if (default_system_construct("default", sizeof(kgfw_system_t), default_system) != 0) {
-		free(default_system);
+		kgfw_memory_free(default_system);
 		return 2;
 	}
 
@@ -122,25 +123,25 @@ void kgfw_ecs_deinit(void) {
 	}
 
 	if (state.component_types.type_ids != NULL) {
-		free(state.component_types.type_ids);
+		kgfw_memory_free(state.component_types.type_ids);
 	}
 	if (state.component_types.system_ids != NULL) {
-		free(state.component_types.system_ids);
+		kgfw_memory_free(state.component_types.system_ids);
 	}
 	if (state.component_types.datas != NULL) {
 		for (unsigned long long int i = 0; i < state.component_types.count; ++i) {
-			free(state.component_types.datas[i]);
+			kgfw_memory_free(state.component_types.datas[i]);
 		}
-		free(state.component_types.datas);
+		kgfw_memory_free(state.component_types.datas);
 	}
 	if (state.component_types.sizes != NULL) {
-		free(state.component_types.sizes);
+		kgfw_memory_free(state.component_types.sizes);
 	}
 	if (state.component_types.names != NULL) {
 		for (unsigned long long int i = 0; i < state.component_types.count; ++i) {
-			free((void *) state.component_types.names[i]);
+			kgfw_memory_free((void *) state.component_types.names[i]);
 		}
-		free(state.component_types.names);
+		kgfw_memory_free(state.component_types.names);
 	}
 	state.component_types.count = 0;
 
@@ -149,22 +150,22 @@ void kgfw_ecs_deinit(void) {
 	}
 
 	if (state.systems.ids != NULL) {
-		free(state.systems.ids);
+		kgfw_memory_free(state.systems.ids);
 	}
 	if (state.systems.datas != NULL) {
 		for (unsigned long long int i = 0; i < state.systems.count; ++i) {
-			free(state.systems.datas[i]);
+			kgfw_memory_free(state.systems.datas[i]);
 		}
-		free(state.systems.datas);
+		kgfw_memory_free(state.systems.datas);
 	}
 	if (state.systems.sizes != NULL) {
-		free(state.systems.sizes);
+		kgfw_memory_free(state.systems.sizes);
 	}
 	if (state.systems.names != NULL) {
 		for (unsigned long long int i = 0; i < state.systems.count; ++i) {
-			free((void *) state.systems.names[i]);
+			kgfw_memory_free((void *) state.systems.names[i]);
 		}
-		free(state.systems.names);
+		kgfw_memory_free(state.systems.names);
 	}
 	state.systems.count = 0;
 }
@@ -183,7 +184,7 @@ void kgfw_ecs_update(void) {
 
 kgfw_entity_t * kgfw_entity_new(const char * name) {
 	kgfw_entity_t * e = NULL;
-	entity_node_t * node = malloc(sizeof(entity_node_t));
+	entity_node_t * node = kgfw_memory_alloc(sizeof(entity_node_t), KGFW_MEMORY_TAG_ECS);
 	if (node == NULL) {
 		return NULL;
 	}
@@ -199,7 +200,7 @@ kgfw_entity_t * kgfw_entity_new(const char * name) {
 
 	e = &node->entity;
 	if (e == NULL) {
-		free(node);
+		kgfw_memory_free(node);
 		return NULL;
 	}
 
@@ -210,22 +211,22 @@ kgfw_entity_t * kgfw_entity_new(const char * name) {
 	if (name == NULL) {
 		unsigned long long int len = snprintf(NULL, 0, "Entity 0x%llx", e->id);
 		if (len < 0) {
-			free(node);
+			kgfw_memory_free(node);
 			return NULL;
 		}
 
-		e->name = malloc(sizeof(char) * (len + 1));
+		e->name = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (e->name == NULL) {
-			free(node);
+			kgfw_memory_free(node);
 			return NULL;
 		}
 		sprintf((char *) e->name, "Entity 0x%llx", e->id);
 		((char *) e->name)[len] = '\0';
 	} else {
 		unsigned long long int len = strlen(name);
-		e->name = malloc(sizeof(char) * (len + 1));
+		e->name = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (e->name == NULL) {
-			free(node);
+			kgfw_memory_free(node);
 			return NULL;
 		}
 		strncpy((char *) e->name, name, len);
@@ -248,10 +249,10 @@ kgfw_entity_t * kgfw_entity_copy(const char * name, kgfw_entity_t * source) {
 
 	e->components.count = source->components.count;
 	if (e->components.count != 0) {
-		e->components.handles = malloc(sizeof(kgfw_component_t *) * e->components.count);
+		e->components.handles = kgfw_memory_alloc(sizeof(kgfw_component_t *) * e->components.count, KGFW_MEMORY_TAG_ECS);
 		if (e->components.handles == NULL) {
-			free((void *) e->name);
-			free(e);
+			kgfw_memory_free((void *) e->name);
+			kgfw_memory_free(e);
 			return NULL;
 		}
 
@@ -277,9 +278,9 @@ void kgfw_entity_destroy(kgfw_entity_t * entity) {
 	}
 
 	if (node->entity.components.handles != NULL) {
-		free(node->entity.components.handles);
+		kgfw_memory_free(node->entity.components.handles);
 	}
-	free(node);
+	kgfw_memory_free(node);
 }
 
 kgfw_entity_t * kgfw_entity_get(kgfw_uuid_t id) {
@@ -307,7 +308,7 @@ kgfw_entity_t * kgfw_entity_get_via_name(const char * name) {
 			return NULL;
 		}
 
-		if (n->hash == hash) {
+		if (n->hash == hash && strcmp(n->entity.name, name) == 0) {
 			return &n->entity;
 		}
 	}
@@ -334,46 +335,42 @@ kgfw_uuid_t kgfw_component_construct(const char * name, unsigned long long int c
 		return 0;
 	}
 
-	kgfw_uuid_t id = 0;
-	while (id == KGFW_ECS_INVALID_ID) {
-		id = kgfw_uuid_gen();
-		kgfw_logf(KGFW_LOG_SEVERITY_DEBUG, "id: 0x%llx", id);
-	}
+	kgfw_uuid_t id = kgfw_uuid_gen();
 
-	void * data = malloc(component_size);
+	void * data = kgfw_memory_alloc(component_size, KGFW_MEMORY_TAG_ECS);
 	if (data == NULL) {
 		return 0;
 	}
 	memcpy(data, component_data, component_size);
-	void ** datas = realloc(state.component_types.datas, sizeof(void *) * (state.component_types.count + 1));
+	void ** datas = kgfw_memory_realloc(state.component_types.datas, sizeof(void *) * (state.component_types.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (datas == NULL) {
 		return 0;
 	}
 	state.component_types.datas = datas;
 	state.component_types.datas[state.component_types.count] = data;
 
-	kgfw_uuid_t * type_ids = realloc(state.component_types.type_ids, sizeof(kgfw_uuid_t) * (state.component_types.count + 1));
+	kgfw_uuid_t * type_ids = kgfw_memory_realloc(state.component_types.type_ids, sizeof(kgfw_uuid_t) * (state.component_types.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (type_ids == NULL) {
 		return 0;
 	}
 	state.component_types.type_ids = type_ids;
 	state.component_types.type_ids[state.component_types.count] = id;
 
-	kgfw_uuid_t * system_ids = realloc(state.component_types.system_ids, sizeof(kgfw_uuid_t) * (state.component_types.count + 1));
+	kgfw_uuid_t * system_ids = kgfw_memory_realloc(state.component_types.system_ids, sizeof(kgfw_uuid_t) * (state.component_types.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (system_ids == NULL) {
 		return 0;
 	}
 	state.component_types.system_ids = system_ids;
 	state.component_types.system_ids[state.component_types.count] = system_id;
 
-	unsigned long long int * sizes = realloc(state.component_types.sizes, sizeof(unsigned long long int) * (state.component_types.count + 1));
+	unsigned long long int * sizes = kgfw_memory_realloc(state.component_types.sizes, sizeof(unsigned long long int) * (state.component_types.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (sizes == NULL) {
 		return 0;
 	}
 	state.component_types.sizes = sizes;
 	state.component_types.sizes[state.component_types.count] = component_size;
 
-	const char ** names = realloc(state.component_types.names, sizeof(const char *) * (state.component_types.count + 1));
+	const char ** names = kgfw_memory_realloc(state.component_types.names, sizeof(const char *) * (state.component_types.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (names == NULL) {
 		return 0;
 	}
@@ -386,7 +383,7 @@ kgfw_uuid_t kgfw_component_construct(const char * name, unsigned long long int c
 			return 0;
 		}
 
-		n = malloc(sizeof(char) * (len + 1));
+		n = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (n == NULL) {
 			return 0;
 		}
@@ -395,7 +392,7 @@ kgfw_uuid_t kgfw_component_construct(const char * name, unsigned long long int c
 	}
 	else {
 		unsigned long long int len = strlen(name);
-		n = malloc(sizeof(char) * (len + 1));
+		n = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (n == NULL) {
 			return 0;
 		}
@@ -404,14 +401,14 @@ kgfw_uuid_t kgfw_component_construct(const char * name, unsigned long long int c
 	}
 	state.component_types.names[state.component_types.count] = n;
 
-	kgfw_hash_t * hashes = realloc(state.component_types.hashes, sizeof(kgfw_hash_t) * (state.component_types.count + 1));
+	kgfw_hash_t * hashes = kgfw_memory_realloc(state.component_types.hashes, sizeof(kgfw_hash_t) * (state.component_types.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (hashes == NULL) {
 		return 0;
 	}
 	state.component_types.hashes = hashes;
 	state.component_types.hashes[state.component_types.count] = kgfw_hash(n);
 
-	component_node_t ** nodes = realloc(state.components, sizeof(component_node_t *) * (state.component_types.count + 1));
+	component_node_t ** nodes = kgfw_memory_realloc(state.components, sizeof(component_node_t *) * (state.component_types.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (sizes == NULL) {
 		return 0;
 	}
@@ -430,15 +427,15 @@ kgfw_component_t * kgfw_entity_attach_component(kgfw_entity_t * entity, kgfw_uui
 
 	for (unsigned long long int i = 0; i < state.component_types.count; ++i) {
 		if (state.component_types.type_ids[i] == type_id) {
-			component_node_t * node = malloc(sizeof(component_node_t));
+			component_node_t * node = kgfw_memory_alloc(sizeof(component_node_t), KGFW_MEMORY_TAG_ECS);
 			if (node == NULL) {
 				return NULL;
 			}
 
 			memset(node, 0, sizeof(component_node_t));
-			node->component = malloc(state.component_types.sizes[i]);
+			node->component = kgfw_memory_alloc(state.component_types.sizes[i], KGFW_MEMORY_TAG_ECS);
 			if (node->component == NULL) {
-				free(node);
+				kgfw_memory_free(node);
 				return NULL;
 			}
 			memcpy(node->component, state.component_types.datas[i], state.component_types.sizes[i]);
@@ -456,7 +453,7 @@ kgfw_component_t * kgfw_entity_attach_component(kgfw_entity_t * entity, kgfw_uui
 			node->component->entity = entity;
 			node->type_index = i;
 
-			kgfw_component_node_t * cnode = malloc(sizeof(kgfw_component_node_t));
+			kgfw_component_node_t * cnode = kgfw_memory_alloc(sizeof(kgfw_component_node_t), KGFW_MEMORY_TAG_ECS);
 			if (cnode == NULL) {
 				return NULL;
 			}
@@ -500,9 +497,9 @@ void kgfw_component_destroy(kgfw_component_t * component) {
 								eprev->next = en->next;
 							}
 
-							free(n->component);
-							free(n);
-							free(en);
+							kgfw_memory_free(n->component);
+							kgfw_memory_free(n);
+							kgfw_memory_free(en);
 							return;
 						}
 						eprev = en;
@@ -525,9 +522,12 @@ const char * kgfw_component_type_get_name(kgfw_uuid_t type_id) {
 }
 
 kgfw_uuid_t kgfw_component_type_get_id(const char * type_name) {
-	kgfw_hash_t hash = kgfw_hash(type_name);
+	return kgfw_component_type_get_id_hashed(kgfw_hash(type_name), type_name);
+}
+
+kgfw_uuid_t kgfw_component_type_get_id_hashed(kgfw_hash_t hash, const char * type_name) {
 	for (unsigned long long int i = 0; i < state.component_types.count; ++i) {
-		if (state.component_types.hashes[i] == hash) {
+		if (state.component_types.hashes[i] == hash && strcmp(state.component_types.names[i], type_name) == 0) {
 			return state.component_types.type_ids[i];
 		}
 	}
@@ -540,38 +540,35 @@ kgfw_uuid_t kgfw_system_construct(const char * name, unsigned long long int syst
 		return 0;
 	}
 
-	kgfw_uuid_t id = 0;
-	while (id == KGFW_ECS_INVALID_ID) {
-		id = kgfw_uuid_gen();
-	}
+	kgfw_uuid_t id = kgfw_uuid_gen();
 
-	kgfw_system_t * data = malloc(system_size);
+	kgfw_system_t * data = kgfw_memory_alloc(system_size, KGFW_MEMORY_TAG_ECS);
 	if (data == NULL) {
 		return 0;
 	}
 	memcpy(data, system_data, system_size);
-	kgfw_system_t ** datas = realloc(state.systems.datas, sizeof(kgfw_system_t *) * (state.systems.count + 1));
+	kgfw_system_t ** datas = kgfw_memory_realloc(state.systems.datas, sizeof(kgfw_system_t *) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (datas == NULL) {
 		return 0;
 	}
 	state.systems.datas = datas;
 	state.systems.datas[state.systems.count] = data;
 
-	kgfw_uuid_t * ids = realloc(state.systems.ids, sizeof(kgfw_uuid_t) * (state.systems.count + 1));
+	kgfw_uuid_t * ids = kgfw_memory_realloc(state.systems.ids, sizeof(kgfw_uuid_t) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (ids == NULL) {
 		return 0;
 	}
 	state.systems.ids = ids;
 	state.systems.ids[state.systems.count] = id;
 
-	unsigned long long int * sizes = realloc(state.systems.sizes, sizeof(unsigned long long int) * (state.systems.count + 1));
+	unsigned long long int * sizes = kgfw_memory_realloc(state.systems.sizes, sizeof(unsigned long long int) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (sizes == NULL) {
 		return 0;
 	}
 	state.systems.sizes = sizes;
 	state.systems.sizes[state.systems.count] = system_size;
 
-	const char ** names = realloc(state.systems.names, sizeof(const char *) * (state.systems.count + 1));
+	const char ** names = kgfw_memory_realloc(state.systems.names, sizeof(const char *) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (names == NULL) {
 		return 0;
 	}
@@ -584,7 +581,7 @@ kgfw_uuid_t kgfw_system_construct(const char * name, unsigned long long int syst
 			return 0;
 		}
 
-		n = malloc(sizeof(char) * (len + 1));
+		n = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (n == NULL) {
 			return 0;
 		}
@@ -593,7 +590,7 @@ kgfw_uuid_t kgfw_system_construct(const char * name, unsigned long long int syst
 	}
 	else {
 		unsigned long long int len = strlen(name);
-		n = malloc(sizeof(char) * (len + 1));
+		n = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (n == NULL) {
 			return 0;
 		}
@@ -602,7 +599,7 @@ kgfw_uuid_t kgfw_system_construct(const char * name, unsigned long long int syst
 	}
 	state.systems.names[state.systems.count] = n;
 
-	kgfw_hash_t * hashes = realloc(state.systems.hashes, sizeof(kgfw_hash_t) * (state.systems.count + 1));
+	kgfw_hash_t * hashes = kgfw_memory_realloc(state.systems.hashes, sizeof(kgfw_hash_t) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (hashes == NULL) {
 		return 0;
 	}
@@ -629,33 +626,33 @@ static int default_system_construct(const char * name, unsigned long long int sy
 
 	kgfw_uuid_t id = 0;
 
-	kgfw_system_t * data = malloc(system_size);
+	kgfw_system_t * data = kgfw_memory_alloc(system_size, KGFW_MEMORY_TAG_ECS);
 	if (data == NULL) {
 		return 2;
 	}
 	memcpy(data, system_data, system_size);
-	kgfw_system_t ** datas = realloc(state.systems.datas, sizeof(kgfw_system_t *) * (state.systems.count + 1));
+	kgfw_system_t ** datas = kgfw_memory_realloc(state.systems.datas, sizeof(kgfw_system_t *) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (datas == NULL) {
 		return 3;
 	}
 	state.systems.datas = datas;
 	state.systems.datas[state.systems.count] = data;
 
-	kgfw_uuid_t * ids = realloc(state.systems.ids, sizeof(kgfw_uuid_t) * (state.systems.count + 1));
+	kgfw_uuid_t * ids = kgfw_memory_realloc(state.systems.ids, sizeof(kgfw_uuid_t) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (ids == NULL) {
 		return 4;
 	}
 	state.systems.ids = ids;
 	state.systems.ids[state.systems.count] = id;
 
-	unsigned long long int * sizes = realloc(state.systems.sizes, sizeof(unsigned long long int) * (state.systems.count + 1));
+	unsigned long long int * sizes = kgfw_memory_realloc(state.systems.sizes, sizeof(unsigned long long int) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (sizes == NULL) {
 		return 5;
 	}
 	state.systems.sizes = sizes;
 	state.systems.sizes[state.systems.count] = system_size;
 
-	const char ** names = realloc(state.systems.names, sizeof(const char *) * (state.systems.count + 1));
+	const char ** names = kgfw_memory_realloc(state.systems.names, sizeof(const char *) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (names == NULL) {
 		return 6;
 	}
@@ -668,7 +665,7 @@ static int default_system_construct(const char * name, unsigned long long int sy
 			return 7;
 		}
 
-		n = malloc(sizeof(char) * (len + 1));
+		n = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (n == NULL) {
 			return 8;
 		}
@@ -677,7 +674,7 @@ static int default_system_construct(const char * name, unsigned long long int sy
 	}
 	else {
 		unsigned long long int len = strlen(name);
-		n = malloc(sizeof(char) * (len + 1));
+		n = kgfw_memory_alloc(sizeof(char) * (len + 1), KGFW_MEMORY_TAG_ECS);
 		if (n == NULL) {
 			return 9;
 		}
@@ -686,7 +683,7 @@ static int default_system_construct(const char * name, unsigned long long int sy
 	}
 	state.systems.names[state.systems.count] = n;
 
-	kgfw_hash_t * hashes = realloc(state.systems.hashes, sizeof(kgfw_hash_t) * (state.systems.count + 1));
+	kgfw_hash_t * hashes = kgfw_memory_realloc(state.systems.hashes, sizeof(kgfw_hash_t) * (state.systems.count + 1), KGFW_MEMORY_TAG_ECS);
 	if (hashes == NULL) {
 		return 10;
 	}
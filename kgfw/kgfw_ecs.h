@@ -74,5 +74,7 @@ KGFW_PUBLIC kgfw_component_t * kgfw_entity_attach_component(kgfw_entity_t * enti
 KGFW_PUBLIC void kgfw_component_destroy(kgfw_component_t * component);
 KGFW_PUBLIC const char * kgfw_component_type_get_name(kgfw_uuid_t type_id);
 KGFW_PUBLIC kgfw_uuid_t kgfw_component_type_get_id(const char * type_name);
+/* hash must be kgfw_hash(type_name), use KGFW_HASH_CHARS for names known at compile time */
+KGFW_PUBLIC kgfw_uuid_t kgfw_component_type_get_id_hashed(kgfw_hash_t hash, const char * type_name);
 
 #endif
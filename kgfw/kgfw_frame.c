@@ -0,0 +1,271 @@
+#include "kgfw_defines.h"
+
+#if (KGFW_OPENGL == 33 || defined(KGFW_VULKAN) || KGFW_DIRECTX == 11)
+
+#include "kgfw_frame.h"
+#include "kgfw_time.h"
+#include "kgfw_ecs.h"
+#include "kgfw_thread.h"
+#include "kgfw_log.h"
+#include "kgfw_memory.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <GLFW/glfw3.h>
+#if (KGFW_DIRECTX == 11)
+#include <windows.h>
+#endif
+
+/* sleeps overshoot by up to a scheduler tick, so the last stretch before a deadline is spun */
+#define KGFW_FRAME_SPIN_SECONDS 0.002
+/* on demand frames still wake this often so timers, audio and gamepads are serviced */
+#define KGFW_FRAME_IDLE_SECONDS 0.25
+
+/* heap fallback blocks are chained through this header and freed when their arena is reset */
+typedef struct frame_overflow {
+	struct frame_overflow * next;
+} frame_overflow_t;
+
+typedef struct frame_arena {
+	unsigned char * memory;
+	unsigned long long int size;
+	unsigned long long int used;
+	frame_overflow_t * overflow;
+} frame_arena_t;
+
+static struct {
+	kgfw_frame_settings_t settings;
+	kgfw_window_t * window;
+	unsigned char redraw;
+	double last;
+	double accumulator;
+
+	struct {
+		kgfw_mutex_t mutex;
+		frame_arena_t arenas[2];
+		unsigned int current;
+		/* bytes requested this frame with their alignment padding, arena and overflow */
+		unsigned long long int requested;
+		unsigned long long int high_water;
+		unsigned long long int overflows;
+	} alloc;
+} state = {
+	KGFW_FRAME_SETTINGS_DEFAULT,
+	NULL,
+	1,
+	0,
+	0,
+};
+
+void kgfw_frame_settings_set(const kgfw_frame_settings_t * settings) {
+	state.settings = *settings;
+	state.redraw = 1;
+}
+
+void kgfw_frame_settings_get(kgfw_frame_settings_t * out_settings) {
+	*out_settings = state.settings;
+}
+
+void kgfw_frame_request_redraw(void) {
+	state.redraw = 1;
+}
+
+void kgfw_frame_set_window(kgfw_window_t * window) {
+	state.window = window;
+	state.redraw = 1;
+}
+
+static unsigned char frame_window_focused(kgfw_window_t * window) {
+	if (window == NULL || window->headless || window->internal == NULL) {
+		return 1;
+	}
+
+	#if (KGFW_DIRECTX == 11)
+	return GetForegroundWindow() == (HWND) window->internal && !IsIconic((HWND) window->internal);
+	#else
+	return glfwGetWindowAttrib(window->internal, GLFW_FOCUSED) && !glfwGetWindowAttrib(window->internal, GLFW_ICONIFIED);
+	#endif
+}
+
+int kgfw_frame_should_draw(void) {
+	if (!state.settings.on_demand) {
+		return 1;
+	}
+
+	int draw = state.redraw;
+	state.redraw = 0;
+	return draw;
+}
+
+void kgfw_frame_wait(void) {
+	unsigned char focused = frame_window_focused(state.window);
+	float cap = state.settings.cap;
+	if (!focused && state.settings.cap_unfocused > 0) {
+		cap = state.settings.cap_unfocused;
+	}
+
+	double now = kgfw_time_seconds();
+	if (cap <= 0 && !state.settings.on_demand) {
+		glfwPollEvents();
+		state.last = now;
+		return;
+	}
+
+	/* a frame that ran long starts the next period from now instead of rushing to catch up */
+	double deadline = (cap > 0) ? state.last + 1.0 / cap : now;
+	if (deadline < now) {
+		deadline = now;
+	}
+	double idle = now + KGFW_FRAME_IDLE_SECONDS;
+
+	/* waiting in the event loop lets input wake an on demand frame early */
+	double until = deadline;
+	while (1) {
+		until = (state.settings.on_demand && !state.redraw && idle > deadline) ? idle : deadline;
+		double remaining = until - kgfw_time_seconds();
+		if (remaining <= KGFW_FRAME_SPIN_SECONDS) {
+			break;
+		}
+		glfwWaitEventsTimeout(remaining - KGFW_FRAME_SPIN_SECONDS);
+	}
+
+	while (kgfw_time_seconds() < until) {
+		continue;
+	}
+
+	glfwPollEvents();
+	state.last = kgfw_time_seconds();
+}
+
+unsigned int kgfw_frame_simulate(void) {
+	double tick = kgfw_frame_tick_delta();
+	state.accumulator += kgfw_time_game_delta();
+
+	unsigned int steps = 0;
+	while (state.accumulator >= tick && steps < state.settings.tick_steps_max) {
+		kgfw_ecs_update();
+		state.accumulator -= tick;
+		++steps;
+	}
+
+	/* keep the phase so alpha stays continuous, but forget the ticks that could not be afforded */
+	if (state.accumulator >= tick) {
+		state.accumulator = fmod(state.accumulator, tick);
+	}
+
+	return steps;
+}
+
+float kgfw_frame_tick_delta(void) {
+	return (state.settings.tick_rate > 0) ? 1.0f / state.settings.tick_rate : 1.0f / 60;
+}
+
+float kgfw_frame_alpha(void) {
+	return (float) (state.accumulator / kgfw_frame_tick_delta());
+}
+
+static void frame_arena_release(frame_arena_t * arena) {
+	while (arena->overflow != NULL) {
+		frame_overflow_t * next = arena->overflow->next;
+		kgfw_memory_free(arena->overflow);
+		arena->overflow = next;
+	}
+	arena->used = 0;
+}
+
+int kgfw_frame_alloc_init(void) {
+	if (kgfw_mutex_init(&state.alloc.mutex) != 0) {
+		return 1;
+	}
+
+	/* arenas are allocated on first use, anything allocated before init went to the heap and is released by the next resets */
+	state.alloc.arenas[0].size = KGFW_FRAME_ALLOC_SIZE;
+	state.alloc.arenas[1].size = KGFW_FRAME_ALLOC_SIZE;
+
+	return 0;
+}
+
+void kgfw_frame_alloc_deinit(void) {
+	for (unsigned int i = 0; i < 2; ++i) {
+		frame_arena_release(&state.alloc.arenas[i]);
+		kgfw_memory_free(state.alloc.arenas[i].memory);
+		state.alloc.arenas[i].memory = NULL;
+	}
+	kgfw_mutex_deinit(&state.alloc.mutex);
+}
+
+void * kgfw_frame_alloc(unsigned long long int size) {
+	return kgfw_frame_alloc_aligned(size, KGFW_FRAME_ALLOC_ALIGNMENT);
+}
+
+void * kgfw_frame_alloc_aligned(unsigned long long int size, unsigned long long int alignment) {
+	void * p = NULL;
+
+	kgfw_mutex_lock(&state.alloc.mutex);
+	frame_arena_t * arena = &state.alloc.arenas[state.alloc.current];
+	if (arena->memory == NULL && arena->size > 0) {
+		arena->memory = kgfw_memory_alloc(arena->size, KGFW_MEMORY_TAG_FRAME);
+		if (arena->memory == NULL) {
+			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "Failed to allocate a %llu byte frame arena, frame allocations will use the heap", arena->size);
+			arena->size = 0;
+		}
+	}
+
+	uintptr_t start = (uintptr_t) arena->memory + arena->used;
+	uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t) (alignment - 1);
+	unsigned long long int offset = arena->used + (aligned - start);
+
+	/* padding counts too, otherwise an arena grown to the high water mark can still overflow */
+	state.alloc.requested += offset + size - arena->used;
+	if (state.alloc.requested > state.alloc.high_water) {
+		state.alloc.high_water = state.alloc.requested;
+	}
+	if (arena->memory != NULL && offset + size <= arena->size) {
+		p = arena->memory + offset;
+		arena->used = offset + size;
+	} else {
+		frame_overflow_t * block = kgfw_memory_alloc(sizeof(frame_overflow_t) + size + alignment, KGFW_MEMORY_TAG_FRAME);
+		if (block != NULL) {
+			block->next = arena->overflow;
+			arena->overflow = block;
+			start = (uintptr_t) (block + 1);
+			p = (void *) ((start + alignment - 1) & ~(uintptr_t) (alignment - 1));
+		}
+		++state.alloc.overflows;
+	}
+	kgfw_mutex_unlock(&state.alloc.mutex);
+
+	return p;
+}
+
+void kgfw_frame_alloc_reset(void) {
+	kgfw_mutex_lock(&state.alloc.mutex);
+	state.alloc.current ^= 1;
+	frame_arena_t * arena = &state.alloc.arenas[state.alloc.current];
+	frame_arena_release(arena);
+
+	/* grow to the next power of two over the worst frame so it fits without touching the heap */
+	if (state.alloc.high_water > arena->size) {
+		unsigned long long int size = KGFW_FRAME_ALLOC_SIZE;
+		while (size < state.alloc.high_water) {
+			size *= 2;
+		}
+		kgfw_memory_free(arena->memory);
+		arena->memory = NULL;
+		arena->size = size;
+	}
+
+	state.alloc.requested = 0;
+	kgfw_mutex_unlock(&state.alloc.mutex);
+}
+
+void kgfw_frame_alloc_stats(kgfw_frame_alloc_stats_t * out_stats) {
+	kgfw_mutex_lock(&state.alloc.mutex);
+	out_stats->size = state.alloc.arenas[state.alloc.current].size;
+	out_stats->used = state.alloc.arenas[state.alloc.current].used;
+	out_stats->high_water = state.alloc.high_water;
+	out_stats->overflows = state.alloc.overflows;
+	kgfw_mutex_unlock(&state.alloc.mutex);
+}
+
+#endif
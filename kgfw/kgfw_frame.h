@@ -0,0 +1,64 @@
+#ifndef KRISVERS_KGFW_FRAME_H
+#define KRISVERS_KGFW_FRAME_H
+
+#include "kgfw_defines.h"
+#include "kgfw_window.h"
+
+typedef struct kgfw_frame_settings {
+	/* frames per second while focused, 0 leaves pacing to vsync */
+	float cap;
+	/* frames per second while unfocused or minimized, 0 uses cap */
+	float cap_unfocused;
+	/* only draw after input, a window or graphics change or kgfw_frame_request_redraw, direct writes to transforms and the camera need the request */
+	unsigned char on_demand;
+	/* simulation ticks per second run by kgfw_frame_simulate */
+	float tick_rate;
+	/* most ticks run in one frame, time beyond that is dropped instead of piling up */
+	unsigned int tick_steps_max;
+} kgfw_frame_settings_t;
+
+#define KGFW_FRAME_SETTINGS_DEFAULT { 0, 15, 0, 60, 5 }
+
+/* starting capacity of each of the two frame arenas, they grow at a frame boundary after a frame overflows */
+#define KGFW_FRAME_ALLOC_SIZE (1024 * 1024)
+#define KGFW_FRAME_ALLOC_ALIGNMENT 16
+
+typedef struct kgfw_frame_alloc_stats {
+	/* capacity of the current arena */
+	unsigned long long int size;
+	/* bytes taken from the current arena this frame */
+	unsigned long long int used;
+	/* most bytes requested in one frame with alignment padding, including ones that overflowed to the heap */
+	unsigned long long int high_water;
+	/* requests that did not fit and fell back to the heap since init */
+	unsigned long long int overflows;
+} kgfw_frame_alloc_stats_t;
+
+KGFW_PUBLIC void kgfw_frame_settings_set(const kgfw_frame_settings_t * settings);
+KGFW_PUBLIC void kgfw_frame_settings_get(kgfw_frame_settings_t * out_settings);
+/* marks the scene as changed, the next on demand frame is drawn */
+KGFW_PUBLIC void kgfw_frame_request_redraw(void);
+/* window whose focus picks between cap and cap_unfocused, frames are paced as focused while it is NULL */
+KGFW_PUBLIC void kgfw_frame_set_window(kgfw_window_t * window);
+/* returns 1 when this loop iteration should draw and consumes the pending redraw */
+KGFW_PUBLIC int kgfw_frame_should_draw(void);
+/* blocks until the next frame is due while handling window events, called by kgfw_update */
+KGFW_PUBLIC void kgfw_frame_wait(void);
+/* runs kgfw_ecs_update once per fixed tick owed by the game clock, returns the number of ticks run */
+KGFW_PUBLIC unsigned int kgfw_frame_simulate(void);
+/* seconds simulated by one tick, use this as the delta inside component and system updates */
+KGFW_PUBLIC float kgfw_frame_tick_delta(void);
+/* fraction of a tick accumulated since the last one, blend the previous and current simulation state by this when rendering */
+KGFW_PUBLIC float kgfw_frame_alpha(void);
+
+KGFW_PUBLIC int kgfw_frame_alloc_init(void);
+KGFW_PUBLIC void kgfw_frame_alloc_deinit(void);
+/* transient memory that stays valid until the end of the next frame and is never freed by the caller, safe to call from any thread */
+KGFW_PUBLIC void * kgfw_frame_alloc(unsigned long long int size);
+/* alignment must be a power of two */
+KGFW_PUBLIC void * kgfw_frame_alloc_aligned(unsigned long long int size, unsigned long long int alignment);
+/* swaps arenas and releases everything allocated two frames ago, called by kgfw_update */
+KGFW_PUBLIC void kgfw_frame_alloc_reset(void);
+KGFW_PUBLIC void kgfw_frame_alloc_stats(kgfw_frame_alloc_stats_t * out_stats);
+
+#endif
@@ -8,9 +8,15 @@
 #include "kgfw_log.h"
 #include "kgfw_time.h"
 #include "kgfw_console.h"
+#include "kgfw_thread.h"
+#include "kgfw_memory.h"
+#include "kgfw_math.h"
+#include "kgfw_frame.h"
+#include "kgfw_mesh.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <linmath.h>
 
 #define GLFW_INCLUDE_VULKAN
@@ -40,6 +46,7 @@ typedef struct mesh_node {
 		float rot[3];
 		float scale[3];
 		unsigned char absolute;
+		kgfw_quat_cache_t rotation;
 	} transform;
 
 	struct {
@@ -63,6 +70,9 @@ typedef struct mesh_node {
 
 		unsigned long long int vbo_size;
 		unsigned long long int ibo_size;
+		VkIndexType index_type;
+		/* serial of the last upload batch that copies into these buffers, they cannot be freed before it completes */
+		unsigned long long int upload;
 	} vk;
 } mesh_node_t;
 
@@ -70,6 +80,34 @@ typedef struct vk_ubo {
 	mat4x4 mvp;
 } vk_ubo_t;
 
+/* staging ring size and the number of upload batches that can be in flight at once */
+#define KGFW_GRAPHICS_VK_STAGING_SIZE (32 * 1024 * 1024)
+#define KGFW_GRAPHICS_VK_UPLOAD_BATCHES 3
+
+#define KGFW_GRAPHICS_VK_PIPELINE_CACHE_PATH "assets/pipeline.cache"
+#define KGFW_GRAPHICS_VK_PIPELINE_CACHE_MAGIC 0x4b504330
+
+/* upper bound on recording jobs */
+#define KGFW_GRAPHICS_VK_RECORD_THREADS_MAX 8
+/* starting draws per frame, each draw owns a slice of the uniform buffer and both double when a frame needs more */
+#define KGFW_GRAPHICS_VK_DRAWS_INITIAL 4096
+
+/* one command buffer worth of pending staging copies, retired when its fence signals */
+typedef struct vk_upload_batch {
+	VkCommandBuffer cmd;
+	VkFence fence;
+	/* ring position released once this batch completes */
+	VkDeviceSize end;
+	unsigned long long int serial;
+	unsigned char submitted;
+	/* dedicated staging buffers for uploads larger than the ring */
+	struct {
+		VkBuffer * buffers;
+		VkDeviceMemory * memories;
+		unsigned int count;
+	} garbage;
+} vk_upload_batch_t;
+
 struct {
 	kgfw_window_t * window;
 	kgfw_camera_t * camera;
@@ -104,6 +142,7 @@ struct {
 		VkBuffer ubo;
 		VkDeviceMemory umem;
 		void * ubomap;
+		unsigned int ubo_stride;
 		VkViewport viewport;
 		VkRect2D scissor;
 		struct {
@@ -118,6 +157,7 @@ struct {
 			VkDescriptorSet desc_set;
 			VkPipelineLayout layout;
 			VkPipeline pipeline;
+			VkPipelineCache cache;
 			VkRenderPass render_pass;
 		} pipeline;
 		struct {
@@ -139,6 +179,35 @@ struct {
 			unsigned int graphics;
 			unsigned int present;
 		} queue_families;
+		struct {
+			VkBuffer buffer;
+			VkDeviceMemory memory;
+			unsigned char * map;
+			/* head and tail are monotonic, the physical offset is (position % KGFW_GRAPHICS_VK_STAGING_SIZE) */
+			VkDeviceSize head;
+			VkDeviceSize tail;
+		} staging;
+		struct {
+			vk_upload_batch_t batches[KGFW_GRAPHICS_VK_UPLOAD_BATCHES];
+			unsigned int current;
+			unsigned int oldest;
+			unsigned char recording;
+			/* serial of the newest batch begun and of the newest batch completed */
+			unsigned long long int serial;
+			unsigned long long int completed;
+		} upload;
+		struct {
+			kgfw_thread_pool_t pool;
+			VkCommandPool pools[KGFW_GRAPHICS_VK_RECORD_THREADS_MAX];
+			VkCommandBuffer buffers[KGFW_GRAPHICS_VK_RECORD_THREADS_MAX];
+			unsigned char failed[KGFW_GRAPHICS_VK_RECORD_THREADS_MAX];
+			unsigned int threads;
+			unsigned int jobs;
+			VkFramebuffer framebuffer;
+			mesh_node_t ** draws;
+			unsigned int draws_count;
+			unsigned int draws_capacity;
+		} record;
 	} vk;
 } static state = {
 	NULL, NULL,
@@ -175,7 +244,7 @@ struct {
 	mat4x4 model;
 	mat4x4 model_r;
 	vec3 pos;
-	vec3 rot;
+	kgfw_quat_t rot;
 	vec3 scale;
 	unsigned int img;
 } static recurse_state = {
@@ -197,9 +266,146 @@ static mesh_node_t * meshes_new(void);
 static void mesh_draw(mesh_node_t * mesh, mat4x4 out_m);
 static void meshes_free_recursive_fchild(mesh_node_t * mesh);
 static void meshes_free_recursive(mesh_node_t * mesh);
+static int draws_grow(void);
 
 static int shaders_load(const char * vpath, const char * fpath, VkShaderModule * out_vertex, VkShaderModule * out_fragment);
 
+/* written in front of the driver's cache data so stale caches from another device or driver are discarded */
+typedef struct vk_pipeline_cache_header {
+	unsigned int magic;
+	unsigned int vendor;
+	unsigned int device;
+	unsigned int driver;
+	unsigned char uuid[VK_UUID_SIZE];
+	unsigned long long int size;
+} vk_pipeline_cache_header_t;
+
+static void pipeline_cache_header(vk_pipeline_cache_header_t * out_header) {
+	VkPhysicalDeviceProperties props;
+	vkGetPhysicalDeviceProperties(state.vk.pdev, &props);
+
+	memset(out_header, 0, sizeof(vk_pipeline_cache_header_t));
+	out_header->magic = KGFW_GRAPHICS_VK_PIPELINE_CACHE_MAGIC;
+	out_header->vendor = props.vendorID;
+	out_header->device = props.deviceID;
+	out_header->driver = props.driverVersion;
+	memcpy(out_header->uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+static int pipeline_cache_load(const char * path) {
+	void * data = NULL;
+	unsigned long long int size = 0;
+
+	FILE * fp = fopen(path, "rb");
+	if (fp != NULL) {
+		vk_pipeline_cache_header_t expected;
+		vk_pipeline_cache_header_t header;
+		pipeline_cache_header(&expected);
+
+		if (fread(&header, sizeof(header), 1, fp) == 1 && memcmp(&header, &expected, offsetof(vk_pipeline_cache_header_t, size)) == 0) {
+			/* the size comes from the file, a truncated or corrupt one must not drive the allocation */
+			long start = ftell(fp);
+			long end = -1;
+			if (start >= 0 && fseek(fp, 0, SEEK_END) == 0) {
+				end = ftell(fp);
+				if (fseek(fp, start, SEEK_SET) != 0) {
+					end = -1;
+				}
+			}
+
+			if (end < start || header.size != (unsigned long long int) (end - start)) {
+				kgfw_logf(KGFW_LOG_SEVERITY_INFO, "Vulkan pipeline cache %s is truncated or corrupt, discarding", path);
+			}
+			else {
+				data = kgfw_memory_alloc(header.size, KGFW_MEMORY_TAG_GRAPHICS);
+				if (data != NULL && fread(data, 1, header.size, fp) == header.size) {
+					size = header.size;
+				}
+				else {
+					kgfw_memory_free(data);
+					data = NULL;
+				}
+			}
+		}
+		else {
+			kgfw_logf(KGFW_LOG_SEVERITY_INFO, "Vulkan pipeline cache %s does not match this device or driver, discarding", path);
+		}
+		fclose(fp);
+	}
+
+	VkPipelineCacheCreateInfo create_info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.initialDataSize = size,
+		.pInitialData = data,
+	};
+
+	VkResult vr = vkCreatePipelineCache(state.vk.dev, &create_info, state.vk.allocator, &state.vk.pipeline.cache);
+	if (vr != VK_SUCCESS && data != NULL) {
+		/* the driver rejected the data, start from an empty cache */
+		create_info.initialDataSize = 0;
+		create_info.pInitialData = NULL;
+		vr = vkCreatePipelineCache(state.vk.dev, &create_info, state.vk.allocator, &state.vk.pipeline.cache);
+	}
+	kgfw_memory_free(data);
+
+	if (vr != VK_SUCCESS) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan pipeline cache");
+		state.vk.pipeline.cache = VK_NULL_HANDLE;
+		return 1;
+	}
+
+	if (size != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "Loaded Vulkan pipeline cache %s (%llu bytes)", path, size);
+	}
+
+	return 0;
+}
+
+static int pipeline_cache_save(const char * path) {
+	if (state.vk.pipeline.cache == VK_NULL_HANDLE) {
+		return 0;
+	}
+
+	size_t size = 0;
+	VK_CHECK_DO_NO_SWAP(vkGetPipelineCacheData(state.vk.dev, state.vk.pipeline.cache, &size, NULL), {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to query Vulkan pipeline cache size");
+		return 1;
+	});
+
+	void * data = kgfw_memory_alloc(size, KGFW_MEMORY_TAG_GRAPHICS);
+	if (data == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
+		return 2;
+	}
+
+	VK_CHECK_DO_NO_SWAP(vkGetPipelineCacheData(state.vk.dev, state.vk.pipeline.cache, &size, data), {
+		kgfw_memory_free(data);
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to read Vulkan pipeline cache");
+		return 1;
+	});
+
+	vk_pipeline_cache_header_t header;
+	pipeline_cache_header(&header);
+	header.size = size;
+
+	FILE * fp = fopen(path, "wb");
+	if (fp == NULL) {
+		kgfw_memory_free(data);
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "Failed to open Vulkan pipeline cache %s for writing", path);
+		return 3;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, fp) != 1 || fwrite(data, 1, size, fp) != size) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "Failed to write Vulkan pipeline cache %s", path);
+	}
+
+	fclose(fp);
+	kgfw_memory_free(data);
+	return 0;
+}
+
 static int pipeline_create(void) {
 	VkViewport viewport = {
 		.x = 0,
@@ -397,7 +603,7 @@ static int pipeline_create(void) {
 		.basePipelineIndex = -1,
 	};
 
-	VK_CHECK_DO_NO_SWAP(vkCreateGraphicsPipelines(state.vk.dev, VK_NULL_HANDLE, 1, &pcreate_info, state.vk.allocator, &state.vk.pipeline.pipeline), {
+	VK_CHECK_DO_NO_SWAP(vkCreateGraphicsPipelines(state.vk.dev, state.vk.pipeline.cache, 1, &pcreate_info, state.vk.allocator, &state.vk.pipeline.pipeline), {
 		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan graphics pipeline");
 		return 10;
 	});
@@ -434,7 +640,7 @@ static int buffer_create(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPr
 	vkGetPhysicalDeviceMemoryProperties(state.vk.pdev, &props);
 	unsigned int index = 0;
 	for (index = 0; index < props.memoryTypeCount; ++index) {
-		if ((reqs.memoryTypeBits & (1 << index)) && (props.memoryTypes[index].propertyFlags & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) == (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+		if ((reqs.memoryTypeBits & (1 << index)) && (props.memoryTypes[index].propertyFlags & properties) == properties) {
 			goto found;
 		}
 	}
@@ -468,20 +674,103 @@ static void buffer_destroy(VkBuffer * buffer, VkDeviceMemory * memory) {
 	vkFreeMemory(state.vk.dev, *memory, state.vk.allocator);
 }
 
-static int buffer_copy(VkBuffer dst, VkBuffer src, VkDeviceSize size, VkDeviceSize offset) {
-	VkCommandBufferAllocateInfo alloc_info = {
-		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+/* only called before the frame's draws are recorded and after its fence, so nothing in flight reads the old uniform buffer */
+static int draws_grow(void) {
+	unsigned int capacity = (state.vk.record.draws_capacity == 0) ? KGFW_GRAPHICS_VK_DRAWS_INITIAL : state.vk.record.draws_capacity * 2;
+	mesh_node_t ** draws = kgfw_memory_realloc(state.vk.record.draws, sizeof(mesh_node_t *) * capacity, KGFW_MEMORY_TAG_GRAPHICS);
+	if (draws == NULL) {
+		return 1;
+	}
+	state.vk.record.draws = draws;
+
+	VkBuffer ubo = VK_NULL_HANDLE;
+	VkDeviceMemory umem = VK_NULL_HANDLE;
+	void * ubomap = NULL;
+	if (buffer_create((VkDeviceSize) state.vk.ubo_stride * capacity, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ubo, &umem) != 0) {
+		return 2;
+	}
+
+	VK_CHECK_DO_NO_SWAP(vkMapMemory(state.vk.dev, umem, 0, (VkDeviceSize) state.vk.ubo_stride * capacity, 0, &ubomap), {
+		buffer_destroy(&ubo, &umem);
+		return 3;
+	});
+
+	if (state.vk.ubomap != NULL) {
+		memcpy(ubomap, state.vk.ubomap, (unsigned long long int) state.vk.ubo_stride * state.vk.record.draws_count);
+		buffer_destroy(&state.vk.ubo, &state.vk.umem);
+	}
+	state.vk.ubo = ubo;
+	state.vk.umem = umem;
+	state.vk.ubomap = ubomap;
+	state.vk.record.draws_capacity = capacity;
+
+	VkDescriptorBufferInfo buffer_info = {
+		.buffer = state.vk.ubo,
+		.offset = 0,
+		.range = sizeof(vk_ubo_t),
+	};
+
+	VkWriteDescriptorSet write = {
+		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 		.pNext = NULL,
-		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-		.commandPool = state.vk.cmd.pool,
-		.commandBufferCount = 1,
+		.dstSet = state.vk.pipeline.desc_set,
+		.dstBinding = 0,
+		.dstArrayElement = 0,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.pImageInfo = NULL,
+		.pBufferInfo = &buffer_info,
+		.pTexelBufferView = NULL,
 	};
 
-	VkCommandBuffer cmd;
-	VK_CHECK_DO_NO_SWAP(vkAllocateCommandBuffers(state.vk.dev, &alloc_info, &cmd), {
-		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to allocate Vulkan command buffer");
-		return 1;
-	});
+	vkUpdateDescriptorSets(state.vk.dev, 1, &write, 0, NULL);
+	return 0;
+}
+
+static int upload_reclaim(unsigned char wait) {
+	while (1) {
+		vk_upload_batch_t * batch = &state.vk.upload.batches[state.vk.upload.oldest];
+		if (!batch->submitted) {
+			break;
+		}
+
+		if (wait) {
+			VK_CHECK_DO_NO_SWAP(vkWaitForFences(state.vk.dev, 1, &batch->fence, VK_TRUE, UINT64_MAX), {
+				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to wait for Vulkan upload fence");
+				return 1;
+			});
+			wait = 0;
+		}
+		else if (vkGetFenceStatus(state.vk.dev, batch->fence) != VK_SUCCESS) {
+			break;
+		}
+
+		vkResetFences(state.vk.dev, 1, &batch->fence);
+		state.vk.upload.completed = batch->serial;
+		for (unsigned int i = 0; i < batch->garbage.count; ++i) {
+			buffer_destroy(&batch->garbage.buffers[i], &batch->garbage.memories[i]);
+		}
+		batch->garbage.count = 0;
+
+		state.vk.staging.tail = batch->end;
+		batch->submitted = 0;
+		state.vk.upload.oldest = (state.vk.upload.oldest + 1) % KGFW_GRAPHICS_VK_UPLOAD_BATCHES;
+	}
+
+	return 0;
+}
+
+static int upload_begin(void) {
+	if (state.vk.upload.recording) {
+		return 0;
+	}
+
+	vk_upload_batch_t * batch = &state.vk.upload.batches[state.vk.upload.current];
+	while (batch->submitted) {
+		if (upload_reclaim(1) != 0) {
+			return 1;
+		}
+	}
 
 	VkCommandBufferBeginInfo begin_info = {
 		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -490,153 +779,543 @@ static int buffer_copy(VkBuffer dst, VkBuffer src, VkDeviceSize size, VkDeviceSi
 		.pInheritanceInfo = NULL,
 	};
 
-	VK_CHECK_DO_NO_SWAP(vkBeginCommandBuffer(cmd, &begin_info), {
-		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to begin command buffer");
+	VK_CHECK_DO_NO_SWAP(vkBeginCommandBuffer(batch->cmd, &begin_info), {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to begin Vulkan upload command buffer");
 		return 2;
 	});
 
-	VkBufferCopy copy = {
-		.srcOffset = 0,
-		.dstOffset = 0,
-		.size = size,
+	batch->serial = ++state.vk.upload.serial;
+	state.vk.upload.recording = 1;
+	return 0;
+}
+
+static int upload_flush(void) {
+	if (!state.vk.upload.recording) {
+		return 0;
+	}
+
+	vk_upload_batch_t * batch = &state.vk.upload.batches[state.vk.upload.current];
+
+	/* one barrier for the whole batch instead of one per copy */
+	VkMemoryBarrier barrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.pNext = NULL,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
 	};
-	vkCmdCopyBuffer(cmd, src, dst, 1, &copy);
-	vkEndCommandBuffer(cmd);
+	vkCmdPipelineBarrier(batch->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+	VK_CHECK_DO_NO_SWAP(vkEndCommandBuffer(batch->cmd), {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to end Vulkan upload command buffer");
+		return 1;
+	});
 
 	VkSubmitInfo submit_info = {
 		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.pNext = NULL,
 		.commandBufferCount = 1,
-		.pCommandBuffers = &cmd,
+		.pCommandBuffers = &batch->cmd,
 	};
 
-	vkQueueSubmit(state.vk.gfx_queue, 1, &submit_info, VK_NULL_HANDLE);
-	vkQueueWaitIdle(state.vk.gfx_queue);
-	vkFreeCommandBuffers(state.vk.dev, state.vk.cmd.pool, 1, &cmd);
+	VK_CHECK_DO_NO_SWAP(vkQueueSubmit(state.vk.gfx_queue, 1, &submit_info, batch->fence), {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to submit Vulkan upload batch");
+		return 2;
+	});
 
+	batch->end = state.vk.staging.head;
+	batch->submitted = 1;
+	state.vk.upload.recording = 0;
+	state.vk.upload.current = (state.vk.upload.current + 1) % KGFW_GRAPHICS_VK_UPLOAD_BATCHES;
 	return 0;
 }
 
-static int swapchain_create(void) {
-	VK_CHECK_DO_NO_SWAP(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(state.vk.pdev, state.vk.surface, &state.vk.capabilities), return 1);
-	state.vk.extent = state.vk.capabilities.currentExtent;
-
-	{
-		unsigned int image_count = (state.vk.capabilities.minImageCount + 1 > state.vk.capabilities.maxImageCount) ? state.vk.capabilities.maxImageCount : state.vk.capabilities.minImageCount + 1;
-		VkSwapchainCreateInfoKHR create_info = {
-			.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-			.pNext = NULL,
-			.flags = 0,
-			.surface = state.vk.surface,
-			.minImageCount = image_count,
-			.imageFormat = state.vk.surface_fmt.format,
-			.imageColorSpace = state.vk.surface_fmt.colorSpace,
-			.imageExtent = state.vk.extent,
-			.imageArrayLayers = 1,
-			.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-			.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
-			.queueFamilyIndexCount = 0,
-			.pQueueFamilyIndices = NULL,
-			.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR,
-			.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-			.presentMode = state.vk.present_mode,
-			.clipped = VK_FALSE,
-			.oldSwapchain = VK_NULL_HANDLE,
-		};
+/* blocks until the batch with this serial completes, submitting it first if it is still recording */
+static int upload_wait(unsigned long long int serial) {
+	if (serial <= state.vk.upload.completed) {
+		return 0;
+	}
 
-		unsigned int indices[2] = { state.vk.queue_families.graphics, state.vk.queue_families.present };
-		if (state.vk.queue_families.graphics != state.vk.queue_families.present) {
-			create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-			create_info.queueFamilyIndexCount = 2;
-			create_info.pQueueFamilyIndices = indices;
+	if (state.vk.upload.recording && serial == state.vk.upload.serial) {
+		if (upload_flush() != 0) {
+			return 1;
 		}
+	}
 
-		VK_CHECK_DO_NO_SWAP(vkCreateSwapchainKHR(state.vk.dev, &create_info, state.vk.allocator, &state.vk.swapchain), {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan swapchain");
-			return 7;
-		});
+	while (serial > state.vk.upload.completed && state.vk.upload.batches[state.vk.upload.oldest].submitted) {
+		if (upload_reclaim(1) != 0) {
+			return 2;
+		}
 	}
 
-	{
-		VK_CHECK_DO_NO_SWAP(vkGetSwapchainImagesKHR(state.vk.dev, state.vk.swapchain, &state.vk.images.count, NULL), return 8);
+	return 0;
+}
 
-		state.vk.images.images = malloc(state.vk.images.count * sizeof(VkImage));
-		if (state.vk.images.images == NULL) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
-			return 8;
+/* reserves size bytes of staging memory in the current batch, only stalls when the ring is full */
+static int staging_alloc(VkDeviceSize size, VkBuffer * out_buffer, VkDeviceSize * out_offset, void ** out_data) {
+	if (size > KGFW_GRAPHICS_VK_STAGING_SIZE) {
+		if (upload_begin() != 0) {
+			return 1;
 		}
-		VK_CHECK_DO_NO_SWAP(vkGetSwapchainImagesKHR(state.vk.dev, state.vk.swapchain, &state.vk.images.count, state.vk.images.images), return 8);
 
-		state.vk.images.views = malloc(state.vk.images.count * sizeof(VkImageView));
-		if (state.vk.images.views == NULL) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
-			return 8;
+		vk_upload_batch_t * batch = &state.vk.upload.batches[state.vk.upload.current];
+		VkBuffer * buffers = kgfw_memory_realloc(batch->garbage.buffers, (batch->garbage.count + 1) * sizeof(VkBuffer), KGFW_MEMORY_TAG_GRAPHICS);
+		if (buffers == NULL) {
+			return 2;
 		}
+		batch->garbage.buffers = buffers;
+		VkDeviceMemory * memories = kgfw_memory_realloc(batch->garbage.memories, (batch->garbage.count + 1) * sizeof(VkDeviceMemory), KGFW_MEMORY_TAG_GRAPHICS);
+		if (memories == NULL) {
+			return 2;
+		}
+		batch->garbage.memories = memories;
 
-		for (unsigned int i = 0; i < state.vk.images.count; ++i) {
-			VkImageViewCreateInfo create_info = {
-				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-				.pNext = NULL,
-				.flags = 0,
-				.image = state.vk.images.images[i],
-				.viewType = VK_IMAGE_VIEW_TYPE_2D,
-				.format = state.vk.surface_fmt.format,
-				.components = {
-					VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
-				},
-				.subresourceRange = {
-					VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1,
-				},
-			};
-
-			VK_CHECK_DO_NO_SWAP(vkCreateImageView(state.vk.dev, &create_info, state.vk.allocator, &state.vk.images.views[i]), {
-				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan image view");
-				return 8;
-			});
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		if (buffer_create(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &memory) != 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create dedicated Vulkan staging buffer");
+			return 3;
 		}
+
+		VK_CHECK_DO_NO_SWAP(vkMapMemory(state.vk.dev, memory, 0, size, 0, out_data), {
+			buffer_destroy(&buffer, &memory);
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to map dedicated Vulkan staging buffer");
+			return 4;
+		});
+
+		batch->garbage.buffers[batch->garbage.count] = buffer;
+		batch->garbage.memories[batch->garbage.count] = memory;
+		++batch->garbage.count;
+
+		*out_buffer = buffer;
+		*out_offset = 0;
+		return 0;
 	}
 
-	{
-		state.vk.images.framebuffers = malloc(state.vk.images.count * sizeof(VkFramebuffer));
-		if (state.vk.images.framebuffers == NULL) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
-			return 11;
+	while (1) {
+		VkDeviceSize head = (state.vk.staging.head + 15) & ~((VkDeviceSize) 15);
+		VkDeviceSize offset = head % KGFW_GRAPHICS_VK_STAGING_SIZE;
+		if (offset + size > KGFW_GRAPHICS_VK_STAGING_SIZE) {
+			head += KGFW_GRAPHICS_VK_STAGING_SIZE - offset;
+			offset = 0;
 		}
 
-		for (unsigned int i = 0; i < state.vk.images.count; ++i) {
-			VkFramebufferCreateInfo create_info = {
-				.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-				.pNext = NULL,
-				.flags = 0,
-				.renderPass = state.vk.pipeline.render_pass,
-				.attachmentCount = 1,
-				.pAttachments = &state.vk.images.views[i],
-				.width = state.vk.extent.width,
-				.height = state.vk.extent.height,
-				.layers = 1,
-			};
+		if (head + size - state.vk.staging.tail <= KGFW_GRAPHICS_VK_STAGING_SIZE) {
+			if (upload_begin() != 0) {
+				return 1;
+			}
 
-			VK_CHECK_DO_NO_SWAP(vkCreateFramebuffer(state.vk.dev, &create_info, state.vk.allocator, &state.vk.images.framebuffers[i]), {
-				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan framebuffer");
-				return 11;
-			});
+			state.vk.staging.head = head + size;
+			*out_buffer = state.vk.staging.buffer;
+			*out_offset = offset;
+			*out_data = state.vk.staging.map + offset;
+			return 0;
+		}
+
+		VkDeviceSize tail = state.vk.staging.tail;
+		if (upload_reclaim(0) != 0) {
+			return 1;
+		}
+		if (tail != state.vk.staging.tail) {
+			continue;
+		}
+
+		if (upload_flush() != 0) {
+			return 1;
+		}
+
+		if (!state.vk.upload.batches[state.vk.upload.oldest].submitted) {
+			state.vk.staging.tail = state.vk.staging.head;
+			continue;
+		}
+
+		if (upload_reclaim(1) != 0) {
+			return 1;
 		}
 	}
+}
+
+static int upload_buffer(VkBuffer dst, VkDeviceSize dst_offset, const void * data, VkDeviceSize size) {
+	VkBuffer src;
+	VkDeviceSize src_offset;
+	void * map;
+	if (staging_alloc(size, &src, &src_offset, &map) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to allocate Vulkan staging memory");
+		return 1;
+	}
 
+	memcpy(map, data, size);
+
+	VkBufferCopy copy = {
+		.srcOffset = src_offset,
+		.dstOffset = dst_offset,
+		.size = size,
+	};
+	vkCmdCopyBuffer(state.vk.upload.batches[state.vk.upload.current].cmd, src, dst, 1, &copy);
 	return 0;
 }
-static int swapchain_destroy(void) {
-	vkDeviceWaitIdle(state.vk.dev);
 
-	for (unsigned int i = 0; i < state.vk.images.count; ++i) {
-		vkDestroyFramebuffer(state.vk.dev, state.vk.images.framebuffers[i], state.vk.allocator);
-		vkDestroyImageView(state.vk.dev, state.vk.images.views[i], state.vk.allocator);
+static int upload_image(VkImage dst, unsigned int width, unsigned int height, const void * data, VkDeviceSize size) {
+	VkBuffer src;
+	VkDeviceSize src_offset;
+	void * map;
+	if (staging_alloc(size, &src, &src_offset, &map) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to allocate Vulkan staging memory");
+		return 1;
 	}
 
-	free(state.vk.images.framebuffers);
+	memcpy(map, data, size);
+
+	VkCommandBuffer cmd = state.vk.upload.batches[state.vk.upload.current].cmd;
+	VkImageMemoryBarrier barrier = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.pNext = NULL,
+		.srcAccessMask = 0,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = dst,
+		.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+	};
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	vkCmdCopyBufferToImage(cmd, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &(VkBufferImageCopy){
+		.bufferOffset = src_offset,
+		.bufferRowLength = 0,
+		.bufferImageHeight = 0,
+		.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.imageOffset = { 0, 0, 0 },
+		.imageExtent = { width, height, 1 },
+	});
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	return 0;
+}
+
+static int staging_init(void) {
+	if (buffer_create(KGFW_GRAPHICS_VK_STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &state.vk.staging.buffer, &state.vk.staging.memory) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan staging buffer");
+		return 1;
+	}
+
+	VK_CHECK_DO_NO_SWAP(vkMapMemory(state.vk.dev, state.vk.staging.memory, 0, KGFW_GRAPHICS_VK_STAGING_SIZE, 0, (void **) &state.vk.staging.map), {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to map Vulkan staging buffer");
+		return 2;
+	});
+
+	state.vk.staging.head = 0;
+	state.vk.staging.tail = 0;
+
+	VkCommandBufferAllocateInfo alloc_info = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.pNext = NULL,
+		.commandPool = state.vk.cmd.pool,
+		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.commandBufferCount = 1,
+	};
+
+	VkFenceCreateInfo fence_info = {
+		.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+	};
+
+	for (unsigned int i = 0; i < KGFW_GRAPHICS_VK_UPLOAD_BATCHES; ++i) {
+		vk_upload_batch_t * batch = &state.vk.upload.batches[i];
+		VK_CHECK_DO_NO_SWAP(vkAllocateCommandBuffers(state.vk.dev, &alloc_info, &batch->cmd), {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to allocate Vulkan upload command buffer");
+			return 3;
+		});
+
+		VK_CHECK_DO_NO_SWAP(vkCreateFence(state.vk.dev, &fence_info, state.vk.allocator, &batch->fence), {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan upload fence");
+			return 4;
+		});
+
+		batch->end = 0;
+		batch->submitted = 0;
+		batch->garbage.buffers = NULL;
+		batch->garbage.memories = NULL;
+		batch->garbage.count = 0;
+	}
+
+	state.vk.upload.current = 0;
+	state.vk.upload.oldest = 0;
+	state.vk.upload.recording = 0;
+	return 0;
+}
+
+/* expects the device to be idle */
+static void staging_deinit(void) {
+	for (unsigned int i = 0; i < KGFW_GRAPHICS_VK_UPLOAD_BATCHES; ++i) {
+		vk_upload_batch_t * batch = &state.vk.upload.batches[i];
+		for (unsigned int j = 0; j < batch->garbage.count; ++j) {
+			buffer_destroy(&batch->garbage.buffers[j], &batch->garbage.memories[j]);
+		}
+		kgfw_memory_free(batch->garbage.buffers);
+		kgfw_memory_free(batch->garbage.memories);
+		vkDestroyFence(state.vk.dev, batch->fence, state.vk.allocator);
+	}
+
+	vkUnmapMemory(state.vk.dev, state.vk.staging.memory);
+	buffer_destroy(&state.vk.staging.buffer, &state.vk.staging.memory);
+}
+
+/* records draws [index * count / jobs, (index + 1) * count / jobs) into the secondary command buffer of job index */
+static void record_job(void * data, unsigned int index) {
+	unsigned int begin = (unsigned int) ((unsigned long long int) state.vk.record.draws_count * index / state.vk.record.jobs);
+	unsigned int end = (unsigned int) ((unsigned long long int) state.vk.record.draws_count * (index + 1) / state.vk.record.jobs);
+	VkCommandBuffer cmd = state.vk.record.buffers[index];
+
+	state.vk.record.failed[index] = 1;
+	VK_CHECK_DO_NO_SWAP(vkResetCommandPool(state.vk.dev, state.vk.record.pools[index], 0), {
+		return;
+	});
+
+	VkCommandBufferInheritanceInfo inheritance_info = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		.pNext = NULL,
+		.renderPass = state.vk.pipeline.render_pass,
+		.subpass = 0,
+		.framebuffer = state.vk.record.framebuffer,
+		.occlusionQueryEnable = VK_FALSE,
+		.queryFlags = 0,
+		.pipelineStatistics = 0,
+	};
+
+	VkCommandBufferBeginInfo begin_info = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.pNext = NULL,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+		.pInheritanceInfo = &inheritance_info,
+	};
+
+	VK_CHECK_DO_NO_SWAP(vkBeginCommandBuffer(cmd, &begin_info), {
+		return;
+	});
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state.vk.pipeline.pipeline);
+	vkCmdSetViewport(cmd, 0, 1, &state.vk.viewport);
+	vkCmdSetScissor(cmd, 0, 1, &state.vk.scissor);
+
+	for (unsigned int i = begin; i < end; ++i) {
+		mesh_node_t * mesh = state.vk.record.draws[i];
+		unsigned int offset = i * state.vk.ubo_stride;
+		VkDeviceSize voffset = 0;
+
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, state.vk.pipeline.layout, 0, 1, &state.vk.pipeline.desc_set, 1, &offset);
+		vkCmdBindVertexBuffers(cmd, 0, 1, &mesh->vk.vbuf, &voffset);
+		vkCmdBindIndexBuffer(cmd, mesh->vk.ibuf, 0, mesh->vk.index_type);
+		vkCmdDrawIndexed(cmd, mesh->vk.ibo_size, 1, 0, 0, 0);
+	}
+
+	VK_CHECK_DO_NO_SWAP(vkEndCommandBuffer(cmd), {
+		return;
+	});
+
+	state.vk.record.failed[index] = 0;
+}
+
+/* splits the collected draw list over at most threads jobs, returns the number of secondary command buffers recorded */
+static int record_draws(unsigned int threads, VkFramebuffer framebuffer, unsigned int * out_jobs) {
+	unsigned int jobs = threads;
+	if (jobs > state.vk.record.draws_count) {
+		jobs = state.vk.record.draws_count;
+	}
+
+	*out_jobs = jobs;
+	if (jobs == 0) {
+		return 0;
+	}
+
+	state.vk.record.jobs = jobs;
+	state.vk.record.framebuffer = framebuffer;
+	kgfw_thread_pool_run(&state.vk.record.pool, jobs, record_job, NULL);
+
+	for (unsigned int i = 0; i < jobs; ++i) {
+		if (state.vk.record.failed[i]) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to record Vulkan secondary command buffer %u", i);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int record_init(void) {
+	VkCommandPoolCreateInfo create_info = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.pNext = NULL,
+		.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+		.queueFamilyIndex = state.vk.queue_families.graphics,
+	};
+
+	for (unsigned int i = 0; i < KGFW_GRAPHICS_VK_RECORD_THREADS_MAX; ++i) {
+		VK_CHECK_DO_NO_SWAP(vkCreateCommandPool(state.vk.dev, &create_info, state.vk.allocator, &state.vk.record.pools[i]), {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan recording command pool");
+			return 1;
+		});
+
+		VkCommandBufferAllocateInfo alloc_info = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.pNext = NULL,
+			.commandPool = state.vk.record.pools[i],
+			.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+			.commandBufferCount = 1,
+		};
+
+		VK_CHECK_DO_NO_SWAP(vkAllocateCommandBuffers(state.vk.dev, &alloc_info, &state.vk.record.buffers[i]), {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to allocate Vulkan secondary command buffer");
+			return 2;
+		});
+	}
+
+	unsigned int hardware = kgfw_thread_hardware_count();
+	state.vk.record.threads = (hardware > KGFW_GRAPHICS_VK_RECORD_THREADS_MAX) ? KGFW_GRAPHICS_VK_RECORD_THREADS_MAX : hardware;
+	state.vk.record.draws_count = 0;
+
+	/* the calling thread records too, so one less worker than jobs is needed */
+	if (kgfw_thread_pool_init(&state.vk.record.pool, state.vk.record.threads - 1) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan recording threads");
+		return 3;
+	}
+
+	return 0;
+}
+
+static void record_deinit(void) {
+	kgfw_thread_pool_deinit(&state.vk.record.pool);
+	for (unsigned int i = 0; i < KGFW_GRAPHICS_VK_RECORD_THREADS_MAX; ++i) {
+		vkDestroyCommandPool(state.vk.dev, state.vk.record.pools[i], state.vk.allocator);
+	}
+}
+
+static int swapchain_create(void) {
+	VK_CHECK_DO_NO_SWAP(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(state.vk.pdev, state.vk.surface, &state.vk.capabilities), return 1);
+	state.vk.extent = state.vk.capabilities.currentExtent;
+
+	{
+		unsigned int image_count = (state.vk.capabilities.minImageCount + 1 > state.vk.capabilities.maxImageCount) ? state.vk.capabilities.maxImageCount : state.vk.capabilities.minImageCount + 1;
+		VkSwapchainCreateInfoKHR create_info = {
+			.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+			.pNext = NULL,
+			.flags = 0,
+			.surface = state.vk.surface,
+			.minImageCount = image_count,
+			.imageFormat = state.vk.surface_fmt.format,
+			.imageColorSpace = state.vk.surface_fmt.colorSpace,
+			.imageExtent = state.vk.extent,
+			.imageArrayLayers = 1,
+			.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+			.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 0,
+			.pQueueFamilyIndices = NULL,
+			.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR,
+			.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+			.presentMode = state.vk.present_mode,
+			.clipped = VK_FALSE,
+			.oldSwapchain = VK_NULL_HANDLE,
+		};
+
+		unsigned int indices[2] = { state.vk.queue_families.graphics, state.vk.queue_families.present };
+		if (state.vk.queue_families.graphics != state.vk.queue_families.present) {
+			create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+			create_info.queueFamilyIndexCount = 2;
+			create_info.pQueueFamilyIndices = indices;
+		}
+
+		VK_CHECK_DO_NO_SWAP(vkCreateSwapchainKHR(state.vk.dev, &create_info, state.vk.allocator, &state.vk.swapchain), {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan swapchain");
+			return 7;
+		});
+	}
+
+	{
+		VK_CHECK_DO_NO_SWAP(vkGetSwapchainImagesKHR(state.vk.dev, state.vk.swapchain, &state.vk.images.count, NULL), return 8);
+
+		state.vk.images.images = kgfw_memory_alloc(state.vk.images.count * sizeof(VkImage), KGFW_MEMORY_TAG_GRAPHICS);
+		if (state.vk.images.images == NULL) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
+			return 8;
+		}
+		VK_CHECK_DO_NO_SWAP(vkGetSwapchainImagesKHR(state.vk.dev, state.vk.swapchain, &state.vk.images.count, state.vk.images.images), return 8);
+
+		state.vk.images.views = kgfw_memory_alloc(state.vk.images.count * sizeof(VkImageView), KGFW_MEMORY_TAG_GRAPHICS);
+		if (state.vk.images.views == NULL) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
+			return 8;
+		}
+
+		for (unsigned int i = 0; i < state.vk.images.count; ++i) {
+			VkImageViewCreateInfo create_info = {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.pNext = NULL,
+				.flags = 0,
+				.image = state.vk.images.images[i],
+				.viewType = VK_IMAGE_VIEW_TYPE_2D,
+				.format = state.vk.surface_fmt.format,
+				.components = {
+					VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+				},
+				.subresourceRange = {
+					VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1,
+				},
+			};
+
+			VK_CHECK_DO_NO_SWAP(vkCreateImageView(state.vk.dev, &create_info, state.vk.allocator, &state.vk.images.views[i]), {
+				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan image view");
+				return 8;
+			});
+		}
+	}
+
+	{
+		state.vk.images.framebuffers = kgfw_memory_alloc(state.vk.images.count * sizeof(VkFramebuffer), KGFW_MEMORY_TAG_GRAPHICS);
+		if (state.vk.images.framebuffers == NULL) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
+			return 11;
+		}
+
+		for (unsigned int i = 0; i < state.vk.images.count; ++i) {
+			VkFramebufferCreateInfo create_info = {
+				.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+				.pNext = NULL,
+				.flags = 0,
+				.renderPass = state.vk.pipeline.render_pass,
+				.attachmentCount = 1,
+				.pAttachments = &state.vk.images.views[i],
+				.width = state.vk.extent.width,
+				.height = state.vk.extent.height,
+				.layers = 1,
+			};
+
+			VK_CHECK_DO_NO_SWAP(vkCreateFramebuffer(state.vk.dev, &create_info, state.vk.allocator, &state.vk.images.framebuffers[i]), {
+				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan framebuffer");
+				return 11;
+			});
+		}
+	}
+
+	return 0;
+}
+static int swapchain_destroy(void) {
+	vkDeviceWaitIdle(state.vk.dev);
+
+	for (unsigned int i = 0; i < state.vk.images.count; ++i) {
+		vkDestroyFramebuffer(state.vk.dev, state.vk.images.framebuffers[i], state.vk.allocator);
+		vkDestroyImageView(state.vk.dev, state.vk.images.views[i], state.vk.allocator);
+	}
+
+	kgfw_memory_free(state.vk.images.framebuffers);
 	state.vk.images.framebuffers = NULL;
-	free(state.vk.images.images);
+	kgfw_memory_free(state.vk.images.images);
 	state.vk.images.images = NULL;
-	free(state.vk.images.views);
+	kgfw_memory_free(state.vk.images.views);
 	state.vk.images.views = NULL;
 	vkDestroySwapchainKHR(state.vk.dev, state.vk.swapchain, state.vk.allocator);
 	state.vk.swapchain = NULL;
@@ -703,7 +1382,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 			KGFW_VK_EXTEND(KHR_PORTABILITY_ENUMERATION);
 			#endif
 
-			extensions = malloc((extensions_count + extra) * sizeof(char *));
+			extensions = kgfw_memory_alloc((extensions_count + extra) * sizeof(char *), KGFW_MEMORY_TAG_GRAPHICS);
 			if (extensions == NULL) {
 				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 				return 2;
@@ -759,7 +1438,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 			unsigned int layers_count = 0;
 			VK_CALL(vkEnumerateInstanceLayerProperties(&layers_count, NULL));
 
-			VkLayerProperties * layers = malloc(layers_count * sizeof(VkLayerProperties));
+			VkLayerProperties * layers = kgfw_memory_alloc(layers_count * sizeof(VkLayerProperties), KGFW_MEMORY_TAG_GRAPHICS);
 			if (layers == NULL) {
 				goto no_val_layers;
 			}
@@ -782,7 +1461,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 					found = VK_TRUE;
 				}
 			}
-			free(layers);
+			kgfw_memory_free(layers);
 
 			if (!found) {
 				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to find required Vulkan instance layers");
@@ -797,7 +1476,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 			return 1;
 		});
 
-		free(extensions);
+		kgfw_memory_free(extensions);
 	}
 
 	#ifdef KGFW_DEBUG
@@ -834,7 +1513,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 		unsigned int pdev_count = 0;
 		VK_CALL(vkEnumeratePhysicalDevices(state.vk.instance, &pdev_count, NULL));
 
-		VkPhysicalDevice * pdevs = malloc(pdev_count * sizeof(VkPhysicalDevice));
+		VkPhysicalDevice * pdevs = kgfw_memory_alloc(pdev_count * sizeof(VkPhysicalDevice), KGFW_MEMORY_TAG_GRAPHICS);
 		if (pdevs == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 			return 3;
@@ -875,14 +1554,14 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 		}
 
 		state.vk.pdev = pdevs[best];
-		free(pdevs);
+		kgfw_memory_free(pdevs);
 	}
 
 	{
 		unsigned int queue_family_count = 0;
 		vkGetPhysicalDeviceQueueFamilyProperties(state.vk.pdev, &queue_family_count, NULL);
 
-		VkQueueFamilyProperties * queue_families = malloc(queue_family_count * sizeof(VkQueueFamilyProperties));
+		VkQueueFamilyProperties * queue_families = kgfw_memory_alloc(queue_family_count * sizeof(VkQueueFamilyProperties), KGFW_MEMORY_TAG_GRAPHICS);
 		if (queue_families == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 			return 4;
@@ -918,7 +1597,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 			}
 		}
 
-		free(queue_families);
+		kgfw_memory_free(queue_families);
 
 		if (state.vk.queue_families.graphics == UINT32_MAX || state.vk.queue_families.present == UINT32_MAX) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Vulkan families not found");
@@ -933,7 +1612,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 
 			VK_CALL(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(state.vk.pdev, state.vk.surface, &state.vk.capabilities));
 			VK_CALL(vkGetPhysicalDeviceSurfaceFormatsKHR(state.vk.pdev, state.vk.surface, &formats_count, NULL));
-			formats = malloc(formats_count * sizeof(VkSurfaceFormatKHR));
+			formats = kgfw_memory_alloc(formats_count * sizeof(VkSurfaceFormatKHR), KGFW_MEMORY_TAG_GRAPHICS);
 			if (formats == NULL) {
 				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 				return 5;
@@ -942,7 +1621,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 			VK_CALL(vkGetPhysicalDeviceSurfaceFormatsKHR(state.vk.pdev, state.vk.surface, &formats_count, formats));
 
 			VK_CALL(vkGetPhysicalDeviceSurfacePresentModesKHR(state.vk.pdev, state.vk.surface, &modes_count, NULL));
-			modes = malloc(modes_count * sizeof(VkPresentModeKHR));
+			modes = kgfw_memory_alloc(modes_count * sizeof(VkPresentModeKHR), KGFW_MEMORY_TAG_GRAPHICS);
 			if (modes == NULL) {
 				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 				return 5;
@@ -979,8 +1658,8 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 				}
 			}
 
-			free(formats);
-			free(modes);
+			kgfw_memory_free(formats);
+			kgfw_memory_free(modes);
 
 			if (state.vk.capabilities.currentExtent.width != UINT32_MAX) {
 				state.vk.extent = state.vk.capabilities.currentExtent;
@@ -1040,7 +1719,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 		{
 			unsigned int extensions_count = 0;
 			vkEnumerateDeviceExtensionProperties(state.vk.pdev, NULL, &extensions_count, NULL);
-			VkExtensionProperties * extensions = malloc(extensions_count * sizeof(VkExtensionProperties));
+			VkExtensionProperties * extensions = kgfw_memory_alloc(extensions_count * sizeof(VkExtensionProperties), KGFW_MEMORY_TAG_GRAPHICS);
 			if (extensions == NULL) {
 				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 				return 4;
@@ -1078,7 +1757,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 				#endif
 			}
 
-			free(extensions);
+			kgfw_memory_free(extensions);
 
 			if (unfound > 0) {
 				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Required Vulkan physical device extensions not found");
@@ -1170,7 +1849,7 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 	{
 		VkDescriptorSetLayoutBinding layout_binding = {
 			.binding = 0,
-			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 			.descriptorCount = 1,
 			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
 			.pImmutableSamplers = NULL,
@@ -1190,6 +1869,8 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 		});
 	}
 
+	pipeline_cache_load(KGFW_GRAPHICS_VK_PIPELINE_CACHE_PATH);
+
 	{
 		int r = pipeline_create();
 		if (r != 0) {
@@ -1231,6 +1912,14 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to allocate Vulkan command buffer");
 			return 12;
 		});
+
+		if (staging_init() != 0) {
+			return 12;
+		}
+
+		if (record_init() != 0) {
+			return 12;
+		}
 	}
 
 	{
@@ -1298,17 +1987,19 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 		};
 
 		{
-			if (buffer_create(sizeof(vk_ubo_t), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &state.vk.ubo, &state.vk.umem) != 0) {
-				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan uniform buffer");
-				return 15;
+			/* one ubo slot per draw, bound with a dynamic offset */
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(state.vk.pdev, &props);
+			VkDeviceSize align = props.limits.minUniformBufferOffsetAlignment;
+			if (align == 0) {
+				align = 1;
 			}
-
-			vkMapMemory(state.vk.dev, state.vk.umem, 0, sizeof(vk_ubo_t), 0, &state.vk.ubomap);
+			state.vk.ubo_stride = (unsigned int) (((sizeof(vk_ubo_t) + align - 1) / align) * align);
 		}
 
 		{
 			VkDescriptorPoolSize pool_size = {
-				.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				.descriptorCount = 1,
 			};
 
@@ -1341,26 +2032,11 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 				return 16;
 				});
 
-			VkDescriptorBufferInfo buffer_info = {
-				.buffer = state.vk.ubo,
-				.offset = 0,
-				.range = sizeof(vk_ubo_t),
-			};
-
-			VkWriteDescriptorSet write = {
-				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-				.pNext = NULL,
-				.dstSet = state.vk.pipeline.desc_set,
-				.dstBinding = 0,
-				.dstArrayElement = 0,
-				.descriptorCount = 1,
-				.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-				.pImageInfo = NULL,
-				.pBufferInfo = &buffer_info,
-				.pTexelBufferView = NULL,
-			};
-
-			vkUpdateDescriptorSets(state.vk.dev, 1, &write, 0, NULL);
+			/* creates the uniform buffer and points the descriptor set at it */
+			if (draws_grow() != 0) {
+				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan uniform buffer");
+				return 15;
+			}
 		}
 	}
 
@@ -1375,16 +2051,25 @@ void kgfw_graphics_deinit(void) {
 	meshes_free_recursive_fchild(state.mesh_root);
 
 	buffer_destroy(&state.vk.ubo, &state.vk.umem);
+	state.vk.ubomap = NULL;
+	kgfw_memory_free(state.vk.record.draws);
+	state.vk.record.draws = NULL;
+	state.vk.record.draws_capacity = 0;
+	staging_deinit();
 
 	vkDestroyFence(state.vk.dev, state.vk.sync.in_flight, state.vk.allocator);
 	vkDestroySemaphore(state.vk.dev, state.vk.sync.render_finished, state.vk.allocator);
 	vkDestroySemaphore(state.vk.dev, state.vk.sync.image_available, state.vk.allocator);
 
+	record_deinit();
 	vkDestroyCommandPool(state.vk.dev, state.vk.cmd.pool, state.vk.allocator);
 
 	swapchain_destroy();
 	pipeline_destroy();
 
+	pipeline_cache_save(KGFW_GRAPHICS_VK_PIPELINE_CACHE_PATH);
+	vkDestroyPipelineCache(state.vk.dev, state.vk.pipeline.cache, state.vk.allocator);
+
 	vkDestroyDescriptorPool(state.vk.dev, state.vk.pipeline.desc_pool, state.vk.allocator);
 	vkDestroyDescriptorSetLayout(state.vk.dev, state.vk.pipeline.desc_layout, state.vk.allocator);
 
@@ -1434,6 +2119,10 @@ int kgfw_graphics_draw(void) {
 	state.light.pos[1] = cosf(kgfw_time_get() / 6) * 15;
 	state.light.pos[2] = sinf(kgfw_time_get() + 3) * 10;
 
+	if (upload_reclaim(0) != 0) {
+		return 1;
+	}
+
 	VK_CHECK_DO(vkWaitForFences(state.vk.dev, 1, &state.vk.sync.in_flight, VK_TRUE, UINT64_MAX), {
 		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to wait for Vulkan fence");
 		return 1;
@@ -1516,19 +2205,14 @@ int kgfw_graphics_draw(void) {
 		.pClearValues = &color,
 	};
 
-	vkCmdBeginRenderPass(state.vk.cmd.buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(state.vk.cmd.buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state.vk.pipeline.pipeline);
-	vkCmdBindDescriptorSets(state.vk.cmd.buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state.vk.pipeline.layout, 0, 1, &state.vk.pipeline.desc_set, 0, NULL);
-
+	state.vk.record.draws_count = 0;
 	if (state.mesh_root != NULL) {
 		mat4x4_identity(recurse_state.model);
 
 		recurse_state.pos[0] = 0;
 		recurse_state.pos[1] = 0;
 		recurse_state.pos[2] = 0;
-		recurse_state.rot[0] = 0;
-		recurse_state.rot[1] = 0;
-		recurse_state.rot[2] = 0;
+		kgfw_quat_identity(&recurse_state.rot);
 		recurse_state.scale[0] = 1;
 		recurse_state.scale[1] = 1;
 		recurse_state.scale[2] = 1;
@@ -1536,13 +2220,29 @@ int kgfw_graphics_draw(void) {
 		meshes_draw_recursive_fchild(state.mesh_root);
 	}
 
-	vkCmdEndRenderPass(state.vk.cmd.buffer);
-
+	unsigned int jobs = 0;
+	if (record_draws(state.vk.record.threads, state.vk.images.framebuffers[recurse_state.img], &jobs) != 0) {
+		return 1;
+	}
+
+	vkCmdBeginRenderPass(state.vk.cmd.buffer, &begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	if (jobs != 0) {
+		vkCmdExecuteCommands(state.vk.cmd.buffer, jobs, state.vk.record.buffers);
+	}
+
+	vkCmdEndRenderPass(state.vk.cmd.buffer);
+
 	VK_CHECK_DO(vkEndCommandBuffer(state.vk.cmd.buffer), {
 		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to end Vulkan command buffer");
 		return 1;
 	});
 
+	/* uploads recorded since the last frame are submitted ahead of it on the same queue */
+	if (upload_flush() != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to flush Vulkan uploads");
+		return 2;
+	}
+
 	{
 		VkPipelineStageFlags psflags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
@@ -1585,23 +2285,10 @@ int kgfw_graphics_draw(void) {
 }
 
 void kgfw_graphics_mesh_texture(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_t * texture, kgfw_graphics_texture_use_enum use) {
+	kgfw_frame_request_redraw();
 	mesh_node_t * m = (mesh_node_t *) mesh;
 	unsigned long long int size = texture->width * texture->height * 4;
 
-	VkBuffer staging;
-	VkDeviceMemory staging_mem;
-
-	{
-		if (buffer_create(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &staging, &staging_mem) != 0) {
-			return;
-		}
-
-		void * data;
-		vkMapMemory(state.vk.dev, staging_mem, 0, size, 0, &data);
-		memcpy(data, texture->bitmap, size);
-		vkUnmapMemory(state.vk.dev, staging_mem);
-	}
-
 	VkFormat fmt = (texture->fmt == KGFW_GRAPHICS_TEXTURE_FORMAT_RGBA) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_B8G8R8A8_SRGB;
 
 	VkImageCreateInfo create_info = {
@@ -1656,87 +2343,45 @@ found:;
 
 	vkBindImageMemory(state.vk.dev, m->vk.tex, m->vk.tmem, 0);
 
-	{
-		VkCommandBufferAllocateInfo alloc_info = {
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-			.pNext = NULL,
-			.commandPool = state.vk.cmd.pool,
-			.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-			.commandBufferCount = 1,
-		};
-
-		VkCommandBuffer cmd;
-		vkAllocateCommandBuffers(state.vk.dev, &alloc_info, &cmd);
-
-		VkCommandBufferBeginInfo begin_info = {
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-			.pNext = NULL,
-			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-			.pInheritanceInfo = NULL,
-		};
-
-		vkBeginCommandBuffer(cmd, &begin_info);
-
-		{
-			VkImageMemoryBarrier barrier = {
-				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-				.pNext = NULL,
-				.srcAccessMask = 0,
-				.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-				.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-				.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-				.image = m->vk.tex,
-				.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
-			};
-
-			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
-			vkCmdCopyBufferToImage(cmd, staging, m->vk.tex, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &(VkBufferImageCopy){
-				.bufferOffset = 0,
-				.bufferRowLength = 0,
-				.bufferImageHeight = 0,
-				.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
-				.imageOffset = { 0, 0, 0 },
-				.imageExtent = { texture->width, texture->height, 1 },
-			});
+	if (upload_image(m->vk.tex, texture->width, texture->height, texture->bitmap, size) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to upload Vulkan texture image");
+		return;
+	}
+	m->vk.upload = state.vk.upload.serial;
+}
 
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
-		}
+void kgfw_graphics_mesh_texture_detach(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_use_enum use) {
+	kgfw_frame_request_redraw();
+	mesh_node_t * m = (mesh_node_t *) mesh;
 
-		vkEndCommandBuffer(cmd);
+}
 
-		VkSubmitInfo submit_info = {
-			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-			.pNext = NULL,
-			.waitSemaphoreCount = 0,
-			.pWaitSemaphores = NULL,
-			.pWaitDstStageMask = NULL,
-			.commandBufferCount = 1,
-			.pCommandBuffers = &cmd,
-			.signalSemaphoreCount = 0,
-			.pSignalSemaphores = NULL,
-		};
+void kgfw_graphics_mesh_set_lit(kgfw_graphics_mesh_node_t * mesh, unsigned char lit) {
+	return;
+}
 
-		vkQueueSubmit(state.vk.gfx_queue, 1, &submit_info, VK_NULL_HANDLE);
-		vkQueueWaitIdle(state.vk.gfx_queue);
+void kgfw_graphics_mesh_set_static(kgfw_graphics_mesh_node_t * mesh, unsigned char is_static) {
+	return;
+}
 
-		vkFreeCommandBuffers(state.vk.dev, state.vk.cmd.pool, 1, &cmd);
-	}
+void kgfw_graphics_static_invalidate(void) {
+	return;
+}
 
-	buffer_destroy(&staging, &staging_mem);
+int kgfw_graphics_light_new(const kgfw_graphics_light_t * light) {
+	return -1;
 }
 
-void kgfw_graphics_mesh_texture_detach(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_use_enum use) {
-	mesh_node_t * m = (mesh_node_t *) mesh;
+void kgfw_graphics_light_update(int id, const kgfw_graphics_light_t * light) {
+	return;
+}
 
+void kgfw_graphics_light_destroy(int id) {
+	return;
 }
 
 kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh, kgfw_graphics_mesh_node_t * parent) {
+	kgfw_frame_request_redraw();
 	mesh_node_t * node = meshes_new();
 	node->parent = (mesh_node_t *) parent;
 	memcpy(node->transform.pos, mesh->pos, sizeof(vec3));
@@ -1744,54 +2389,36 @@ kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh,
 	memcpy(node->transform.scale, mesh->scale, sizeof(vec3));
 	
 	{
-		VkBuffer staging;
-		VkDeviceMemory staging_mem;
 		node->vk.vbo_size = mesh->vertices_count;
 		node->vk.ibo_size = mesh->indices_count;
 		VkDeviceSize vsize = sizeof(kgfw_graphics_vertex_t) * node->vk.vbo_size;
-		VkDeviceSize isize = sizeof(unsigned int) * node->vk.ibo_size;
-		if (buffer_create(vsize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &staging, &staging_mem) != 0) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan staging buffer");
-			return NULL;
-		}
-
-		void * data;
-		vkMapMemory(state.vk.dev, staging_mem, 0, vsize, 0, &data);
-		memcpy(data, mesh->vertices, vsize);
-		vkUnmapMemory(state.vk.dev, staging_mem);
+		unsigned short int * narrow = kgfw_mesh_indices_narrow(mesh);
+		node->vk.index_type = (narrow == NULL) ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+		VkDeviceSize isize = ((narrow == NULL) ? sizeof(unsigned int) : sizeof(unsigned short int)) * node->vk.ibo_size;
 
 		if (buffer_create(vsize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &node->vk.vbuf, &node->vk.vmem) != 0) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan vertex buffer");
 			return NULL;
 		}
 
-		if (buffer_copy(node->vk.vbuf, staging, vsize, 0) != 0) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to copy Vulkan staging buffer to mesh buffer");
-			return NULL;
-		}
-
-		buffer_destroy(&staging, &staging_mem);
-
-		if (buffer_create(isize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &staging, &staging_mem) != 0) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan staging buffer");
+		if (upload_buffer(node->vk.vbuf, 0, mesh->vertices, vsize) != 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to upload Vulkan vertex buffer");
 			return NULL;
 		}
 
-		vkMapMemory(state.vk.dev, staging_mem, 0, isize, 0, &data);
-		memcpy(data, mesh->indices, isize);
-		vkUnmapMemory(state.vk.dev, staging_mem);
-
 		if (buffer_create(isize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &node->vk.ibuf, &node->vk.imem) != 0) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan vertex buffer");
+			kgfw_memory_free(narrow);
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to create Vulkan index buffer");
 			return NULL;
 		}
 
-		if (buffer_copy(node->vk.ibuf, staging, isize, 0) != 0) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to copy Vulkan staging buffer to index buffer");
+		int r = upload_buffer(node->vk.ibuf, 0, (narrow == NULL) ? (void *) mesh->indices : (void *) narrow, isize);
+		kgfw_memory_free(narrow);
+		if (r != 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to upload Vulkan index buffer");
 			return NULL;
 		}
-
-		buffer_destroy(&staging, &staging_mem);
+		node->vk.upload = state.vk.upload.serial;
 	}
 
 	if (parent == NULL) {
@@ -1821,6 +2448,7 @@ kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh,
 }
 
 void kgfw_graphics_mesh_destroy(kgfw_graphics_mesh_node_t * mesh) {
+	kgfw_frame_request_redraw();
 	if (mesh == NULL) {
 		return;
 	}
@@ -1866,12 +2494,20 @@ void kgfw_graphics_viewport(unsigned int width, unsigned int height) {
 	VK_SWAPCHAIN_RESIZE();
 }
 
+void kgfw_graphics_finish(void) {
+	vkDeviceWaitIdle(state.vk.dev);
+}
+
+int kgfw_graphics_read_pixels(void * out_rgba) {
+	return 1;
+}
+
 kgfw_window_t * kgfw_graphics_get_window(void) {
 	return state.window;
 }
 
 static mesh_node_t * meshes_alloc(void) {
-	mesh_node_t * m = malloc(sizeof(mesh_node_t));
+	mesh_node_t * m = kgfw_memory_alloc(sizeof(mesh_node_t), KGFW_MEMORY_TAG_GRAPHICS);
 	if (m == NULL) {
 		return NULL;
 	}
@@ -1888,6 +2524,11 @@ static void meshes_free(mesh_node_t * node) {
 		return;
 	}
 
+	/* a batch that has not completed still copies into these buffers */
+	if (upload_wait(node->vk.upload) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Failed to wait for Vulkan uploads before freeing a mesh");
+	}
+
 	buffer_destroy(&node->vk.vbuf, &node->vk.vmem);
 	buffer_destroy(&node->vk.ibuf, &node->vk.imem);
 	if (node->vk.tex != VK_NULL_HANDLE && node->vk.tmem != VK_NULL_HANDLE) {
@@ -1895,7 +2536,7 @@ static void meshes_free(mesh_node_t * node) {
 		vkFreeMemory(state.vk.dev, node->vk.tmem, state.vk.allocator);
 	}
 
-	free(node);
+	kgfw_memory_free(node);
 }
 
 static mesh_node_t * meshes_new(void) {
@@ -1908,40 +2549,31 @@ static mesh_node_t * meshes_new(void) {
 }
 
 static void mesh_transform(mesh_node_t * mesh, mat4x4 out_m) {
+	float pos[3] = { recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[2] + mesh->transform.pos[2] };
 	if (mesh->transform.absolute) {
-		mat4x4_identity(out_m);
-		mat4x4_translate(out_m, recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[0] + mesh->transform.pos[2]);
 		recurse_state.pos[0] = mesh->transform.pos[0];
 		recurse_state.pos[1] = mesh->transform.pos[1];
 		recurse_state.pos[2] = mesh->transform.pos[2];
-		recurse_state.rot[0] = mesh->transform.rot[0];
-		recurse_state.rot[1] = mesh->transform.rot[1];
-		recurse_state.rot[2] = mesh->transform.rot[2];
+		recurse_state.rot = *kgfw_quat_cache_get(&mesh->transform.rotation, mesh->transform.rot);
 		recurse_state.scale[0] = mesh->transform.scale[0];
 		recurse_state.scale[1] = mesh->transform.scale[1];
 		recurse_state.scale[2] = mesh->transform.scale[2];
 	}
 	else {
-		mat4x4_translate_in_place(out_m, recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[2] + mesh->transform.pos[2]);
 		recurse_state.pos[0] += mesh->transform.pos[0];
 		recurse_state.pos[1] += mesh->transform.pos[1];
 		recurse_state.pos[2] += mesh->transform.pos[2];
-		recurse_state.rot[0] += mesh->transform.rot[0];
-		recurse_state.rot[1] += mesh->transform.rot[1];
-		recurse_state.rot[2] += mesh->transform.rot[2];
+		kgfw_quat_mul(&recurse_state.rot, &recurse_state.rot, kgfw_quat_cache_get(&mesh->transform.rotation, mesh->transform.rot));
 		recurse_state.scale[0] *= mesh->transform.scale[0];
 		recurse_state.scale[1] *= mesh->transform.scale[1];
 		recurse_state.scale[2] *= mesh->transform.scale[2];
 	}
 
-	mat4x4_identity(recurse_state.model_r);
-	mat4x4_rotate_X(out_m, out_m, (recurse_state.rot[0]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Y(out_m, out_m, (recurse_state.rot[1]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Z(out_m, out_m, (recurse_state.rot[2]) * 3.141592f / 180.0f);
-	mat4x4_rotate_X(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[0]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Y(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[1]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Z(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[2]) * 3.141592f / 180.0f);
-	mat4x4_scale_aniso(out_m, out_m, recurse_state.scale[0], recurse_state.scale[1], recurse_state.scale[2]);
+	kgfw_mat4_rotation_quat((kgfw_mat4_t *) recurse_state.model_r, &recurse_state.rot);
+	mat4x4_scale_aniso(out_m, recurse_state.model_r, recurse_state.scale[0], recurse_state.scale[1], recurse_state.scale[2]);
+	out_m[3][0] = pos[0];
+	out_m[3][1] = pos[1];
+	out_m[3][2] = pos[2];
 }
 
 static void mesh_draw(mesh_node_t * mesh, mat4x4 out_m) {
@@ -1952,18 +2584,18 @@ static void mesh_draw(mesh_node_t * mesh, mat4x4 out_m) {
 	mat4x4_identity(out_m);
 	mesh_transform(mesh, out_m);
 
+	/* only collects the draw, recording happens in record_draws */
+	if (state.vk.record.draws_count >= state.vk.record.draws_capacity && draws_grow() != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to grow Vulkan draws, mesh is skipped");
+		return;
+	}
+
 	vk_ubo_t ubo;
 	mat4x4_mul(ubo.mvp, state.vp, out_m);
-	memcpy(state.vk.ubomap, &ubo, sizeof(vk_ubo_t));
 
-	{
-		VkDeviceSize offset = 0;
-		vkCmdBindVertexBuffers(state.vk.cmd.buffer, 0, 1, &mesh->vk.vbuf, &offset);
-		vkCmdBindIndexBuffer(state.vk.cmd.buffer, mesh->vk.ibuf, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdSetViewport(state.vk.cmd.buffer, 0, 1, &state.vk.viewport);
-		vkCmdSetScissor(state.vk.cmd.buffer, 0, 1, &state.vk.scissor);
-		vkCmdDrawIndexed(state.vk.cmd.buffer, mesh->vk.ibo_size, 1, 0, 0, 0);
-	}
+	unsigned int index = state.vk.record.draws_count++;
+	memcpy((unsigned char *) state.vk.ubomap + index * state.vk.ubo_stride, &ubo, sizeof(vk_ubo_t));
+	state.vk.record.draws[index] = mesh;
 }
 
 static void meshes_draw_recursive(mesh_node_t * mesh) {
@@ -1985,10 +2617,10 @@ static void meshes_draw_recursive_fchild(mesh_node_t * mesh) {
 	}
 
 	vec3 pos;
-	vec3 rot;
+	kgfw_quat_t rot;
 	vec3 scale;
 	memcpy(pos, recurse_state.pos, sizeof(pos));
-	memcpy(rot, recurse_state.rot, sizeof(rot));
+	rot = recurse_state.rot;
 	memcpy(scale, recurse_state.scale, sizeof(scale));
 
 	meshes_draw_recursive(mesh);
@@ -1999,7 +2631,7 @@ static void meshes_draw_recursive_fchild(mesh_node_t * mesh) {
 		}
 
 		memcpy(recurse_state.pos, pos, sizeof(pos));
-		memcpy(recurse_state.rot, rot, sizeof(rot));
+		recurse_state.rot = rot;
 		memcpy(recurse_state.scale, scale, sizeof(scale));
 		meshes_draw_recursive(m);
 	}
@@ -2036,6 +2668,7 @@ static void meshes_free_recursive_fchild(mesh_node_t * mesh) {
 }
 
 void kgfw_graphics_settings_set(kgfw_graphics_settings_action_enum action, unsigned int settings) {
+	kgfw_frame_request_redraw();
 	unsigned int change = 0;
 
 	switch (action) {
@@ -2071,7 +2704,7 @@ static void update_settings(unsigned int change) {
 }
 
 static int gfx_command(int argc, char ** argv) {
-	const char * subcommands = "set    enable    disable    reload";
+	const char * subcommands = "set    enable    disable    reload    threads    bench";
 	if (argc < 2) {
 		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "subcommands: %s", subcommands);
 		return 0;
@@ -2128,6 +2761,58 @@ static int gfx_command(int argc, char ** argv) {
 
 		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no option %s", argv[2]);
 	}
+	else if (strcmp("threads", argv[1]) == 0) {
+		if (argc < 3) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "recording with %u threads (max %u)", state.vk.record.threads, KGFW_GRAPHICS_VK_RECORD_THREADS_MAX);
+			return 0;
+		}
+
+		int threads = atoi(argv[2]);
+		if (threads < 1 || threads > KGFW_GRAPHICS_VK_RECORD_THREADS_MAX) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "threads must be between 1 and %u", KGFW_GRAPHICS_VK_RECORD_THREADS_MAX);
+			return 0;
+		}
+
+		state.vk.record.threads = threads;
+	}
+	else if (strcmp("bench", argv[1]) == 0) {
+		const char * arguments = "record [iterations]";
+		if (argc < 3 || strcmp("record", argv[2]) != 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
+			return 0;
+		}
+
+		int iterations = (argc >= 4) ? atoi(argv[3]) : 100;
+		if (iterations < 1) {
+			iterations = 1;
+		}
+
+		if (state.vk.record.draws_count == 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no draws collected, render a frame first");
+			return 0;
+		}
+
+		/* the secondary buffers may still be in use by the last frame */
+		vkDeviceWaitIdle(state.vk.dev);
+
+		/* more jobs than the pool has threads only splits the same work further */
+		double base = 0;
+		for (unsigned int threads = 1; threads <= state.vk.record.pool.threads_count + 1; ++threads) {
+			unsigned int jobs = 0;
+			double start = kgfw_time_seconds();
+			for (int i = 0; i < iterations; ++i) {
+				if (record_draws(threads, state.vk.images.framebuffers[recurse_state.img], &jobs) != 0) {
+					return 0;
+				}
+			}
+			double ms = (kgfw_time_seconds() - start) * 1000.0 / iterations;
+			if (threads == 1) {
+				base = ms;
+			}
+
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "%u threads: %.4f ms per frame (%u draws, %.2fx)", threads, ms, state.vk.record.draws_count, (ms > 0) ? base / ms : 0.0);
+		}
+	}
 	else if (strcmp("options", argv[1]) == 0) {
 		const char * options = "vsync    shaders";
 		const char * arguments = "[option]    see 'gfx options'";
@@ -2160,7 +2845,7 @@ static int shaders_load(const char * vpath, const char * fpath, VkShaderModule *
 		vlen = ftell(fp);
 		fseek(fp, 0, SEEK_SET);
 
-		vshader = malloc(vlen);
+		vshader = kgfw_memory_alloc(vlen, KGFW_MEMORY_TAG_GRAPHICS);
 		if (vshader == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 			return 1;
@@ -2182,7 +2867,7 @@ static int shaders_load(const char * vpath, const char * fpath, VkShaderModule *
 		flen = ftell(fp);
 		fseek(fp, 0, SEEK_SET);
 
-		fshader = malloc(flen);
+		fshader = kgfw_memory_alloc(flen, KGFW_MEMORY_TAG_GRAPHICS);
 		if (fshader == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
 			return 1;
@@ -2231,9 +2916,15 @@ static int shaders_load(const char * vpath, const char * fpath, VkShaderModule *
 #include "kgfw_log.h"
 #include "kgfw_time.h"
 #include "kgfw_console.h"
+#include "kgfw_hash.h"
+#include "kgfw_memory.h"
+#include "kgfw_math.h"
+#include "kgfw_frame.h"
+#include "kgfw_mesh.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <float.h>
 #include <linmath.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -2254,12 +2945,143 @@ static int shaders_load(const char * vpath, const char * fpath, VkShaderModule *
 #define GL_CALL(statement) statement;
 #endif
 
+/* ARB_get_program_binary is not part of the 3.3 core loader */
+typedef void (APIENTRY * gl_get_program_binary_func)(GLuint program, GLsizei size, GLsizei * length, GLenum * format, void * binary);
+typedef void (APIENTRY * gl_program_binary_func)(GLuint program, GLenum format, const void * binary, GLsizei length);
+typedef void (APIENTRY * gl_program_parameteri_func)(GLuint program, GLenum pname, GLint value);
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#define KGFW_GRAPHICS_GL_PROGRAM_CACHE_FMT "assets/shaders/cache_%016llx.bin"
+#define KGFW_GRAPHICS_GL_PROGRAM_CACHE_MAGIC 0x4b504231
+
+/* shader features, each combination is compiled into its own program the first time a mesh needs it */
+typedef enum gl_variant_feature {
+	GL_VARIANT_TEXTURED = 1,
+	GL_VARIANT_NORMAL_MAPPED = 2,
+	GL_VARIANT_LIT = 4,
+	GL_VARIANT_INSTANCED = 8,
+	GL_VARIANT_DEPTH_ONLY = 16,
+} gl_variant_feature_enum;
+
+#define GL_VARIANT_COUNT 32
+
+static const char * variant_names[GL_VARIANT_DEPTH_ONLY] = {
+	"unlit", "unlit textured", "unlit normal mapped", "unlit textured normal mapped",
+	"lit", "lit textured", "lit normal mapped", "lit textured normal mapped",
+	"unlit instanced", "unlit textured instanced", "unlit normal mapped instanced", "unlit textured normal mapped instanced",
+	"lit instanced", "lit textured instanced", "lit normal mapped instanced", "lit textured normal mapped instanced",
+};
+
+typedef struct gl_variant {
+	GLuint program;
+	unsigned char failed;
+	GLint unif_m;
+	GLint unif_vp;
+	GLint unif_time;
+	GLint unif_view_pos;
+	GLint unif_texture_color;
+	GLint unif_texture_normal;
+	GLint unif_v;
+	GLint unif_cluster_viewport;
+	GLint unif_cluster_depth;
+	GLint unif_lights;
+	GLint unif_clusters;
+	GLint unif_light_indices;
+} gl_variant_t;
+
+/* clustered lighting grid over the view frustum, depth slices are spaced exponentially between the near and far plane */
+#define KGFW_GRAPHICS_GL_CLUSTERS_X 16
+#define KGFW_GRAPHICS_GL_CLUSTERS_Y 9
+#define KGFW_GRAPHICS_GL_CLUSTERS_Z 24
+#define KGFW_GRAPHICS_GL_CLUSTERS (KGFW_GRAPHICS_GL_CLUSTERS_X * KGFW_GRAPHICS_GL_CLUSTERS_Y * KGFW_GRAPHICS_GL_CLUSTERS_Z)
+/* light references summed over every cluster, clusters past it lose their remaining lights for the frame */
+#define KGFW_GRAPHICS_GL_CLUSTER_INDICES_MAX (KGFW_GRAPHICS_GL_CLUSTERS * 32)
+/* first of the three texture units holding the light, cluster and light index buffers */
+#define KGFW_GRAPHICS_GL_LIGHTS_UNIT 2
+
+/* visible meshes are queried again every this many frames, hidden meshes every frame */
+#define KGFW_GRAPHICS_GL_OCCLUSION_INTERVAL 4
+/* bounding boxes are grown by this fraction so meshes reappear slightly before they are uncovered */
+#define KGFW_GRAPHICS_GL_OCCLUSION_MARGIN 0.05f
+
+/* projected error in pixels below which a coarser lod is used, coarsening waits until the error is this fraction of it */
+#define KGFW_GRAPHICS_GL_LOD_THRESHOLD 1.0f
+#define KGFW_GRAPHICS_GL_LOD_HYSTERESIS 0.75f
+
+typedef struct gl_mesh_lod {
+	unsigned long long int offset;
+	unsigned long long int count;
+	float error;
+} gl_mesh_lod_t;
+
+/* gpu timestamps are read back this many frames late so the cpu never waits on them */
+#define KGFW_GRAPHICS_GL_PROFILE_FRAMES 4
+#define KGFW_GRAPHICS_GL_PROFILE_SCOPES 256
+#define KGFW_GRAPHICS_GL_PROFILE_STATS 32
+#define KGFW_GRAPHICS_GL_PROFILE_TRACE_EVENTS 8192
+
+typedef struct gl_profile_frame {
+	GLuint queries[KGFW_GRAPHICS_GL_PROFILE_SCOPES * 2];
+	const char * names[KGFW_GRAPHICS_GL_PROFILE_SCOPES];
+	unsigned char depths[KGFW_GRAPHICS_GL_PROFILE_SCOPES];
+	unsigned int count;
+	/* query issued last this frame, scopes can end out of order so it is not always the final one */
+	unsigned int last;
+	unsigned long long int index;
+	unsigned char pending;
+} gl_profile_frame_t;
+
+typedef struct gl_profile_stat {
+	const char * name;
+	unsigned long long int calls;
+	double last_ms;
+	double average_ms;
+	double max_ms;
+} gl_profile_stat_t;
+
+typedef struct gl_profile_event {
+	const char * name;
+	unsigned long long int frame;
+	unsigned long long int start_ns;
+	unsigned long long int duration_ns;
+	unsigned char depth;
+} gl_profile_event_t;
+
+/* a queued draw, the queue is sorted and submitted once the scene graph has been walked */
+typedef struct gl_draw {
+	struct mesh_node * mesh;
+	/* NULL for meshes with their own program */
+	gl_variant_t * variant;
+	unsigned int features;
+	unsigned int order;
+	unsigned char blended;
+	float depth;
+	mat4x4 model;
+} gl_draw_t;
+
+typedef struct gl_program_cache_header {
+	unsigned int magic;
+	GLenum format;
+	unsigned long long int key;
+	unsigned long long int length;
+} gl_program_cache_header_t;
+
 typedef struct mesh_node {
 	struct {
 		float pos[3];
 		float rot[3];
 		float scale[3];
 		unsigned char absolute;
+		kgfw_quat_cache_t rotation;
 	} transform;
 
 	struct {
@@ -2278,11 +3100,42 @@ typedef struct mesh_node {
 		GLuint vbo;
 		GLuint ibo;
 		GLuint program;
+		/* uniform locations of program, looked up again only when program changes */
+		gl_variant_t custom;
 		GLuint tex;
 		GLuint normal;
+		/* descriptors the textures were made from, nodes textured from the same source can share a static batch */
+		kgfw_graphics_texture_t tex_source;
+		kgfw_graphics_texture_t normal_source;
 
 		unsigned long long int vbo_size;
 		unsigned long long int ibo_size;
+		GLenum index_type;
+
+		/* lod 0 is the full mesh, every lod lives in the same index buffer */
+		gl_mesh_lod_t lods[KGFW_GRAPHICS_MESH_LODS_MAX + 1];
+		unsigned int lods_count;
+		unsigned int lod;
+		vec3 center;
+		float radius;
+		/* half size of the bounding box around center */
+		vec3 extent;
+
+		/* occlusion query of the last test, created the first time the node is tested */
+		GLuint query;
+		unsigned char query_pending;
+		unsigned char occluded;
+
+		unsigned char unlit;
+		/* packed meshes without vertex colors read a constant white color */
+		unsigned char constant_color;
+		/* the color texture has partially transparent texels */
+		unsigned char translucent;
+
+		/* static nodes are drawn through batches, source is read again whenever batches are rebuilt */
+		unsigned char is_static;
+		const kgfw_graphics_mesh_t * source;
+		mat4x4 static_model;
 	} gl;
 } mesh_node_t;
 
@@ -2291,7 +3144,6 @@ struct {
 	kgfw_camera_t * camera;
 	GLuint vshader;
 	GLuint fshader;
-	GLuint program;
 	mat4x4 vp;
 
 	mesh_node_t * mesh_root;
@@ -2299,31 +3151,117 @@ struct {
 	unsigned int settings;
 
 	struct {
-		vec3 pos;
-		vec3 color;
-		float ambience;
-		float diffusion;
-		float speculation;
-		float metalic;
-	} light;
+		kgfw_graphics_light_t lights[KGFW_GRAPHICS_LIGHTS_MAX];
+		unsigned char used[KGFW_GRAPHICS_LIGHTS_MAX];
+		/* one past the highest id in use */
+		unsigned int count;
+
+		/* rebuilt every frame by lights_cluster, packed holds the visible lights as position radius, color pairs */
+		float packed[KGFW_GRAPHICS_LIGHTS_MAX * 8];
+		unsigned char ranges[KGFW_GRAPHICS_LIGHTS_MAX][6];
+		unsigned int visible;
+		/* offset, count pairs into indices */
+		unsigned int clusters[KGFW_GRAPHICS_GL_CLUSTERS * 2];
+		unsigned short int indices[KGFW_GRAPHICS_GL_CLUSTER_INDICES_MAX];
+		unsigned int indices_count;
+		/* light references that did not fit in indices this frame */
+		unsigned long long int dropped;
+		mat4x4 v;
+		float viewport[4];
+		float depth_scale;
+		float depth_bias;
+
+		GLuint buffers[3];
+		GLuint textures[3];
+	} lights;
+
+	struct {
+		unsigned char dirty;
+		mesh_node_t ** nodes;
+		unsigned long long int nodes_count;
+		unsigned long long int nodes_capacity;
+		mesh_node_t ** batches;
+		unsigned long long int batches_count;
+	} statics;
+
+	struct {
+		gl_draw_t * draws;
+		unsigned long long int count;
+		unsigned long long int capacity;
+	} queue;
+
+	struct {
+		/* world space frustum planes of the current frame */
+		kgfw_frustum_t frustum;
+		GLuint program;
+		GLint unif_mvp;
+		GLuint vao;
+		GLuint vbo;
+		GLuint ibo;
+		unsigned long long int frame;
+
+		/* counts of the last frame */
+		unsigned int culled;
+		unsigned int occluded;
+		unsigned int queries;
+	} occlusion;
+
+	/* render target of headless windows */
+	struct {
+		GLuint fbo;
+		GLuint color;
+		GLuint depth;
+	} offscreen;
+
+	struct {
+		float threshold;
+		/* pixels per world unit at distance 1 */
+		float projection;
+	} lod;
+
+	struct {
+		unsigned char supported;
+		gl_get_program_binary_func get;
+		gl_program_binary_func load;
+		gl_program_parameteri_func parameteri;
+	} program_binary;
+
+	gl_variant_t variants[GL_VARIANT_COUNT];
+
+	struct {
+		unsigned char enabled;
+		unsigned char initialized;
+		unsigned int depth;
+		unsigned long long int frame;
+		unsigned long long int resolved;
+		unsigned long long int dropped;
+		gl_profile_frame_t frames[KGFW_GRAPHICS_GL_PROFILE_FRAMES];
+		gl_profile_stat_t stats[KGFW_GRAPHICS_GL_PROFILE_STATS];
+		unsigned int stats_count;
+		gl_profile_event_t * trace;
+		unsigned long long int trace_head;
+	} profile;
 } static state = {
 	NULL, NULL,
-	0, 0, 0,
+	0, 0,
 	{ 0 },
 	NULL,
 	KGFW_GRAPHICS_SETTINGS_DEFAULT,
-	{
-		{ 0, 100, 0 },
-		{ 1, 1, 1 },
-		0.0f, 0.5f, 0.25f, 8
-	}
+	{ { { { 0 } } } },
+	{ 0, NULL, 0, 0, NULL, 0 },
+	{ NULL, 0, 0 },
+	{ { { 0 } } },
+	{ 0, 0, 0 },
+	{ KGFW_GRAPHICS_GL_LOD_THRESHOLD, 0 },
+	{ 0 }, { 0 },
+	{ 0 },
 };
 
 struct {
 	mat4x4 model;
 	mat4x4 model_r;
 	vec3 pos;
-	vec3 rot;
+	kgfw_quat_t rot;
 	vec3 scale;
 } static recurse_state = {
 	{
@@ -2346,9 +3284,36 @@ static void meshes_free_recursive_fchild(mesh_node_t * mesh);
 static void meshes_free_recursive(mesh_node_t * mesh);
 static void gl_errors(void);
 
-static int shaders_load(const char * vpath, const char * fpath, GLuint * out_program);
+static int shaders_load(const char * vpath, const char * fpath, const char * defines, GLuint * out_program);
+static void shader_source(GLuint shader, const GLchar * source, const char * defines);
+static gl_variant_t * variant_get(unsigned int features);
+static void variant_locations(gl_variant_t * variant);
+static void variants_clear(void);
+static void program_binary_init(void);
+static void mesh_upload(mesh_node_t * node, const kgfw_graphics_mesh_t * mesh);
+static void statics_collect(mesh_node_t * node, mat4x4 m);
+static void statics_rebuild(void);
+static void statics_draw(void);
+static void statics_clear(void);
+static void draws_flush(void);
+static void occlusion_init(void);
+static void occlusion_deinit(void);
+static void lights_init(void);
+static void lights_deinit(void);
+static void lights_cluster(mat4x4 v, mat4x4 p, GLint viewport[4]);
+static int offscreen_init(unsigned int width, unsigned int height);
+static void offscreen_deinit(void);
+static void profile_init(void);
+static void profile_deinit(void);
+static void profile_frame_begin(void);
+static void profile_frame_end(void);
+static int profile_begin(const char * name);
+static void profile_end(int scope);
+static void profile_reset(void);
+static int profile_trace_export(const char * path);
 
 void kgfw_graphics_settings_set(kgfw_graphics_settings_action_enum action, unsigned int settings) {
+	kgfw_frame_request_redraw();
 	unsigned int change = 0;
 
 	switch (action) {
@@ -2399,10 +3364,20 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 		}
 	}
 
-	state.program = GL_CALL(glCreateProgram());
-	int r = shaders_load("assets/shaders/shader.vert", "assets/shaders/shader.frag", &state.program);
-	if (r != 0) {
-		return r;
+	program_binary_init();
+	profile_init();
+	lights_init();
+	occlusion_init();
+
+	if (window != NULL && window->headless) {
+		if (offscreen_init(window->width, window->height) != 0) {
+			return 3;
+		}
+	}
+
+	/* build the common variant up front so a broken shader is reported at startup */
+	if (variant_get(GL_VARIANT_LIT)->program == 0) {
+		return 2;
 	}
 
 	GL_CALL(glEnable(GL_DEPTH_TEST));
@@ -2421,8 +3396,13 @@ int kgfw_graphics_init(kgfw_window_t * window, kgfw_camera_t * camera) {
 }
 
 int kgfw_graphics_draw(void) {
+	profile_frame_begin();
+	int frame_scope = profile_begin("frame");
+
+	int clear_scope = profile_begin("clear");
 	GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 	GL_CALL(glClearColor(0.086f, 0.082f, 0.090f, 1.0f));
+	profile_end(clear_scope);
 
 	mat4x4 mvp;
 	mat4x4 m;
@@ -2440,26 +3420,48 @@ int kgfw_graphics_draw(void) {
 
 	mat4x4_mul(state.vp, p, v);
 
+	kgfw_frustum_from(&state.occlusion.frustum, (kgfw_mat4_t *) state.vp);
+	state.occlusion.culled = 0;
+	state.occlusion.occluded = 0;
+	state.occlusion.queries = 0;
+	++state.occlusion.frame;
+
+	GLint viewport[4];
+	GL_CALL(glGetIntegerv(GL_VIEWPORT, viewport));
+	state.lod.projection = (state.camera->ortho) ? 0 : viewport[3] / (2 * tanf(state.camera->fov * 3.141592f / 360.0f));
+
+	int lights_scope = profile_begin("lights");
+	lights_cluster(v, p, viewport);
+	profile_end(lights_scope);
+
 	if (state.mesh_root != NULL) {
 		mat4x4_identity(recurse_state.model);
 
 		recurse_state.pos[0] = 0;
 		recurse_state.pos[1] = 0;
 		recurse_state.pos[2] = 0;
-		recurse_state.rot[0] = 0;
-		recurse_state.rot[1] = 0;
-		recurse_state.rot[2] = 0;
+		kgfw_quat_identity(&recurse_state.rot);
 		recurse_state.scale[0] = 1;
 		recurse_state.scale[1] = 1;
 		recurse_state.scale[2] = 1;
 
+		int traverse_scope = profile_begin("traverse");
 		meshes_draw_recursive_fchild(state.mesh_root);
+		if (state.statics.dirty) {
+			statics_rebuild();
+		}
+		statics_draw();
+		profile_end(traverse_scope);
+		draws_flush();
 	}
 
+	profile_end(frame_scope);
+	profile_frame_end();
 	return 0;
 }
 
 void kgfw_graphics_mesh_texture(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_t * texture, kgfw_graphics_texture_use_enum use) {
+	kgfw_frame_request_redraw();
 	mesh_node_t * m = (mesh_node_t *) mesh;
 	GLenum fmt = (texture->fmt == KGFW_GRAPHICS_TEXTURE_FORMAT_RGBA) ? GL_RGBA : GL_BGRA;
 	GLenum filtering = (texture->filtering == KGFW_GRAPHICS_TEXTURE_FILTERING_NEAREST) ? GL_NEAREST : GL_LINEAR;
@@ -2469,9 +3471,11 @@ void kgfw_graphics_mesh_texture(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_
 	GLuint * t = NULL;
 	if (use == KGFW_GRAPHICS_TEXTURE_USE_COLOR) {
 		t = &m->gl.tex;
+		m->gl.tex_source = *texture;
 	}
 	else if (use == KGFW_GRAPHICS_TEXTURE_USE_NORMAL) {
 		t = &m->gl.normal;
+		m->gl.normal_source = *texture;
 	}
 
 	if (*t == 0) {
@@ -2485,127 +3489,528 @@ void kgfw_graphics_mesh_texture(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_
 	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filtering_mipmap));
 	GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture->width, texture->height, 0, GL_BGRA, GL_UNSIGNED_BYTE, texture->bitmap));
 	GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
+	if (use == KGFW_GRAPHICS_TEXTURE_USE_COLOR) {
+		/* fully transparent texels are discarded, only partial coverage needs blending */
+		const unsigned char * texels = texture->bitmap;
+		m->gl.translucent = 0;
+		for (unsigned long long int i = 0; i < texture->width * texture->height; ++i) {
+			if (texels[i * 4 + 3] != 0 && texels[i * 4 + 3] != 255) {
+				m->gl.translucent = 1;
+				break;
+			}
+		}
+	}
+	if (m->gl.is_static) {
+		state.statics.dirty = 1;
+	}
 }
 
 void kgfw_graphics_mesh_texture_detach(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_use_enum use) {
+	kgfw_frame_request_redraw();
 	mesh_node_t * m = (mesh_node_t *) mesh;
 	GLuint * t = NULL;
 	if (use == KGFW_GRAPHICS_TEXTURE_USE_COLOR) {
 		t = &m->gl.tex;
+		memset(&m->gl.tex_source, 0, sizeof(m->gl.tex_source));
 	}
 	else if (use == KGFW_GRAPHICS_TEXTURE_USE_NORMAL) {
 		t = &m->gl.normal;
+		memset(&m->gl.normal_source, 0, sizeof(m->gl.normal_source));
 	}
 
 	if (*t != 0) {
 		GL_CALL(glDeleteTextures(1, t));
 		*t = 0;
 	}
+	if (use == KGFW_GRAPHICS_TEXTURE_USE_COLOR) {
+		m->gl.translucent = 0;
+	}
+	if (m->gl.is_static) {
+		state.statics.dirty = 1;
+	}
 }
 
-kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh, kgfw_graphics_mesh_node_t * parent) {
-	mesh_node_t * node = meshes_new();
-	node->parent = (mesh_node_t *) parent;
-	memcpy(node->transform.pos, mesh->pos, sizeof(vec3));
-	memcpy(node->transform.rot, mesh->rot, sizeof(vec3));
-	memcpy(node->transform.scale, mesh->scale, sizeof(vec3));
-	node->gl.vbo_size = mesh->vertices_count;
-	node->gl.ibo_size = mesh->indices_count;
-	GL_CALL(glBindVertexArray(node->gl.vao));
-	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, node->gl.vbo));
-	GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(kgfw_graphics_vertex_t) * mesh->vertices_count, mesh->vertices, GL_STATIC_DRAW));
-	GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, node->gl.ibo));
-	GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh->indices_count, mesh->indices, GL_STATIC_DRAW));
-
-	GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, x)));
-	GL_CALL(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, r)));
-	GL_CALL(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, nx)));
-	GL_CALL(glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, u)));
-	GL_CALL(glEnableVertexAttribArray(0));
-	GL_CALL(glEnableVertexAttribArray(1));
-	GL_CALL(glEnableVertexAttribArray(2));
-	GL_CALL(glEnableVertexAttribArray(3));
-
-	if (parent == NULL) {
-		if (state.mesh_root == NULL) {
-			state.mesh_root = node;
-		}
-		else {
-			mesh_node_t * n;
-			for (n = state.mesh_root; n->sibling != NULL; n = n->sibling);
-			n->sibling = node;
-			node->prior_sibling = n;
-		}
-		return (kgfw_graphics_mesh_node_t *) node;
+void kgfw_graphics_mesh_set_lit(kgfw_graphics_mesh_node_t * mesh, unsigned char lit) {
+	kgfw_frame_request_redraw();
+	if (mesh == NULL) {
+		return;
 	}
 
-	if (parent->child == NULL) {
-		parent->child = (kgfw_graphics_mesh_node_t *) node;
-	}
-	else {
-		mesh_node_t * n;
-		for (n = (mesh_node_t *) parent->child; n->sibling != NULL; n = n->sibling);
-		n->sibling = node;
-		node->prior_sibling = n;
+	((mesh_node_t *) mesh)->gl.unlit = !lit;
+	if (((mesh_node_t *) mesh)->gl.is_static) {
+		state.statics.dirty = 1;
 	}
-
-	return (kgfw_graphics_mesh_node_t *) node;
 }
 
-void kgfw_graphics_mesh_destroy(kgfw_graphics_mesh_node_t * mesh) {
+void kgfw_graphics_mesh_set_static(kgfw_graphics_mesh_node_t * mesh, unsigned char is_static) {
+	kgfw_frame_request_redraw();
 	if (mesh == NULL) {
 		return;
 	}
 
-	if (mesh->parent != NULL) {
-		mesh->parent->child = mesh->child;
-	}
-	if (mesh->prior_sibling != NULL) {
-		mesh->prior_sibling->sibling = mesh->sibling;
-	}
-	if (mesh->child != NULL) {
-		mesh->child->parent = mesh->parent;
-	}
-	if (mesh->sibling != NULL) {
-		mesh->sibling->prior_sibling = mesh->prior_sibling;
-	}
+	mesh_node_t * m = (mesh_node_t *) mesh;
+	/* custom programs can not be shared so those nodes keep drawing on their own */
+	m->gl.is_static = (is_static && m->gl.program == 0 && m->gl.source != NULL);
+	state.statics.dirty = 1;
+}
 
-	if (state.mesh_root == (mesh_node_t *) mesh) {
-		state.mesh_root = NULL;
+void kgfw_graphics_static_invalidate(void) {
+	kgfw_frame_request_redraw();
+	state.statics.dirty = 1;
+}
+
+int kgfw_graphics_light_new(const kgfw_graphics_light_t * light) {
+	kgfw_frame_request_redraw();
+	if (light == NULL) {
+		return -1;
 	}
 
-	meshes_free((mesh_node_t *) mesh);
-}
+	for (unsigned int i = 0; i < KGFW_GRAPHICS_LIGHTS_MAX; ++i) {
+		if (state.lights.used[i]) {
+			continue;
+		}
 
-void kgfw_graphics_set_window(kgfw_window_t * window) {
-	state.window = window;
-	if (window != NULL) {
-		if (window->internal != NULL) {
-			glfwMakeContextCurrent(window->internal);
+		state.lights.used[i] = 1;
+		state.lights.lights[i] = *light;
+		if (i >= state.lights.count) {
+			state.lights.count = i + 1;
 		}
-		GL_CALL(glViewport(0, 0, window->width * window->content_scale_x, window->height * window->content_scale_y));
+		return (int) i;
 	}
-}
 
-void kgfw_graphics_viewport(unsigned int width, unsigned int height) {
-	GL_CALL(glViewport(0, 0, width * state.window->content_scale_x, height * state.window->content_scale_y));
+	return -1;
 }
 
-kgfw_window_t * kgfw_graphics_get_window(void) {
-	return state.window;
-}
+void kgfw_graphics_light_update(int id, const kgfw_graphics_light_t * light) {
+	kgfw_frame_request_redraw();
+	if (light == NULL || id < 0 || (unsigned int) id >= state.lights.count || !state.lights.used[id]) {
+		return;
+	}
 
-void kgfw_graphics_deinit(void) {
-	meshes_free_recursive_fchild(state.mesh_root);
+	state.lights.lights[id] = *light;
 }
 
-static mesh_node_t * meshes_alloc(void) {
-	mesh_node_t * m = malloc(sizeof(mesh_node_t));
-	if (m == NULL) {
-		return NULL;
+void kgfw_graphics_light_destroy(int id) {
+	kgfw_frame_request_redraw();
+	if (id < 0 || (unsigned int) id >= state.lights.count || !state.lights.used[id]) {
+		return;
 	}
 
-	memset(m, 0, sizeof(*m));
+	state.lights.used[id] = 0;
+	while (state.lights.count > 0 && !state.lights.used[state.lights.count - 1]) {
+		--state.lights.count;
+	}
+}
+
+static void mesh_bounds(const kgfw_graphics_mesh_t * mesh, vec3 out_center, vec3 out_extent, float * out_radius) {
+	vec3 lo = { 0, 0, 0 };
+	vec3 hi = { 0, 0, 0 };
+	for (unsigned long long int i = 0; i < mesh->vertices_count; ++i) {
+		const float * p = &mesh->vertices[i].x;
+		for (unsigned int k = 0; k < 3; ++k) {
+			if (i == 0 || p[k] < lo[k]) {
+				lo[k] = p[k];
+			}
+			if (i == 0 || p[k] > hi[k]) {
+				hi[k] = p[k];
+			}
+		}
+	}
+
+	vec3_add(out_center, lo, hi);
+	vec3_scale(out_center, out_center, 0.5f);
+	vec3_sub(out_extent, hi, lo);
+	vec3_scale(out_extent, out_extent, 0.5f);
+	*out_radius = vec3_len(out_extent);
+}
+
+/* concatenates the mesh indices and its lods, lod offsets are in indices until the index type is known */
+static unsigned int * lods_combine(const kgfw_graphics_mesh_t * mesh, mesh_node_t * node) {
+	node->gl.lods[0].offset = 0;
+	node->gl.lods[0].count = mesh->indices_count;
+	node->gl.lods[0].error = 0;
+	node->gl.lods_count = 1;
+	if (mesh->lods == NULL || mesh->lods_count == 0) {
+		return NULL;
+	}
+
+	unsigned long long int lods_count = (mesh->lods_count > KGFW_GRAPHICS_MESH_LODS_MAX) ? KGFW_GRAPHICS_MESH_LODS_MAX : mesh->lods_count;
+	unsigned long long int total = mesh->indices_count;
+	for (unsigned long long int i = 0; i < lods_count; ++i) {
+		total += mesh->lods[i].indices_count;
+	}
+
+	unsigned int * indices = kgfw_memory_alloc(sizeof(unsigned int) * total, KGFW_MEMORY_TAG_GRAPHICS);
+	if (indices == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to allocate mesh lod indices, lods are ignored");
+		return NULL;
+	}
+
+	memcpy(indices, mesh->indices, sizeof(unsigned int) * mesh->indices_count);
+	unsigned long long int offset = mesh->indices_count;
+	for (unsigned long long int i = 0; i < lods_count; ++i) {
+		memcpy(indices + offset, mesh->lods[i].indices, sizeof(unsigned int) * mesh->lods[i].indices_count);
+		node->gl.lods[node->gl.lods_count].offset = offset;
+		node->gl.lods[node->gl.lods_count].count = mesh->lods[i].indices_count;
+		node->gl.lods[node->gl.lods_count].error = mesh->lods[i].error;
+		++node->gl.lods_count;
+		offset += mesh->lods[i].indices_count;
+	}
+
+	node->gl.ibo_size = total;
+	return indices;
+}
+
+/* picks the coarsest lod whose error projects under the threshold, refining right away but only coarsening with margin */
+static void mesh_lod_select(mesh_node_t * mesh, mat4x4 m) {
+	if (mesh->gl.lods_count <= 1 || state.lod.threshold <= 0 || state.lod.projection <= 0) {
+		mesh->gl.lod = 0;
+		return;
+	}
+
+	vec4 center = { mesh->gl.center[0], mesh->gl.center[1], mesh->gl.center[2], 1 };
+	vec4 world;
+	mat4x4_mul_vec4(world, m, center);
+
+	float scale = 0;
+	for (unsigned int i = 0; i < 3; ++i) {
+		float s = vec3_len(m[i]);
+		if (s > scale) {
+			scale = s;
+		}
+	}
+
+	vec3 offset;
+	vec3_sub(offset, world, state.camera->pos);
+	float distance = vec3_len(offset) - mesh->gl.radius * scale;
+	if (distance <= state.camera->nplane) {
+		mesh->gl.lod = 0;
+		return;
+	}
+
+	float pixels = scale * state.lod.projection / distance;
+	unsigned int refine = 0;
+	unsigned int coarsen = 0;
+	for (unsigned int i = 1; i < mesh->gl.lods_count; ++i) {
+		float error = mesh->gl.lods[i].error * pixels;
+		if (error <= state.lod.threshold) {
+			refine = i;
+		}
+		if (error <= state.lod.threshold * KGFW_GRAPHICS_GL_LOD_HYSTERESIS) {
+			coarsen = i;
+		}
+	}
+
+	if (mesh->gl.lod > refine) {
+		mesh->gl.lod = refine;
+	}
+	else if (coarsen > mesh->gl.lod) {
+		mesh->gl.lod = coarsen;
+	}
+}
+
+static unsigned short int float_to_half(float value) {
+	union {
+		float f;
+		unsigned int u;
+	} bits = { value };
+
+	unsigned int sign = (bits.u >> 16) & 0x8000;
+	int exponent = (int) ((bits.u >> 23) & 0xFF) - 127 + 15;
+	unsigned int mantissa = bits.u & 0x7FFFFF;
+
+	if (((bits.u >> 23) & 0xFF) == 0xFF) {
+		/* inf and nan */
+		return sign | 0x7C00 | ((mantissa != 0) ? 0x200 : 0);
+	}
+	if (exponent >= 31) {
+		return sign | 0x7C00;
+	}
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return sign;
+		}
+
+		/* subnormal */
+		mantissa |= 0x800000;
+		unsigned int shift = 14 - exponent;
+		unsigned int half = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1))) {
+			++half;
+		}
+		return sign | half;
+	}
+
+	unsigned int half = sign | (exponent << 10) | (mantissa >> 13);
+	unsigned int rest = mantissa & 0x1FFF;
+	/* round to nearest even, a carry into the exponent is still correct */
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		++half;
+	}
+
+	return half;
+}
+
+static unsigned int normal_to_2_10_10_10(float x, float y, float z) {
+	float n[3] = { x, y, z };
+	unsigned int packed = 0;
+	for (unsigned int i = 0; i < 3; ++i) {
+		float c = (n[i] > 1) ? 1 : (n[i] < -1) ? -1 : n[i];
+		int v = (int) ((c * 511.0f) + ((c < 0) ? -0.5f : 0.5f));
+		packed |= ((unsigned int) v & 0x3FF) << (i * 10);
+	}
+
+	return packed;
+}
+
+/* converts to the gpu layout selected by format, returns NULL for the float layout which is uploaded as is */
+static void * vertices_pack(const kgfw_graphics_mesh_t * mesh, unsigned int format, unsigned int * out_stride) {
+	if (!(format & KGFW_GRAPHICS_VERTEX_FORMAT_PACKED)) {
+		*out_stride = sizeof(kgfw_graphics_vertex_t);
+		return NULL;
+	}
+
+	unsigned int stride = ((format & KGFW_GRAPHICS_VERTEX_FORMAT_HALF_POSITION) ? 8 : 12) + 4 + 4 + ((format & KGFW_GRAPHICS_VERTEX_FORMAT_COLOR) ? 4 : 0);
+	unsigned char * packed = kgfw_memory_alloc(stride * mesh->vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (packed == NULL) {
+		return NULL;
+	}
+
+	for (unsigned long long int i = 0; i < mesh->vertices_count; ++i) {
+		const kgfw_graphics_vertex_t * v = &mesh->vertices[i];
+		unsigned char * p = packed + i * stride;
+
+		if (format & KGFW_GRAPHICS_VERTEX_FORMAT_HALF_POSITION) {
+			unsigned short int pos[4] = { float_to_half(v->x), float_to_half(v->y), float_to_half(v->z), float_to_half(1) };
+			memcpy(p, pos, sizeof(pos));
+			p += sizeof(pos);
+		}
+		else {
+			memcpy(p, &v->x, sizeof(float) * 3);
+			p += sizeof(float) * 3;
+		}
+
+		unsigned int normal = normal_to_2_10_10_10(v->nx, v->ny, v->nz);
+		memcpy(p, &normal, sizeof(normal));
+		p += sizeof(normal);
+
+		unsigned short int uv[2] = { float_to_half(v->u), float_to_half(v->v) };
+		memcpy(p, uv, sizeof(uv));
+		p += sizeof(uv);
+
+		if (format & KGFW_GRAPHICS_VERTEX_FORMAT_COLOR) {
+			float c[3] = { v->r, v->g, v->b };
+			for (unsigned int j = 0; j < 3; ++j) {
+				p[j] = (unsigned char) (((c[j] > 1) ? 1 : (c[j] < 0) ? 0 : c[j]) * 255.0f + 0.5f);
+			}
+			p[3] = 255;
+		}
+	}
+
+	*out_stride = stride;
+	return packed;
+}
+
+static void mesh_upload(mesh_node_t * node, const kgfw_graphics_mesh_t * mesh) {
+	node->gl.vbo_size = mesh->vertices_count;
+	node->gl.ibo_size = mesh->indices_count;
+	mesh_bounds(mesh, node->gl.center, node->gl.extent, &node->gl.radius);
+
+	kgfw_graphics_mesh_t combined = *mesh;
+	unsigned int * lod_indices = lods_combine(mesh, node);
+	if (lod_indices != NULL) {
+		combined.indices = lod_indices;
+		combined.indices_count = node->gl.ibo_size;
+	}
+
+	GL_CALL(glBindVertexArray(node->gl.vao));
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, node->gl.vbo));
+	unsigned int format = mesh->vertex_format;
+	unsigned int stride = 0;
+	void * packed = vertices_pack(mesh, format, &stride);
+	if (packed == NULL && (format & KGFW_GRAPHICS_VERTEX_FORMAT_PACKED)) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to pack mesh vertices, falling back to float vertices");
+		format = KGFW_GRAPHICS_VERTEX_FORMAT_FLOAT;
+		stride = sizeof(kgfw_graphics_vertex_t);
+	}
+
+	GL_CALL(glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) stride * mesh->vertices_count, (packed == NULL) ? (void *) mesh->vertices : packed, GL_STATIC_DRAW));
+	kgfw_memory_free(packed);
+	GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, node->gl.ibo));
+	unsigned short int * narrow = kgfw_mesh_indices_narrow(&combined);
+	if (narrow != NULL) {
+		node->gl.index_type = GL_UNSIGNED_SHORT;
+		GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short int) * combined.indices_count, narrow, GL_STATIC_DRAW));
+		kgfw_memory_free(narrow);
+	}
+	else {
+		node->gl.index_type = GL_UNSIGNED_INT;
+		GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * combined.indices_count, combined.indices, GL_STATIC_DRAW));
+	}
+	kgfw_memory_free(lod_indices);
+
+	unsigned long long int index_size = (node->gl.index_type == GL_UNSIGNED_SHORT) ? sizeof(unsigned short int) : sizeof(unsigned int);
+	for (unsigned int i = 0; i < node->gl.lods_count; ++i) {
+		node->gl.lods[i].offset *= index_size;
+	}
+
+	if (format & KGFW_GRAPHICS_VERTEX_FORMAT_PACKED) {
+		unsigned long long int offset = 0;
+		if (format & KGFW_GRAPHICS_VERTEX_FORMAT_HALF_POSITION) {
+			GL_CALL(glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void *) offset));
+			offset += 8;
+		}
+		else {
+			GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *) offset));
+			offset += 12;
+		}
+		GL_CALL(glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void *) offset));
+		offset += 4;
+		GL_CALL(glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *) offset));
+		offset += 4;
+		if (format & KGFW_GRAPHICS_VERTEX_FORMAT_COLOR) {
+			GL_CALL(glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *) offset));
+			GL_CALL(glEnableVertexAttribArray(1));
+		}
+		else {
+			node->gl.constant_color = 1;
+		}
+	}
+	else {
+		GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, x)));
+		GL_CALL(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, r)));
+		GL_CALL(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, nx)));
+		GL_CALL(glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(kgfw_graphics_vertex_t), (void *) offsetof(kgfw_graphics_vertex_t, u)));
+		GL_CALL(glEnableVertexAttribArray(1));
+	}
+	GL_CALL(glEnableVertexAttribArray(0));
+	GL_CALL(glEnableVertexAttribArray(2));
+	GL_CALL(glEnableVertexAttribArray(3));
+}
+
+kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh, kgfw_graphics_mesh_node_t * parent) {
+	kgfw_frame_request_redraw();
+	mesh_node_t * node = meshes_new();
+	node->parent = (mesh_node_t *) parent;
+	memcpy(node->transform.pos, mesh->pos, sizeof(vec3));
+	memcpy(node->transform.rot, mesh->rot, sizeof(vec3));
+	memcpy(node->transform.scale, mesh->scale, sizeof(vec3));
+	node->gl.source = mesh;
+	mesh_upload(node, mesh);
+
+	if (parent == NULL) {
+		if (state.mesh_root == NULL) {
+			state.mesh_root = node;
+		}
+		else {
+			mesh_node_t * n;
+			for (n = state.mesh_root; n->sibling != NULL; n = n->sibling);
+			n->sibling = node;
+			node->prior_sibling = n;
+		}
+		return (kgfw_graphics_mesh_node_t *) node;
+	}
+
+	if (parent->child == NULL) {
+		parent->child = (kgfw_graphics_mesh_node_t *) node;
+	}
+	else {
+		mesh_node_t * n;
+		for (n = (mesh_node_t *) parent->child; n->sibling != NULL; n = n->sibling);
+		n->sibling = node;
+		node->prior_sibling = n;
+	}
+
+	return (kgfw_graphics_mesh_node_t *) node;
+}
+
+void kgfw_graphics_mesh_destroy(kgfw_graphics_mesh_node_t * mesh) {
+	kgfw_frame_request_redraw();
+	if (mesh == NULL) {
+		return;
+	}
+
+	if (mesh->parent != NULL) {
+		mesh->parent->child = mesh->child;
+	}
+	if (mesh->prior_sibling != NULL) {
+		mesh->prior_sibling->sibling = mesh->sibling;
+	}
+	if (mesh->child != NULL) {
+		mesh->child->parent = mesh->parent;
+	}
+	if (mesh->sibling != NULL) {
+		mesh->sibling->prior_sibling = mesh->prior_sibling;
+	}
+
+	if (state.mesh_root == (mesh_node_t *) mesh) {
+		state.mesh_root = NULL;
+	}
+
+	if (((mesh_node_t *) mesh)->gl.is_static) {
+		state.statics.dirty = 1;
+	}
+	meshes_free((mesh_node_t *) mesh);
+}
+
+void kgfw_graphics_set_window(kgfw_window_t * window) {
+	state.window = window;
+	if (window != NULL) {
+		if (window->internal != NULL) {
+			glfwMakeContextCurrent(window->internal);
+		}
+		GL_CALL(glViewport(0, 0, window->width * window->content_scale_x, window->height * window->content_scale_y));
+	}
+}
+
+void kgfw_graphics_viewport(unsigned int width, unsigned int height) {
+	GL_CALL(glViewport(0, 0, width * state.window->content_scale_x, height * state.window->content_scale_y));
+}
+
+void kgfw_graphics_finish(void) {
+	GL_CALL(glFinish());
+}
+
+int kgfw_graphics_read_pixels(void * out_rgba) {
+	if (state.window == NULL) {
+		return 1;
+	}
+
+	GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	GL_CALL(glReadPixels(0, 0, state.window->width * state.window->content_scale_x, state.window->height * state.window->content_scale_y, GL_RGBA, GL_UNSIGNED_BYTE, out_rgba));
+	return 0;
+}
+
+kgfw_window_t * kgfw_graphics_get_window(void) {
+	return state.window;
+}
+
+void kgfw_graphics_deinit(void) {
+	meshes_free_recursive_fchild(state.mesh_root);
+	statics_clear();
+	kgfw_memory_free(state.statics.nodes);
+	state.statics.nodes = NULL;
+	state.statics.nodes_capacity = 0;
+	kgfw_memory_free(state.queue.draws);
+	state.queue.draws = NULL;
+	state.queue.count = 0;
+	state.queue.capacity = 0;
+	variants_clear();
+	profile_deinit();
+	lights_deinit();
+	occlusion_deinit();
+	offscreen_deinit();
+}
+
+static mesh_node_t * meshes_alloc(void) {
+	mesh_node_t * m = kgfw_memory_alloc(sizeof(mesh_node_t), KGFW_MEMORY_TAG_GRAPHICS);
+	if (m == NULL) {
+		return NULL;
+	}
+
+	memset(m, 0, sizeof(*m));
 	m->transform.scale[0] = 1;
 	m->transform.scale[1] = 1;
 	m->transform.scale[2] = 1;
@@ -2635,280 +4040,1475 @@ static void meshes_free(mesh_node_t * node) {
 	if (node->gl.normal != 0) {
 		GL_CALL(glDeleteTextures(1, &node->gl.normal));
 	}
+	if (node->gl.query != 0) {
+		GL_CALL(glDeleteQueries(1, &node->gl.query));
+	}
+
+	kgfw_memory_free(node);
+}
+
+static void meshes_gen(mesh_node_t * node) {
+	GL_CALL(glGenVertexArrays(1, &node->gl.vao));
+	GL_CALL(glGenBuffers(1, &node->gl.vbo));
+	GL_CALL(glGenBuffers(1, &node->gl.ibo));
+	node->gl.tex = 0;
+	node->gl.normal = 0;
+}
+
+static mesh_node_t * meshes_new(void) {
+	mesh_node_t * m = meshes_alloc();
+	if (m == NULL) {
+		return NULL;
+	}
+
+	meshes_gen(m);
+	return m;
+}
+
+static void mesh_transform(mesh_node_t * mesh, mat4x4 out_m) {
+	float pos[3] = { recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[2] + mesh->transform.pos[2] };
+	if (mesh->transform.absolute) {
+		recurse_state.pos[0] = mesh->transform.pos[0];
+		recurse_state.pos[1] = mesh->transform.pos[1];
+		recurse_state.pos[2] = mesh->transform.pos[2];
+		recurse_state.rot = *kgfw_quat_cache_get(&mesh->transform.rotation, mesh->transform.rot);
+		recurse_state.scale[0] = mesh->transform.scale[0];
+		recurse_state.scale[1] = mesh->transform.scale[1];
+		recurse_state.scale[2] = mesh->transform.scale[2];
+	} else {
+		recurse_state.pos[0] += mesh->transform.pos[0];
+		recurse_state.pos[1] += mesh->transform.pos[1];
+		recurse_state.pos[2] += mesh->transform.pos[2];
+		kgfw_quat_mul(&recurse_state.rot, &recurse_state.rot, kgfw_quat_cache_get(&mesh->transform.rotation, mesh->transform.rot));
+		recurse_state.scale[0] *= mesh->transform.scale[0];
+		recurse_state.scale[1] *= mesh->transform.scale[1];
+		recurse_state.scale[2] *= mesh->transform.scale[2];
+	}
+
+	kgfw_mat4_rotation_quat((kgfw_mat4_t *) recurse_state.model_r, &recurse_state.rot);
+	mat4x4_scale_aniso(out_m, recurse_state.model_r, recurse_state.scale[0], recurse_state.scale[1], recurse_state.scale[2]);
+	out_m[3][0] = pos[0];
+	out_m[3][1] = pos[1];
+	out_m[3][2] = pos[2];
+}
+
+static void mesh_draw(mesh_node_t * mesh, mat4x4 out_m) {
+	if (mesh == NULL || out_m == NULL) {
+		return;
+	}
+	if (mesh->gl.vbo_size == 0 || mesh->gl.ibo_size == 0 || mesh->gl.vbo == 0 || mesh->gl.ibo == 0) {
+		return;
+	}
+
+	mat4x4_identity(out_m);
+	mesh_transform(mesh, out_m);
+	if (mesh->gl.is_static && !mesh->gl.translucent) {
+		if (state.statics.dirty) {
+			statics_collect(mesh, out_m);
+		}
+		return;
+	}
+
+	kgfw_vec4_t center = { { mesh->gl.center[0], mesh->gl.center[1], mesh->gl.center[2], 1 } };
+	kgfw_vec4_t world;
+	kgfw_mat4_mul_vec4(&world, (kgfw_mat4_t *) out_m, &center);
+	float radius = mesh->gl.radius * fmaxf(vec3_len(out_m[0]), fmaxf(vec3_len(out_m[1]), vec3_len(out_m[2])));
+	if (!kgfw_frustum_sphere(&state.occlusion.frustum, world.v, radius)) {
+		++state.occlusion.culled;
+		return;
+	}
+
+	mesh_lod_select(mesh, out_m);
+
+	unsigned int features = 0;
+	if (mesh->gl.tex != 0) {
+		features |= GL_VARIANT_TEXTURED;
+	}
+	if (mesh->gl.normal != 0) {
+		features |= GL_VARIANT_NORMAL_MAPPED;
+	}
+	if (!mesh->gl.unlit) {
+		features |= GL_VARIANT_LIT;
+	}
+
+	gl_variant_t * variant = NULL;
+	if (mesh->gl.program == 0) {
+		variant = variant_get(features);
+		if (variant->program == 0) {
+			return;
+		}
+	}
+
+	if (state.queue.count >= state.queue.capacity) {
+		unsigned long long int capacity = (state.queue.capacity == 0) ? 256 : state.queue.capacity * 2;
+		gl_draw_t * draws = kgfw_memory_realloc(state.queue.draws, sizeof(gl_draw_t) * capacity, KGFW_MEMORY_TAG_GRAPHICS);
+		if (draws == NULL) {
+			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to grow draw queue, mesh is skipped");
+			return;
+		}
+		state.queue.draws = draws;
+		state.queue.capacity = capacity;
+	}
+
+	gl_draw_t * draw = &state.queue.draws[state.queue.count];
+	draw->mesh = mesh;
+	draw->variant = variant;
+	draw->features = features;
+	draw->order = (unsigned int) state.queue.count;
+	draw->blended = mesh->gl.translucent;
+	mat4x4_dup(draw->model, out_m);
+
+	/* clip w of the bounds center is its view depth */
+	kgfw_vec4_t clip;
+	kgfw_mat4_mul_vec4(&clip, (kgfw_mat4_t *) state.vp, &world);
+	draw->depth = clip.v[3];
+	++state.queue.count;
+}
+
+static void draw_submit(gl_draw_t * draw, gl_variant_t * variant) {
+	mesh_node_t * mesh = draw->mesh;
+	if (variant == NULL) {
+		if (mesh->gl.custom.program != mesh->gl.program) {
+			mesh->gl.custom.program = mesh->gl.program;
+			variant_locations(&mesh->gl.custom);
+		}
+		variant = &mesh->gl.custom;
+	}
+
+	GL_CALL(glUseProgram(variant->program));
+
+	GL_CALL(glUniformMatrix4fv(variant->unif_m, 1, GL_FALSE, &draw->model[0][0]));
+	GL_CALL(glUniformMatrix4fv(variant->unif_vp, 1, GL_FALSE, &state.vp[0][0]));
+	GL_CALL(glUniform1f(variant->unif_time, (float) kgfw_time_game()));
+	GL_CALL(glUniform3f(variant->unif_view_pos, state.camera->pos[0], state.camera->pos[1], state.camera->pos[2]));
+	GL_CALL(glUniformMatrix4fv(variant->unif_v, 1, GL_FALSE, &state.lights.v[0][0]));
+	GL_CALL(glUniform4fv(variant->unif_cluster_viewport, 1, state.lights.viewport));
+	GL_CALL(glUniform2f(variant->unif_cluster_depth, state.lights.depth_scale, state.lights.depth_bias));
+
+	if (draw->features & GL_VARIANT_TEXTURED) {
+		GL_CALL(glActiveTexture(GL_TEXTURE0));
+		GL_CALL(glBindTexture(GL_TEXTURE_2D, mesh->gl.tex));
+	}
+	if (draw->features & GL_VARIANT_NORMAL_MAPPED) {
+		GL_CALL(glActiveTexture(GL_TEXTURE1));
+		GL_CALL(glBindTexture(GL_TEXTURE_2D, mesh->gl.normal));
+	}
+
+	GL_CALL(glBindVertexArray(mesh->gl.vao));
+	if (mesh->gl.constant_color) {
+		/* current attribute values are context state, not vao state */
+		GL_CALL(glVertexAttrib4f(1, 1, 1, 1, 1));
+	}
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mesh->gl.vbo));
+	GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->gl.ibo));
+	//GL_CALL(glDrawArrays(GL_TRIANGLES, 0, mesh->gl.vbo_size));
+	gl_mesh_lod_t * lod = &mesh->gl.lods[mesh->gl.lod];
+	int scope = profile_begin((variant == &mesh->gl.custom) ? "custom" : variant_names[draw->features & (GL_VARIANT_DEPTH_ONLY - 1)]);
+	GL_CALL(glDrawElements(GL_TRIANGLES, lod->count, mesh->gl.index_type, (void *) lod->offset));
+	profile_end(scope);
+}
+
+static int draw_compare_sorted(const void * a, const void * b) {
+	const gl_draw_t * da = a;
+	const gl_draw_t * db = b;
+	if (da->blended != db->blended) {
+		return (da->blended > db->blended) - (da->blended < db->blended);
+	}
+	if (da->blended) {
+		return (da->depth < db->depth) - (da->depth > db->depth);
+	}
+	return (da->depth > db->depth) - (da->depth < db->depth);
+}
+
+static int draw_compare_unsorted(const void * a, const void * b) {
+	const gl_draw_t * da = a;
+	const gl_draw_t * db = b;
+	if (da->blended != db->blended) {
+		return (da->blended > db->blended) - (da->blended < db->blended);
+	}
+	return (da->order > db->order) - (da->order < db->order);
+}
+
+static void occlusion_query_begin(mesh_node_t * mesh) {
+	if (mesh->gl.query == 0) {
+		GL_CALL(glGenQueries(1, &mesh->gl.query));
+	}
+	GL_CALL(glBeginQuery(GL_ANY_SAMPLES_PASSED, mesh->gl.query));
+}
+
+static void occlusion_query_end(mesh_node_t * mesh) {
+	GL_CALL(glEndQuery(GL_ANY_SAMPLES_PASSED));
+	mesh->gl.query_pending = 1;
+	++state.occlusion.queries;
+}
+
+/* picks up whichever query results have arrived, meshes keep their last visibility until theirs does */
+static void occlusion_resolve(gl_draw_t * draws, unsigned long long int count) {
+	for (unsigned long long int i = 0; i < count; ++i) {
+		mesh_node_t * mesh = draws[i].mesh;
+		if (mesh->gl.query_pending) {
+			GLuint available = GL_FALSE;
+			GL_CALL(glGetQueryObjectuiv(mesh->gl.query, GL_QUERY_RESULT_AVAILABLE, &available));
+			if (available) {
+				GLuint samples = 0;
+				GL_CALL(glGetQueryObjectuiv(mesh->gl.query, GL_QUERY_RESULT, &samples));
+				mesh->gl.occluded = (samples == 0);
+				mesh->gl.query_pending = 0;
+			}
+		}
+
+		if (!mesh->gl.occluded) {
+			continue;
+		}
+
+		/* the near plane clips boxes the camera is in or next to, which would read as hidden */
+		vec4 center = { mesh->gl.center[0], mesh->gl.center[1], mesh->gl.center[2], 1 };
+		vec4 world;
+		vec3 offset;
+		mat4x4_mul_vec4(world, draws[i].model, center);
+		vec3_sub(offset, world, state.camera->pos);
+		float scale = fmaxf(vec3_len(draws[i].model[0]), fmaxf(vec3_len(draws[i].model[1]), vec3_len(draws[i].model[2])));
+		if (vec3_len(offset) <= mesh->gl.radius * scale * (1 + KGFW_GRAPHICS_GL_OCCLUSION_MARGIN) + state.camera->nplane * 2) {
+			mesh->gl.occluded = 0;
+			continue;
+		}
+
+		++state.occlusion.occluded;
+	}
+}
+
+/* draws the bounding box of every hidden mesh against the finished opaque depth to find out if it came into view */
+static void occlusion_test(gl_draw_t * draws, unsigned long long int count) {
+	unsigned char bound = 0;
+	for (unsigned long long int i = 0; i < count; ++i) {
+		mesh_node_t * mesh = draws[i].mesh;
+		if (!mesh->gl.occluded || mesh->gl.query_pending) {
+			continue;
+		}
+
+		if (!bound) {
+			GL_CALL(glUseProgram(state.occlusion.program));
+			GL_CALL(glBindVertexArray(state.occlusion.vao));
+			GL_CALL(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+			GL_CALL(glDepthMask(GL_FALSE));
+			GL_CALL(glDisable(GL_CULL_FACE));
+			bound = 1;
+		}
+
+		mat4x4 box;
+		mat4x4 mvp;
+		float grow = 1 + KGFW_GRAPHICS_GL_OCCLUSION_MARGIN;
+		mat4x4_translate(box, mesh->gl.center[0], mesh->gl.center[1], mesh->gl.center[2]);
+		mat4x4_scale_aniso(box, box, mesh->gl.extent[0] * grow, mesh->gl.extent[1] * grow, mesh->gl.extent[2] * grow);
+		kgfw_mat4_mul((kgfw_mat4_t *) mvp, (kgfw_mat4_t *) draws[i].model, (kgfw_mat4_t *) box);
+		kgfw_mat4_mul((kgfw_mat4_t *) mvp, (kgfw_mat4_t *) state.vp, (kgfw_mat4_t *) mvp);
+		GL_CALL(glUniformMatrix4fv(state.occlusion.unif_mvp, 1, GL_FALSE, &mvp[0][0]));
+
+		occlusion_query_begin(mesh);
+		GL_CALL(glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, NULL));
+		occlusion_query_end(mesh);
+	}
+
+	if (bound) {
+		GL_CALL(glEnable(GL_CULL_FACE));
+		GL_CALL(glDepthMask(GL_TRUE));
+		GL_CALL(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+	}
+}
+
+static void draws_flush(void) {
+	gl_draw_t * draws = state.queue.draws;
+	unsigned long long int count = state.queue.count;
+	state.queue.count = 0;
+	if (count == 0) {
+		return;
+	}
+
+	qsort(draws, count, sizeof(gl_draw_t), (state.settings & KGFW_GRAPHICS_SETTINGS_SORT) ? draw_compare_sorted : draw_compare_unsorted);
+	unsigned long long int opaque = 0;
+	while (opaque < count && !draws[opaque].blended) {
+		++opaque;
+	}
+
+	GL_CALL(glDisable(GL_BLEND));
+
+	/* blended draws never write depth, so only opaque draws take part in occlusion */
+	unsigned char occlusion = (state.settings & KGFW_GRAPHICS_SETTINGS_OCCLUSION) && state.occlusion.program != 0;
+	if (occlusion) {
+		occlusion_resolve(draws, opaque);
+	}
+
+	/* custom programs may move vertices differently, so they skip the pre-pass and depth test normally */
+	unsigned char prepass = (state.settings & KGFW_GRAPHICS_SETTINGS_DEPTH_PREPASS) != 0;
+	if (prepass) {
+		int prepass_scope = profile_begin("prepass");
+		GL_CALL(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+		for (unsigned long long int i = 0; i < opaque; ++i) {
+			if (draws[i].variant == NULL || (occlusion && draws[i].mesh->gl.occluded)) {
+				continue;
+			}
+
+			gl_variant_t * depth = variant_get(GL_VARIANT_DEPTH_ONLY | (draws[i].features & GL_VARIANT_TEXTURED));
+			if (depth->program != 0) {
+				draw_submit(&draws[i], depth);
+			}
+		}
+		GL_CALL(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+		profile_end(prepass_scope);
+	}
+
+	int opaque_scope = profile_begin("opaque");
+	for (unsigned long long int i = 0; i < opaque; ++i) {
+		mesh_node_t * mesh = draws[i].mesh;
+		if (occlusion && mesh->gl.occluded) {
+			continue;
+		}
+
+		/* visible meshes are requeried through their own draw, spread over the interval so few are queried in one frame */
+		unsigned char query = occlusion && !mesh->gl.query_pending && (state.occlusion.frame + ((size_t) mesh >> 6)) % KGFW_GRAPHICS_GL_OCCLUSION_INTERVAL == 0;
+		unsigned char equal = prepass && draws[i].variant != NULL && variant_get(GL_VARIANT_DEPTH_ONLY | (draws[i].features & GL_VARIANT_TEXTURED))->program != 0;
+		if (equal) {
+			GL_CALL(glDepthFunc(GL_EQUAL));
+			GL_CALL(glDepthMask(GL_FALSE));
+		}
+		if (query) {
+			occlusion_query_begin(mesh);
+		}
+		draw_submit(&draws[i], draws[i].variant);
+		if (query) {
+			occlusion_query_end(mesh);
+		}
+		if (equal) {
+			GL_CALL(glDepthFunc(GL_LESS));
+			GL_CALL(glDepthMask(GL_TRUE));
+		}
+	}
+	profile_end(opaque_scope);
+
+	if (occlusion) {
+		int occlusion_scope = profile_begin("occlusion");
+		occlusion_test(draws, opaque);
+		profile_end(occlusion_scope);
+	}
+
+	if (opaque < count) {
+		int blended_scope = profile_begin("blended");
+		GL_CALL(glEnable(GL_BLEND));
+		GL_CALL(glDepthMask(GL_FALSE));
+		for (unsigned long long int i = opaque; i < count; ++i) {
+			draw_submit(&draws[i], draws[i].variant);
+		}
+		GL_CALL(glDepthMask(GL_TRUE));
+		profile_end(blended_scope);
+	}
+	else {
+		GL_CALL(glEnable(GL_BLEND));
+	}
+}
+
+static void meshes_draw_recursive(mesh_node_t * mesh) {
+	if (mesh == NULL) {
+		return;
+	}
+
+	mesh_draw(mesh, recurse_state.model);
+	if (mesh->child == NULL) {
+		return;
+	}
+
+	meshes_draw_recursive_fchild(mesh->child);
+}
+
+static void meshes_draw_recursive_fchild(mesh_node_t * mesh) {
+	if (mesh == NULL) {
+		return;
+	}
+
+	vec3 pos;
+	kgfw_quat_t rot;
+	vec3 scale;
+	memcpy(pos, recurse_state.pos, sizeof(pos));
+	rot = recurse_state.rot;
+	memcpy(scale, recurse_state.scale, sizeof(scale));
+
+	meshes_draw_recursive(mesh);
+	for (mesh_node_t * m = mesh;;) {
+		m = m->sibling;
+		if (m == NULL) {
+			break;
+		}
+
+		memcpy(recurse_state.pos, pos, sizeof(pos));
+		recurse_state.rot = rot;
+		memcpy(recurse_state.scale, scale, sizeof(scale));
+		meshes_draw_recursive(m);
+	}
+}
+
+static void meshes_free_recursive(mesh_node_t * mesh) {
+	if (mesh == NULL) {
+		return;
+	}
+
+	if (mesh->child != NULL) {
+		meshes_free_recursive_fchild(mesh->child);
+	}
+
+	meshes_free(mesh);
+}
+
+static void meshes_free_recursive_fchild(mesh_node_t * mesh) {
+	if (mesh == NULL) {
+		return;
+	}
+
+	mesh_node_t * sibling = mesh->sibling;
+	for (mesh_node_t * m = mesh;;) {
+		m = sibling;
+		if (m == NULL) {
+			break;
+		}
+		sibling = m->sibling;
+
+		meshes_free_recursive(m);
+	}
+	meshes_free_recursive(mesh);
+}
+
+static void update_settings(unsigned int change) {
+	if (change &KGFW_GRAPHICS_SETTINGS_VSYNC) {
+		if (state.window != NULL) {
+			glfwSwapInterval((state.settings &KGFW_GRAPHICS_SETTINGS_VSYNC));
+		}
+	}
+}
+
+static int gfx_command(int argc, char ** argv) {
+	const char * subcommands = "set    enable    disable    reload    lod    lights    culling    stats";
+	if (argc < 2) {
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "subcommands: %s", subcommands);
+		return 0;
+	}
+
+	if (strcmp("reload", argv[1]) == 0) {
+		const char * options = "vsync";
+		const char * arguments = "[option]    see 'gfx options'";
+		if (argc < 3) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
+			return 0;
+		}
+
+		if (strcmp("shaders", argv[2]) == 0) {
+			variants_clear();
+			return 0;
+		}
+
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no option %s", argv[2]);
+	}
+	else if (strcmp("enable", argv[1]) == 0) {
+		const char * options = "vsync    sort    prepass    occlusion";
+		const char * arguments = "[option]    see 'gfx options'";
+		if (argc < 3) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
+			return 0;
+		}
+
+		if (strcmp("vsync", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_ENABLE, KGFW_GRAPHICS_SETTINGS_VSYNC);
+			return 0;
+		}
+		if (strcmp("sort", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_ENABLE, KGFW_GRAPHICS_SETTINGS_SORT);
+			return 0;
+		}
+		if (strcmp("prepass", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_ENABLE, KGFW_GRAPHICS_SETTINGS_DEPTH_PREPASS);
+			return 0;
+		}
+		if (strcmp("occlusion", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_ENABLE, KGFW_GRAPHICS_SETTINGS_OCCLUSION);
+			return 0;
+		}
+
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no option %s", argv[2]);
+	}
+	else if (strcmp("disable", argv[1]) == 0) {
+		const char * options = "vsync    sort    prepass    occlusion";
+		const char * arguments = "[option]    see 'gfx options'";
+		if (argc < 3) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
+			return 0;
+		}
+
+		if (strcmp("vsync", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_DISABLE, KGFW_GRAPHICS_SETTINGS_VSYNC);
+			return 0;
+		}
+		if (strcmp("sort", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_DISABLE, KGFW_GRAPHICS_SETTINGS_SORT);
+			return 0;
+		}
+		if (strcmp("prepass", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_DISABLE, KGFW_GRAPHICS_SETTINGS_DEPTH_PREPASS);
+			return 0;
+		}
+		if (strcmp("occlusion", argv[2]) == 0) {
+			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_DISABLE, KGFW_GRAPHICS_SETTINGS_OCCLUSION);
+			return 0;
+		}
+
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no option %s", argv[2]);
+	}
+	else if (strcmp("lights", argv[1]) == 0) {
+		unsigned int active = 0;
+		for (unsigned int i = 0; i < state.lights.count; ++i) {
+			active += state.lights.used[i];
+		}
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "lights: %u active, %u visible", active, state.lights.visible);
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "clusters: %ux%ux%u, %u light references, %llu dropped", KGFW_GRAPHICS_GL_CLUSTERS_X, KGFW_GRAPHICS_GL_CLUSTERS_Y, KGFW_GRAPHICS_GL_CLUSTERS_Z, state.lights.indices_count, state.lights.dropped);
+	}
+	else if (strcmp("culling", argv[1]) == 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "occlusion culling %s", (state.settings & KGFW_GRAPHICS_SETTINGS_OCCLUSION) ? "enabled" : "disabled");
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "last frame: %u outside the frustum, %u occluded, %u queries issued", state.occlusion.culled, state.occlusion.occluded, state.occlusion.queries);
+	}
+	else if (strcmp("lod", argv[1]) == 0) {
+		const char * arguments = "[pixels]    0 always draws full detail";
+		if (argc < 3) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "lod threshold: %f pixels", state.lod.threshold);
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
+			return 0;
+		}
+
+		state.lod.threshold = atof(argv[2]);
+	}
+	else if (strcmp("stats", argv[1]) == 0) {
+		if (argc >= 3) {
+			if (strcmp("enable", argv[2]) == 0) {
+				state.profile.enabled = 1;
+			}
+			else if (strcmp("disable", argv[2]) == 0) {
+				state.profile.enabled = 0;
+			}
+			else if (strcmp("reset", argv[2]) == 0) {
+				profile_reset();
+			}
+			else if (strcmp("trace", argv[2]) == 0) {
+				const char * path = (argc >= 4) ? argv[3] : "gpu_trace.json";
+				if (profile_trace_export(path) != 0) {
+					kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "failed to write gpu trace to \"%s\"", path);
+				}
+				else {
+					kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "wrote gpu trace to \"%s\"", path);
+				}
+			}
+			else {
+				kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: [enable    disable    reset    trace [path]]");
+			}
+			return 0;
+		}
+
+		if (!state.profile.enabled) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "gpu profiling is disabled, see 'gfx stats enable'");
+			return 0;
+		}
+
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "gpu frames %llu resolved %llu dropped %llu", state.profile.frame, state.profile.resolved, state.profile.dropped);
+		for (unsigned int i = 0; i < state.profile.stats_count; ++i) {
+			gl_profile_stat_t * stat = &state.profile.stats[i];
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "%-40s %8.3f ms  avg %8.3f ms  max %8.3f ms  calls %llu", stat->name, stat->last_ms, stat->average_ms, stat->max_ms, stat->calls);
+		}
+	}
+	else if (strcmp("options", argv[1]) == 0) {
+		const char * options = "vsync    sort    prepass    occlusion    shaders";
+		const char * arguments = "[option]    see 'gfx options'";
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "options: %s", options);
+	}
+	else {
+		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "subcommands: %s", subcommands);
+	}
+	return 0;
+}
+
+static void register_commands(void) {
+	kgfw_console_register_command("gfx", gfx_command);
+}
+
+static void gl_errors(void) {
+	GLenum err = -1;
+	while (1) {
+		err = glGetError();
+		if (err == GL_NO_ERROR) {
+			break;
+		}
+		kgfw_logf(KGFW_LOG_SEVERITY_DEBUG, "err %i", err);
+	}
+}
+
+static void variant_locations(gl_variant_t * variant) {
+	GLuint program = variant->program;
+	variant->unif_m = GL_CALL(glGetUniformLocation(program, "unif_m"));
+	variant->unif_vp = GL_CALL(glGetUniformLocation(program, "unif_vp"));
+	variant->unif_time = GL_CALL(glGetUniformLocation(program, "unif_time"));
+	variant->unif_view_pos = GL_CALL(glGetUniformLocation(program, "unif_view_pos"));
+	variant->unif_texture_color = GL_CALL(glGetUniformLocation(program, "unif_texture_color"));
+	variant->unif_texture_normal = GL_CALL(glGetUniformLocation(program, "unif_texture_normal"));
+	variant->unif_v = GL_CALL(glGetUniformLocation(program, "unif_v"));
+	variant->unif_cluster_viewport = GL_CALL(glGetUniformLocation(program, "unif_cluster_viewport"));
+	variant->unif_cluster_depth = GL_CALL(glGetUniformLocation(program, "unif_cluster_depth"));
+	variant->unif_lights = GL_CALL(glGetUniformLocation(program, "unif_lights"));
+	variant->unif_clusters = GL_CALL(glGetUniformLocation(program, "unif_clusters"));
+	variant->unif_light_indices = GL_CALL(glGetUniformLocation(program, "unif_light_indices"));
+
+	/* sampler units never change so they are set once per program */
+	GL_CALL(glUseProgram(program));
+	GL_CALL(glUniform1i(variant->unif_texture_color, 0));
+	GL_CALL(glUniform1i(variant->unif_texture_normal, 1));
+	GL_CALL(glUniform1i(variant->unif_lights, KGFW_GRAPHICS_GL_LIGHTS_UNIT));
+	GL_CALL(glUniform1i(variant->unif_clusters, KGFW_GRAPHICS_GL_LIGHTS_UNIT + 1));
+	GL_CALL(glUniform1i(variant->unif_light_indices, KGFW_GRAPHICS_GL_LIGHTS_UNIT + 2));
+}
+
+static gl_variant_t * variant_get(unsigned int features) {
+	gl_variant_t * variant = &state.variants[features & (GL_VARIANT_COUNT - 1)];
+	if (variant->program != 0 || variant->failed) {
+		return variant;
+	}
+
+	char defines[256];
+	snprintf(defines, sizeof(defines), "%s%s%s%s%s#define KGFW_CLUSTERS uvec3(%uu, %uu, %uu)\n",
+		(features & GL_VARIANT_TEXTURED) ? "#define KGFW_TEXTURED\n" : "",
+		(features & GL_VARIANT_NORMAL_MAPPED) ? "#define KGFW_NORMAL_MAPPED\n" : "",
+		(features & GL_VARIANT_LIT) ? "#define KGFW_LIT\n" : "",
+		(features & GL_VARIANT_INSTANCED) ? "#define KGFW_INSTANCED\n" : "",
+		(features & GL_VARIANT_DEPTH_ONLY) ? "#define KGFW_DEPTH_ONLY\n" : "",
+		KGFW_GRAPHICS_GL_CLUSTERS_X, KGFW_GRAPHICS_GL_CLUSTERS_Y, KGFW_GRAPHICS_GL_CLUSTERS_Z
+	);
+
+	variant->program = GL_CALL(glCreateProgram());
+	if (shaders_load("assets/shaders/shader.vert", "assets/shaders/shader.frag", defines, &variant->program) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to build shader variant 0x%x", features);
+		GL_CALL(glDeleteProgram(variant->program));
+		variant->program = 0;
+		variant->failed = 1;
+		return variant;
+	}
+
+	variant_locations(variant);
+	return variant;
+}
+
+static void variants_clear(void) {
+	for (unsigned int i = 0; i < GL_VARIANT_COUNT; ++i) {
+		if (state.variants[i].program != 0) {
+			GL_CALL(glDeleteProgram(state.variants[i].program));
+		}
+		state.variants[i].program = 0;
+		state.variants[i].failed = 0;
+	}
+}
+
+static void program_binary_init(void) {
+	state.program_binary.supported = 0;
+
+	GLint major = 0;
+	GLint minor = 0;
+	GL_CALL(glGetIntegerv(GL_MAJOR_VERSION, &major));
+	GL_CALL(glGetIntegerv(GL_MINOR_VERSION, &minor));
+	unsigned char available = (major > 4 || (major == 4 && minor >= 1));
+	if (!available) {
+		GLint count = 0;
+		GL_CALL(glGetIntegerv(GL_NUM_EXTENSIONS, &count));
+		for (GLint i = 0; i < count; ++i) {
+			const char * ext = (const char *) glGetStringi(GL_EXTENSIONS, i);
+			if (ext != NULL && strcmp(ext, "GL_ARB_get_program_binary") == 0) {
+				available = 1;
+				break;
+			}
+		}
+	}
+
+	if (!available) {
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "OpenGL program binaries unavailable, shader cache disabled");
+		return;
+	}
+
+	GLint formats = 0;
+	GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+	state.program_binary.get = (gl_get_program_binary_func) glfwGetProcAddress("glGetProgramBinary");
+	state.program_binary.load = (gl_program_binary_func) glfwGetProcAddress("glProgramBinary");
+	state.program_binary.parameteri = (gl_program_parameteri_func) glfwGetProcAddress("glProgramParameteri");
+	if (formats <= 0 || state.program_binary.get == NULL || state.program_binary.load == NULL || state.program_binary.parameteri == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "OpenGL driver exposes no program binary formats, shader cache disabled");
+		return;
+	}
+
+	state.program_binary.supported = 1;
+}
+
+static void statics_collect(mesh_node_t * node, mat4x4 m) {
+	if (state.statics.nodes_count >= state.statics.nodes_capacity) {
+		unsigned long long int capacity = (state.statics.nodes_capacity == 0) ? 64 : state.statics.nodes_capacity * 2;
+		mesh_node_t ** nodes = kgfw_memory_realloc(state.statics.nodes, sizeof(mesh_node_t *) * capacity, KGFW_MEMORY_TAG_GRAPHICS);
+		if (nodes == NULL) {
+			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to grow static node list, node is skipped");
+			return;
+		}
+		state.statics.nodes = nodes;
+		state.statics.nodes_capacity = capacity;
+	}
+
+	mat4x4_dup(node->gl.static_model, m);
+	state.statics.nodes[state.statics.nodes_count++] = node;
+}
+
+static unsigned char statics_texture_equal(const kgfw_graphics_texture_t * a, const kgfw_graphics_texture_t * b) {
+	return a->bitmap == b->bitmap && a->width == b->width && a->height == b->height && a->fmt == b->fmt && a->u_wrap == b->u_wrap && a->v_wrap == b->v_wrap && a->filtering == b->filtering;
+}
+
+/* every node owns its texture objects, so nodes batch together when their textures came from the same source */
+static unsigned char statics_compatible(const mesh_node_t * a, const mesh_node_t * b) {
+	return statics_texture_equal(&a->gl.tex_source, &b->gl.tex_source) && statics_texture_equal(&a->gl.normal_source, &b->gl.normal_source) && a->gl.unlit == b->gl.unlit && a->gl.source->vertex_format == b->gl.source->vertex_format;
+}
+
+static mesh_node_t * statics_batch(mesh_node_t ** nodes, unsigned long long int nodes_count) {
+	kgfw_graphics_mesh_t combined = {
+		.pos = { 0, 0, 0 },
+		.rot = { 0, 0, 0 },
+		.scale = { 1, 1, 1 },
+		.vertex_format = nodes[0]->gl.source->vertex_format,
+	};
+
+	for (unsigned long long int i = 0; i < nodes_count; ++i) {
+		combined.vertices_count += nodes[i]->gl.source->vertices_count;
+		combined.indices_count += nodes[i]->gl.source->indices_count;
+	}
+
+	combined.vertices = kgfw_memory_alloc(sizeof(kgfw_graphics_vertex_t) * combined.vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	combined.indices = kgfw_memory_alloc(sizeof(unsigned int) * combined.indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (combined.vertices == NULL || combined.indices == NULL || combined.vertices_count > 0xFFFFFFFF) {
+		kgfw_memory_free(combined.vertices);
+		kgfw_memory_free(combined.indices);
+		return NULL;
+	}
+
+	unsigned long long int vertex = 0;
+	unsigned long long int index = 0;
+	for (unsigned long long int i = 0; i < nodes_count; ++i) {
+		const kgfw_graphics_mesh_t * source = nodes[i]->gl.source;
+		kgfw_mat4_t * m = (kgfw_mat4_t *) nodes[i]->gl.static_model;
+		kgfw_graphics_vertex_t * out = &combined.vertices[vertex];
+		memcpy(out, source->vertices, sizeof(kgfw_graphics_vertex_t) * source->vertices_count);
+		kgfw_mat4_transform_batch(m, &out->x, sizeof(kgfw_graphics_vertex_t), source->vertices_count, 1);
+		/* the vertex shader transforms normals by the model matrix as well, so this matches unbatched drawing */
+		kgfw_mat4_transform_batch(m, &out->nx, sizeof(kgfw_graphics_vertex_t), source->vertices_count, 0);
+		for (unsigned long long int v = 0; v < source->vertices_count; ++v) {
+			float length = sqrtf(out[v].nx * out[v].nx + out[v].ny * out[v].ny + out[v].nz * out[v].nz);
+			if (length > 0) {
+				length = 1.0f / length;
+				out[v].nx *= length;
+				out[v].ny *= length;
+				out[v].nz *= length;
+			}
+		}
+
+		for (unsigned long long int j = 0; j < source->indices_count; ++j) {
+			combined.indices[index + j] = (unsigned int) (source->indices[j] + vertex);
+		}
+
+		vertex += source->vertices_count;
+		index += source->indices_count;
+	}
+
+	mesh_node_t * batch = meshes_new();
+	if (batch != NULL) {
+		mesh_upload(batch, &combined);
+		batch->gl.tex = nodes[0]->gl.tex;
+		batch->gl.normal = nodes[0]->gl.normal;
+		batch->gl.unlit = nodes[0]->gl.unlit;
+	}
+
+	kgfw_memory_free(combined.vertices);
+	kgfw_memory_free(combined.indices);
+	return batch;
+}
+
+static void statics_rebuild(void) {
+	statics_clear();
+	state.statics.dirty = 0;
+	if (state.statics.nodes_count == 0) {
+		return;
+	}
+
+	state.statics.batches = kgfw_memory_alloc(sizeof(mesh_node_t *) * state.statics.nodes_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (state.statics.batches == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to allocate static batches");
+		state.statics.nodes_count = 0;
+		return;
+	}
+
+	/* partition the collected nodes in place so every compatible run is contiguous */
+	mesh_node_t ** nodes = state.statics.nodes;
+	unsigned long long int begin = 0;
+	while (begin < state.statics.nodes_count) {
+		unsigned long long int end = begin + 1;
+		for (unsigned long long int i = end; i < state.statics.nodes_count; ++i) {
+			if (statics_compatible(nodes[begin], nodes[i])) {
+				mesh_node_t * swap = nodes[end];
+				nodes[end] = nodes[i];
+				nodes[i] = swap;
+				++end;
+			}
+		}
+
+		mesh_node_t * batch = statics_batch(nodes + begin, end - begin);
+		if (batch == NULL) {
+			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to build static batch of %llu nodes", end - begin);
+		}
+		else {
+			state.statics.batches[state.statics.batches_count++] = batch;
+		}
+		begin = end;
+	}
+
+	kgfw_logf(KGFW_LOG_SEVERITY_INFO, "batched %llu static nodes into %llu draws", state.statics.nodes_count, state.statics.batches_count);
+	state.statics.nodes_count = 0;
+}
+
+static void statics_draw(void) {
+	mat4x4 m;
+	for (unsigned long long int i = 0; i < state.statics.batches_count; ++i) {
+		mat4x4_identity(recurse_state.model);
+		memset(recurse_state.pos, 0, sizeof(vec3));
+		kgfw_quat_identity(&recurse_state.rot);
+		recurse_state.scale[0] = 1;
+		recurse_state.scale[1] = 1;
+		recurse_state.scale[2] = 1;
+		mesh_draw(state.statics.batches[i], m);
+	}
+}
+
+static void statics_clear(void) {
+	for (unsigned long long int i = 0; i < state.statics.batches_count; ++i) {
+		/* textures belong to the source nodes */
+		state.statics.batches[i]->gl.tex = 0;
+		state.statics.batches[i]->gl.normal = 0;
+		meshes_free(state.statics.batches[i]);
+	}
+	kgfw_memory_free(state.statics.batches);
+	state.statics.batches = NULL;
+	state.statics.batches_count = 0;
+}
+
+static void occlusion_init(void) {
+	const GLchar * vsource =
+		"#version 330 core\n"
+		"layout(location = 0) in vec3 in_pos; uniform mat4 unif_mvp; void main() { gl_Position = unif_mvp * vec4(in_pos, 1.0); }";
+	const GLchar * fsource =
+		"#version 330 core\n"
+		"out vec4 out_color; void main() { out_color = vec4(0); }";
+	static const float corners[24] = {
+		-1, -1, -1,   1, -1, -1,   -1, 1, -1,   1, 1, -1,
+		-1, -1, 1,    1, -1, 1,    -1, 1, 1,    1, 1, 1,
+	};
+	static const unsigned char indices[36] = {
+		0, 2, 1,  1, 2, 3,  4, 5, 6,  5, 7, 6,
+		0, 1, 4,  1, 5, 4,  2, 6, 3,  3, 6, 7,
+		0, 4, 2,  2, 4, 6,  1, 3, 5,  3, 7, 5,
+	};
+
+	GLuint vert = GL_CALL(glCreateShader(GL_VERTEX_SHADER));
+	GLuint frag = GL_CALL(glCreateShader(GL_FRAGMENT_SHADER));
+	shader_source(vert, vsource, "");
+	shader_source(frag, fsource, "");
+	GL_CALL(glCompileShader(vert));
+	GL_CALL(glCompileShader(frag));
+
+	GLuint program = GL_CALL(glCreateProgram());
+	GL_CALL(glAttachShader(program, vert));
+	GL_CALL(glAttachShader(program, frag));
+	GL_CALL(glLinkProgram(program));
+	GL_CALL(glDetachShader(program, vert));
+	GL_CALL(glDetachShader(program, frag));
+	GL_CALL(glDeleteShader(vert));
+	GL_CALL(glDeleteShader(frag));
+
+	GLint success = GL_FALSE;
+	GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &success));
+	if (success == GL_FALSE) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to build occlusion query program, occlusion culling is unavailable");
+		GL_CALL(glDeleteProgram(program));
+		return;
+	}
+
+	state.occlusion.program = program;
+	state.occlusion.unif_mvp = GL_CALL(glGetUniformLocation(program, "unif_mvp"));
+
+	GL_CALL(glGenVertexArrays(1, &state.occlusion.vao));
+	GL_CALL(glGenBuffers(1, &state.occlusion.vbo));
+	GL_CALL(glGenBuffers(1, &state.occlusion.ibo));
+	GL_CALL(glBindVertexArray(state.occlusion.vao));
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, state.occlusion.vbo));
+	GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW));
+	GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.occlusion.ibo));
+	GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW));
+	GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, NULL));
+	GL_CALL(glEnableVertexAttribArray(0));
+	GL_CALL(glBindVertexArray(0));
+}
+
+static void occlusion_deinit(void) {
+	if (state.occlusion.program != 0) {
+		GL_CALL(glDeleteProgram(state.occlusion.program));
+		GL_CALL(glDeleteVertexArrays(1, &state.occlusion.vao));
+		GL_CALL(glDeleteBuffers(1, &state.occlusion.vbo));
+		GL_CALL(glDeleteBuffers(1, &state.occlusion.ibo));
+	}
+	state.occlusion.program = 0;
+	state.occlusion.vao = 0;
+	state.occlusion.vbo = 0;
+	state.occlusion.ibo = 0;
+}
+
+static void lights_init(void) {
+	static const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+	GL_CALL(glGenBuffers(3, state.lights.buffers));
+	GL_CALL(glGenTextures(3, state.lights.textures));
+	for (unsigned int i = 0; i < 3; ++i) {
+		GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, state.lights.buffers[i]));
+		GL_CALL(glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW));
+		GL_CALL(glBindTexture(GL_TEXTURE_BUFFER, state.lights.textures[i]));
+		GL_CALL(glTexBuffer(GL_TEXTURE_BUFFER, formats[i], state.lights.buffers[i]));
+	}
+	GL_CALL(glBindTexture(GL_TEXTURE_BUFFER, 0));
+	GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+}
+
+static void lights_deinit(void) {
+	GL_CALL(glDeleteTextures(3, state.lights.textures));
+	GL_CALL(glDeleteBuffers(3, state.lights.buffers));
+	memset(state.lights.textures, 0, sizeof(state.lights.textures));
+	memset(state.lights.buffers, 0, sizeof(state.lights.buffers));
+	memset(state.lights.used, 0, sizeof(state.lights.used));
+	state.lights.count = 0;
+}
+
+static int light_tile(float ndc, int tiles) {
+	int tile = (int) floorf((ndc * 0.5f + 0.5f) * tiles);
+	return (tile < 0) ? 0 : (tile >= tiles) ? tiles - 1 : tile;
+}
+
+static int light_slice(float depth) {
+	int slice = (int) floorf(logf(depth) * state.lights.depth_scale + state.lights.depth_bias);
+	return (slice < 0) ? 0 : (slice >= KGFW_GRAPHICS_GL_CLUSTERS_Z) ? KGFW_GRAPHICS_GL_CLUSTERS_Z - 1 : slice;
+}
+
+/* assigns every light to the clusters its bounding sphere touches and uploads the result for the fragment shader */
+static void lights_cluster(mat4x4 v, mat4x4 p, GLint viewport[4]) {
+	float nplane = (state.camera->nplane > 0.001f) ? state.camera->nplane : 0.001f;
+	float fplane = (state.camera->fplane > nplane) ? state.camera->fplane : nplane * 2;
+
+	mat4x4_dup(state.lights.v, v);
+	state.lights.viewport[0] = viewport[0];
+	state.lights.viewport[1] = viewport[1];
+	state.lights.viewport[2] = viewport[2];
+	state.lights.viewport[3] = viewport[3];
+	state.lights.depth_scale = KGFW_GRAPHICS_GL_CLUSTERS_Z / logf(fplane / nplane);
+	state.lights.depth_bias = -logf(nplane) * state.lights.depth_scale;
+
+	state.lights.visible = 0;
+	for (unsigned int i = 0; i < state.lights.count; ++i) {
+		kgfw_graphics_light_t * light = &state.lights.lights[i];
+		float r = light->radius;
+		if (!state.lights.used[i] || r <= 0) {
+			continue;
+		}
+
+		vec4 world = { light->pos[0], light->pos[1], light->pos[2], 1 };
+		vec4 view;
+		mat4x4_mul_vec4(view, v, world);
+
+		/* view space looks down -z */
+		float znear = -view[2] - r;
+		float zfar = -view[2] + r;
+		if (zfar < nplane || znear > fplane) {
+			continue;
+		}
+
+		int x0 = 0;
+		int x1 = KGFW_GRAPHICS_GL_CLUSTERS_X - 1;
+		int y0 = 0;
+		int y1 = KGFW_GRAPHICS_GL_CLUSTERS_Y - 1;
+		if (znear > nplane) {
+			/* the bounding box is entirely in front of the camera, so its projected corners bound the sphere on screen */
+			float min_x = FLT_MAX;
+			float max_x = -FLT_MAX;
+			float min_y = FLT_MAX;
+			float max_y = -FLT_MAX;
+			for (unsigned int c = 0; c < 8; ++c) {
+				vec4 corner = { view[0] + ((c & 1) ? r : -r), view[1] + ((c & 2) ? r : -r), view[2] + ((c & 4) ? r : -r), 1 };
+				vec4 clip;
+				mat4x4_mul_vec4(clip, p, corner);
+				min_x = fminf(min_x, clip[0] / clip[3]);
+				max_x = fmaxf(max_x, clip[0] / clip[3]);
+				min_y = fminf(min_y, clip[1] / clip[3]);
+				max_y = fmaxf(max_y, clip[1] / clip[3]);
+			}
+
+			if (max_x < -1 || min_x > 1 || max_y < -1 || min_y > 1) {
+				continue;
+			}
+
+			x0 = light_tile(min_x, KGFW_GRAPHICS_GL_CLUSTERS_X);
+			x1 = light_tile(max_x, KGFW_GRAPHICS_GL_CLUSTERS_X);
+			y0 = light_tile(min_y, KGFW_GRAPHICS_GL_CLUSTERS_Y);
+			y1 = light_tile(max_y, KGFW_GRAPHICS_GL_CLUSTERS_Y);
+		}
+
+		unsigned int index = state.lights.visible++;
+		float * packed = &state.lights.packed[index * 8];
+		packed[0] = light->pos[0];
+		packed[1] = light->pos[1];
+		packed[2] = light->pos[2];
+		packed[3] = r;
+		packed[4] = light->color[0] * light->intensity;
+		packed[5] = light->color[1] * light->intensity;
+		packed[6] = light->color[2] * light->intensity;
+		packed[7] = 0;
+
+		unsigned char * range = state.lights.ranges[index];
+		range[0] = x0;
+		range[1] = x1;
+		range[2] = y0;
+		range[3] = y1;
+		range[4] = light_slice(fmaxf(znear, nplane));
+		range[5] = light_slice(fminf(zfar, fplane));
+	}
+
+	/* count, turn counts into offsets, then fill */
+	unsigned int * clusters = state.lights.clusters;
+	memset(clusters, 0, sizeof(state.lights.clusters));
+	for (unsigned int l = 0; l < state.lights.visible; ++l) {
+		unsigned char * range = state.lights.ranges[l];
+		for (unsigned int z = range[4]; z <= range[5]; ++z) {
+			for (unsigned int y = range[2]; y <= range[3]; ++y) {
+				for (unsigned int x = range[0]; x <= range[1]; ++x) {
+					++clusters[(x + KGFW_GRAPHICS_GL_CLUSTERS_X * (y + KGFW_GRAPHICS_GL_CLUSTERS_Y * z)) * 2 + 1];
+				}
+			}
+		}
+	}
+
+	unsigned int offset = 0;
+	state.lights.dropped = 0;
+	for (unsigned int c = 0; c < KGFW_GRAPHICS_GL_CLUSTERS; ++c) {
+		unsigned int count = clusters[c * 2 + 1];
+		if (offset + count > KGFW_GRAPHICS_GL_CLUSTER_INDICES_MAX) {
+			state.lights.dropped += offset + count - KGFW_GRAPHICS_GL_CLUSTER_INDICES_MAX;
+			count = KGFW_GRAPHICS_GL_CLUSTER_INDICES_MAX - offset;
+		}
+		clusters[c * 2] = offset;
+		clusters[c * 2 + 1] = 0;
+		offset += count;
+	}
+	state.lights.indices_count = offset;
+
+	for (unsigned int l = 0; l < state.lights.visible; ++l) {
+		unsigned char * range = state.lights.ranges[l];
+		for (unsigned int z = range[4]; z <= range[5]; ++z) {
+			for (unsigned int y = range[2]; y <= range[3]; ++y) {
+				for (unsigned int x = range[0]; x <= range[1]; ++x) {
+					unsigned int c = x + KGFW_GRAPHICS_GL_CLUSTERS_X * (y + KGFW_GRAPHICS_GL_CLUSTERS_Y * z);
+					unsigned int end = (c + 1 < KGFW_GRAPHICS_GL_CLUSTERS) ? clusters[(c + 1) * 2] : offset;
+					if (clusters[c * 2] + clusters[c * 2 + 1] < end) {
+						state.lights.indices[clusters[c * 2] + clusters[c * 2 + 1]++] = l;
+					}
+				}
+			}
+		}
+	}
+
+	/* respecifying the whole store every frame lets the driver orphan the previous one instead of waiting on it */
+	GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, state.lights.buffers[0]));
+	GL_CALL(glBufferData(GL_TEXTURE_BUFFER, sizeof(float) * 8 * ((state.lights.visible > 0) ? state.lights.visible : 1), state.lights.packed, GL_STREAM_DRAW));
+	GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, state.lights.buffers[1]));
+	GL_CALL(glBufferData(GL_TEXTURE_BUFFER, sizeof(state.lights.clusters), state.lights.clusters, GL_STREAM_DRAW));
+	GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, state.lights.buffers[2]));
+	GL_CALL(glBufferData(GL_TEXTURE_BUFFER, sizeof(unsigned short int) * ((offset > 0) ? offset : 1), state.lights.indices, GL_STREAM_DRAW));
+	GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+	for (unsigned int i = 0; i < 3; ++i) {
+		GL_CALL(glActiveTexture(GL_TEXTURE0 + KGFW_GRAPHICS_GL_LIGHTS_UNIT + i));
+		GL_CALL(glBindTexture(GL_TEXTURE_BUFFER, state.lights.textures[i]));
+	}
+	GL_CALL(glActiveTexture(GL_TEXTURE0));
+}
+
+static int offscreen_init(unsigned int width, unsigned int height) {
+	GL_CALL(glGenFramebuffers(1, &state.offscreen.fbo));
+	GL_CALL(glGenRenderbuffers(1, &state.offscreen.color));
+	GL_CALL(glGenRenderbuffers(1, &state.offscreen.depth));
+
+	/* srgb to match the default framebuffer since GL_FRAMEBUFFER_SRGB is enabled */
+	GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, state.offscreen.color));
+	GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_SRGB8_ALPHA8, width, height));
+	GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, state.offscreen.depth));
+	GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
+	GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, state.offscreen.fbo));
+	GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, state.offscreen.color));
+	GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, state.offscreen.depth));
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "offscreen framebuffer incomplete 0x%X", status);
+		offscreen_deinit();
+		return 1;
+	}
+
+	/* stays bound for the lifetime of the context, nothing else binds framebuffers */
+	GL_CALL(glViewport(0, 0, width, height));
+	return 0;
+}
+
+static void offscreen_deinit(void) {
+	if (state.offscreen.fbo == 0) {
+		return;
+	}
 
-	free(node);
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GL_CALL(glDeleteFramebuffers(1, &state.offscreen.fbo));
+	GL_CALL(glDeleteRenderbuffers(1, &state.offscreen.color));
+	GL_CALL(glDeleteRenderbuffers(1, &state.offscreen.depth));
+	state.offscreen.fbo = 0;
+	state.offscreen.color = 0;
+	state.offscreen.depth = 0;
 }
 
-static void meshes_gen(mesh_node_t * node) {
-	GL_CALL(glGenVertexArrays(1, &node->gl.vao));
-	GL_CALL(glGenBuffers(1, &node->gl.vbo));
-	GL_CALL(glGenBuffers(1, &node->gl.ibo));
-	node->gl.tex = 0;
-	node->gl.normal = 0;
+static void profile_init(void) {
+	state.profile.trace = kgfw_memory_calloc(KGFW_GRAPHICS_GL_PROFILE_TRACE_EVENTS, sizeof(gl_profile_event_t), KGFW_MEMORY_TAG_GRAPHICS);
+	if (state.profile.trace == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to allocate gpu trace buffer, trace export is disabled");
+	}
+
+	for (unsigned int i = 0; i < KGFW_GRAPHICS_GL_PROFILE_FRAMES; ++i) {
+		GL_CALL(glGenQueries(KGFW_GRAPHICS_GL_PROFILE_SCOPES * 2, state.profile.frames[i].queries));
+		state.profile.frames[i].count = 0;
+		state.profile.frames[i].pending = 0;
+	}
+	state.profile.initialized = 1;
 }
 
-static mesh_node_t * meshes_new(void) {
-	mesh_node_t * m = meshes_alloc();
-	if (m == NULL) {
-		return NULL;
+static void profile_deinit(void) {
+	if (!state.profile.initialized) {
+		return;
 	}
 
-	meshes_gen(m);
-	return m;
+	for (unsigned int i = 0; i < KGFW_GRAPHICS_GL_PROFILE_FRAMES; ++i) {
+		GL_CALL(glDeleteQueries(KGFW_GRAPHICS_GL_PROFILE_SCOPES * 2, state.profile.frames[i].queries));
+	}
+	kgfw_memory_free(state.profile.trace);
+	state.profile.trace = NULL;
+	state.profile.initialized = 0;
 }
 
-static void mesh_transform(mesh_node_t * mesh, mat4x4 out_m) {
-	if (mesh->transform.absolute) {
-		mat4x4_identity(out_m);
-		mat4x4_translate(out_m, recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[0] + mesh->transform.pos[2]);
-		recurse_state.pos[0] = mesh->transform.pos[0];
-		recurse_state.pos[1] = mesh->transform.pos[1];
-		recurse_state.pos[2] = mesh->transform.pos[2];
-		recurse_state.rot[0] = mesh->transform.rot[0];
-		recurse_state.rot[1] = mesh->transform.rot[1];
-		recurse_state.rot[2] = mesh->transform.rot[2];
-		recurse_state.scale[0] = mesh->transform.scale[0];
-		recurse_state.scale[1] = mesh->transform.scale[1];
-		recurse_state.scale[2] = mesh->transform.scale[2];
-	} else {
-		mat4x4_translate_in_place(out_m, recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[2] + mesh->transform.pos[2]);
-		recurse_state.pos[0] += mesh->transform.pos[0];
-		recurse_state.pos[1] += mesh->transform.pos[1];
-		recurse_state.pos[2] += mesh->transform.pos[2];
-		recurse_state.rot[0] += mesh->transform.rot[0];
-		recurse_state.rot[1] += mesh->transform.rot[1];
-		recurse_state.rot[2] += mesh->transform.rot[2];
-		recurse_state.scale[0] *= mesh->transform.scale[0];
-		recurse_state.scale[1] *= mesh->transform.scale[1];
-		recurse_state.scale[2] *= mesh->transform.scale[2];
+static gl_profile_stat_t * profile_stat(const char * name) {
+	for (unsigned int i = 0; i < state.profile.stats_count; ++i) {
+		if (state.profile.stats[i].name == name || strcmp(state.profile.stats[i].name, name) == 0) {
+			return &state.profile.stats[i];
+		}
+	}
+
+	if (state.profile.stats_count >= KGFW_GRAPHICS_GL_PROFILE_STATS) {
+		return NULL;
 	}
-	mat4x4_identity(recurse_state.model_r);
-	mat4x4_rotate_X(out_m, out_m, (recurse_state.rot[0]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Y(out_m, out_m, (recurse_state.rot[1]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Z(out_m, out_m, (recurse_state.rot[2]) * 3.141592f / 180.0f);
-	mat4x4_rotate_X(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[0]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Y(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[1]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Z(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[2]) * 3.141592f / 180.0f);
-	mat4x4_scale_aniso(out_m, out_m, recurse_state.scale[0], recurse_state.scale[1], recurse_state.scale[2]);
+
+	gl_profile_stat_t * stat = &state.profile.stats[state.profile.stats_count++];
+	memset(stat, 0, sizeof(*stat));
+	stat->name = name;
+	return stat;
 }
 
-static void mesh_draw(mesh_node_t * mesh, mat4x4 out_m) {
-	if (mesh == NULL || out_m == NULL) {
+/* reads back a finished frame, if the gpu is still behind the frame is dropped rather than waited on */
+static void profile_resolve(gl_profile_frame_t * frame) {
+	if (!frame->pending) {
 		return;
 	}
-	if (mesh->gl.vbo_size == 0 || mesh->gl.ibo_size == 0 || mesh->gl.vbo == 0 || mesh->gl.ibo == 0) {
+	frame->pending = 0;
+
+	GLint available = 0;
+	GL_CALL(glGetQueryObjectiv(frame->queries[frame->last], GL_QUERY_RESULT_AVAILABLE, &available));
+	if (!available) {
+		++state.profile.dropped;
 		return;
 	}
 
-	GLuint program = (mesh->gl.program == 0) ? state.program : mesh->gl.program;
-	GL_CALL(glUseProgram(program));
-	GLint uniform_model = GL_CALL(glGetUniformLocation(program, "unif_m"));
-	GLint uniform_vp = GL_CALL(glGetUniformLocation(program, "unif_vp"));
-	GLint uniform_time = GL_CALL(glGetUniformLocation(program, "unif_time"));
-	GLint uniform_view = GL_CALL(glGetUniformLocation(program, "unif_view_pos"));
-	GLint uniform_textured_color = GL_CALL(glGetUniformLocation(program, "unif_textured_color"));
-	GLint uniform_textured_normal = GL_CALL(glGetUniformLocation(program, "unif_textured_normal"));
-	GLint uniform_texture_color = GL_CALL(glGetUniformLocation(program, "unif_texture_color"));
-	GLint uniform_texture_normal = GL_CALL(glGetUniformLocation(program, "unif_texture_normal"));
+	/* names repeat within a frame for per material scopes, they are summed before feeding the averages */
+	double frame_ms[KGFW_GRAPHICS_GL_PROFILE_STATS] = { 0 };
+	unsigned long long int frame_calls[KGFW_GRAPHICS_GL_PROFILE_STATS] = { 0 };
+	for (unsigned int i = 0; i < frame->count; ++i) {
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		GL_CALL(glGetQueryObjectui64v(frame->queries[i * 2 + 0], GL_QUERY_RESULT, &begin));
+		GL_CALL(glGetQueryObjectui64v(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &end));
+		unsigned long long int duration = (end > begin) ? end - begin : 0;
+
+		gl_profile_stat_t * stat = profile_stat(frame->names[i]);
+		if (stat != NULL) {
+			frame_ms[stat - state.profile.stats] += duration / 1000000.0;
+			++frame_calls[stat - state.profile.stats];
+		}
 
-	mat4x4_identity(out_m);
-	mesh_transform(mesh, out_m);
+		if (state.profile.trace != NULL) {
+			gl_profile_event_t * event = &state.profile.trace[state.profile.trace_head % KGFW_GRAPHICS_GL_PROFILE_TRACE_EVENTS];
+			event->name = frame->names[i];
+			event->frame = frame->index;
+			event->start_ns = begin;
+			event->duration_ns = duration;
+			event->depth = frame->depths[i];
+			++state.profile.trace_head;
+		}
+	}
 
-	GL_CALL(glUniformMatrix4fv(uniform_model, 1, GL_FALSE, &out_m[0][0]));
-	GL_CALL(glUniformMatrix4fv(uniform_vp, 1, GL_FALSE, &state.vp[0][0]));
-	GL_CALL(glUniform1f(uniform_time, kgfw_time_get()));
-	GL_CALL(glUniform3f(uniform_view, state.camera->pos[0], state.camera->pos[1], state.camera->pos[2]));
+	for (unsigned int i = 0; i < state.profile.stats_count; ++i) {
+		gl_profile_stat_t * stat = &state.profile.stats[i];
+		if (frame_calls[i] == 0) {
+			continue;
+		}
 
-	GL_CALL(glUniform1i(uniform_texture_color, 0));
-	if (mesh->gl.tex == 0) {
-		GL_CALL(glUniform1f(uniform_textured_color, 0));
-		GL_CALL(glActiveTexture(GL_TEXTURE0));
-		GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-	} else {
-		GL_CALL(glUniform1f(uniform_textured_color, 1));
-		GL_CALL(glActiveTexture(GL_TEXTURE0));
-		GL_CALL(glBindTexture(GL_TEXTURE_2D, mesh->gl.tex));
+		stat->last_ms = frame_ms[i];
+		stat->calls = frame_calls[i];
+		stat->average_ms = (stat->average_ms == 0) ? frame_ms[i] : stat->average_ms * 0.95 + frame_ms[i] * 0.05;
+		if (frame_ms[i] > stat->max_ms) {
+			stat->max_ms = frame_ms[i];
+		}
 	}
+	++state.profile.resolved;
+}
 
-	GL_CALL(glUniform1i(uniform_texture_normal, 1));
-	if (mesh->gl.normal == 0) {
-		GL_CALL(glUniform1f(uniform_textured_normal, 0));
-		GL_CALL(glActiveTexture(GL_TEXTURE1));
-		GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-	} else {
-		GL_CALL(glUniform1f(uniform_textured_normal, 1));
-		GL_CALL(glActiveTexture(GL_TEXTURE1));
-		GL_CALL(glBindTexture(GL_TEXTURE_2D, mesh->gl.normal));
+static void profile_frame_begin(void) {
+	if (!state.profile.enabled || !state.profile.initialized) {
+		return;
 	}
 
-	GL_CALL(glBindVertexArray(mesh->gl.vao));
-	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mesh->gl.vbo));
-	GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->gl.ibo));
-	//GL_CALL(glDrawArrays(GL_TRIANGLES, 0, mesh->gl.vbo_size));
-	GL_CALL(glDrawElements(GL_TRIANGLES, mesh->gl.ibo_size, GL_UNSIGNED_INT, 0));
+	++state.profile.frame;
+	gl_profile_frame_t * frame = &state.profile.frames[state.profile.frame % KGFW_GRAPHICS_GL_PROFILE_FRAMES];
+	profile_resolve(frame);
+	frame->count = 0;
+	frame->index = state.profile.frame;
+	state.profile.depth = 0;
 }
 
-static void meshes_draw_recursive(mesh_node_t * mesh) {
-	if (mesh == NULL) {
+static void profile_frame_end(void) {
+	if (!state.profile.enabled || !state.profile.initialized) {
 		return;
 	}
 
-	mesh_draw(mesh, recurse_state.model);
-	if (mesh->child == NULL) {
-		return;
+	gl_profile_frame_t * frame = &state.profile.frames[state.profile.frame % KGFW_GRAPHICS_GL_PROFILE_FRAMES];
+	frame->pending = (frame->count > 0);
+}
+
+/* returns the scope to pass to profile_end, scopes past the per frame limit are not timed */
+static int profile_begin(const char * name) {
+	if (!state.profile.enabled || !state.profile.initialized) {
+		return -1;
 	}
 
-	meshes_draw_recursive_fchild(mesh->child);
+	gl_profile_frame_t * frame = &state.profile.frames[state.profile.frame % KGFW_GRAPHICS_GL_PROFILE_FRAMES];
+	if (frame->count >= KGFW_GRAPHICS_GL_PROFILE_SCOPES) {
+		return -1;
+	}
+
+	unsigned int scope = frame->count++;
+	frame->names[scope] = name;
+	frame->depths[scope] = (unsigned char) state.profile.depth++;
+	GL_CALL(glQueryCounter(frame->queries[scope * 2], GL_TIMESTAMP));
+	frame->last = scope * 2;
+	return (int) scope;
 }
 
-static void meshes_draw_recursive_fchild(mesh_node_t * mesh) {
-	if (mesh == NULL) {
+static void profile_end(int scope) {
+	if (scope < 0) {
 		return;
 	}
 
-	vec3 pos;
-	vec3 rot;
-	vec3 scale;
-	memcpy(pos, recurse_state.pos, sizeof(pos));
-	memcpy(rot, recurse_state.rot, sizeof(rot));
-	memcpy(scale, recurse_state.scale, sizeof(scale));
+	gl_profile_frame_t * frame = &state.profile.frames[state.profile.frame % KGFW_GRAPHICS_GL_PROFILE_FRAMES];
+	GL_CALL(glQueryCounter(frame->queries[scope * 2 + 1], GL_TIMESTAMP));
+	frame->last = scope * 2 + 1;
+	--state.profile.depth;
+}
 
-	meshes_draw_recursive(mesh);
-	for (mesh_node_t * m = mesh;;) {
-		m = m->sibling;
-		if (m == NULL) {
-			break;
-		}
+static void profile_reset(void) {
+	state.profile.stats_count = 0;
+	state.profile.trace_head = 0;
+	state.profile.resolved = 0;
+	state.profile.dropped = 0;
+}
 
-		memcpy(recurse_state.pos, pos, sizeof(pos));
-		memcpy(recurse_state.rot, rot, sizeof(rot));
-		memcpy(recurse_state.scale, scale, sizeof(scale));
-		meshes_draw_recursive(m);
+/* chrome trace event format, loads in chrome://tracing and perfetto */
+static int profile_trace_export(const char * path) {
+	if (state.profile.trace == NULL) {
+		return 1;
 	}
-}
 
-static void meshes_free_recursive(mesh_node_t * mesh) {
-	if (mesh == NULL) {
-		return;
+	FILE * fp = fopen(path, "wb");
+	if (fp == NULL) {
+		return 2;
 	}
 
-	if (mesh->child != NULL) {
-		meshes_free_recursive_fchild(mesh->child);
+	unsigned long long int count = (state.profile.trace_head < KGFW_GRAPHICS_GL_PROFILE_TRACE_EVENTS) ? state.profile.trace_head : KGFW_GRAPHICS_GL_PROFILE_TRACE_EVENTS;
+	unsigned long long int first = state.profile.trace_head - count;
+	unsigned long long int origin = (count > 0) ? state.profile.trace[first % KGFW_GRAPHICS_GL_PROFILE_TRACE_EVENTS].start_ns : 0;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (unsigned long long int i = 0; i < count; ++i) {
+		gl_profile_event_t * event = &state.profile.trace[(first + i) % KGFW_GRAPHICS_GL_PROFILE_TRACE_EVENTS];
+		unsigned long long int start = (event->start_ns > origin) ? event->start_ns - origin : 0;
+		fprintf(fp, "{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu,\"depth\":%u}}%s\n", event->name, start / 1000.0, event->duration_ns / 1000.0, event->frame, event->depth, (i + 1 < count) ? "," : "");
 	}
+	fprintf(fp, "]}\n");
 
-	meshes_free(mesh);
+	if (fclose(fp) != 0) {
+		return 3;
+	}
+	return 0;
 }
 
-static void meshes_free_recursive_fchild(mesh_node_t * mesh) {
-	if (mesh == NULL) {
-		return;
+/* the driver strings are part of the key so a driver update invalidates the cache */
+static kgfw_hash_t program_cache_key(const char * vsource, const char * fsource, const char * defines) {
+	const char * strings[6] = {
+		vsource,
+		fsource,
+		defines,
+		(const char *) glGetString(GL_VENDOR),
+		(const char *) glGetString(GL_RENDERER),
+		(const char *) glGetString(GL_VERSION),
+	};
+
+	kgfw_hash_t key = 5381;
+	for (unsigned int i = 0; i < 6; ++i) {
+		key = (key << 5) + key + ((strings[i] == NULL) ? 0 : kgfw_hash(strings[i]));
 	}
 
-	mesh_node_t * sibling = mesh->sibling;
-	for (mesh_node_t * m = mesh;;) {
-		m = sibling;
-		if (m == NULL) {
-			break;
-		}
-		sibling = m->sibling;
+	return key;
+}
 
-		meshes_free_recursive(m);
+static int program_cache_load(GLuint program, kgfw_hash_t key) {
+	if (!state.program_binary.supported) {
+		return 1;
 	}
-	meshes_free_recursive(mesh);
-}
 
-static void update_settings(unsigned int change) {
-	if (change &KGFW_GRAPHICS_SETTINGS_VSYNC) {
-		if (state.window != NULL) {
-			glfwSwapInterval((state.settings &KGFW_GRAPHICS_SETTINGS_VSYNC));
-		}
+	char path[256];
+	snprintf(path, sizeof(path), KGFW_GRAPHICS_GL_PROGRAM_CACHE_FMT, (unsigned long long int) key);
+	FILE * fp = fopen(path, "rb");
+	if (fp == NULL) {
+		return 2;
 	}
-}
 
-static int gfx_command(int argc, char ** argv) {
-	const char * subcommands = "set    enable    disable    reload";
-	if (argc < 2) {
-		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "subcommands: %s", subcommands);
-		return 0;
+	gl_program_cache_header_t header;
+	if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != KGFW_GRAPHICS_GL_PROGRAM_CACHE_MAGIC || header.key != key) {
+		fclose(fp);
+		return 3;
 	}
 
-	if (strcmp("reload", argv[1]) == 0) {
-		const char * options = "vsync";
-		const char * arguments = "[option]    see 'gfx options'";
-		if (argc < 3) {
-			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
-			return 0;
+	/* the length comes from the file, a truncated or corrupt one must not drive the allocation */
+	long start = ftell(fp);
+	long end = -1;
+	if (start >= 0 && fseek(fp, 0, SEEK_END) == 0) {
+		end = ftell(fp);
+		if (fseek(fp, start, SEEK_SET) != 0) {
+			end = -1;
 		}
+	}
+	if (end < start || header.length != (unsigned long long int) (end - start)) {
+		fclose(fp);
+		return 3;
+	}
 
-		if (strcmp("shaders", argv[2]) == 0) {
-			GL_CALL(glDeleteProgram(state.program));
-			state.program = GL_CALL(glCreateProgram());
-			int r = shaders_load("assets/shaders/shader.vert", "assets/shaders/shader.frag", &state.program);
-			if (r != 0) {
-				return r;
-			}
-			return 0;
-		}
+	void * binary = kgfw_memory_alloc(header.length, KGFW_MEMORY_TAG_GRAPHICS);
+	if (binary == NULL) {
+		fclose(fp);
+		return 4;
+	}
 
-		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no option %s", argv[2]);
+	if (fread(binary, 1, header.length, fp) != header.length) {
+		kgfw_memory_free(binary);
+		fclose(fp);
+		return 3;
 	}
-	else if (strcmp("enable", argv[1]) == 0) {
-		const char * options = "vsync";
-		const char * arguments = "[option]    see 'gfx options'";
-		if (argc < 3) {
-			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
-			return 0;
-		}
+	fclose(fp);
 
-		if (strcmp("vsync", argv[2]) == 0) {
-			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_ENABLE, KGFW_GRAPHICS_SETTINGS_VSYNC);
-			return 0;
-		}
+	state.program_binary.load(program, header.format, binary, (GLsizei) header.length);
+	kgfw_memory_free(binary);
 
-		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no option %s", argv[2]);
+	/* drivers reject binaries from other versions at this point, which is not an error */
+	while (glGetError() != GL_NO_ERROR);
+	GLint success = GL_FALSE;
+	GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &success));
+	if (success == GL_FALSE) {
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "stale OpenGL program cache %s, recompiling", path);
+		return 5;
 	}
-	else if (strcmp("disable", argv[1]) == 0) {
-		const char * options = "vsync";
-		const char * arguments = "[option]    see 'gfx options'";
-		if (argc < 3) {
-			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "arguments: %s", arguments);
-			return 0;
-		}
 
-		if (strcmp("vsync", argv[2]) == 0) {
-			kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_DISABLE, KGFW_GRAPHICS_SETTINGS_VSYNC);
-			return 0;
-		}
+	return 0;
+}
 
-		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "no option %s", argv[2]);
+static int program_cache_save(GLuint program, kgfw_hash_t key) {
+	if (!state.program_binary.supported) {
+		return 1;
 	}
-	else if (strcmp("options", argv[1]) == 0) {
-		const char * options = "vsync    shaders";
-		const char * arguments = "[option]    see 'gfx options'";
-		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "options: %s", options);
+
+	GLint length = 0;
+	GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0) {
+		return 2;
 	}
-	else {
-		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "subcommands: %s", subcommands);
+
+	void * binary = kgfw_memory_alloc(length, KGFW_MEMORY_TAG_GRAPHICS);
+	if (binary == NULL) {
+		return 3;
 	}
-	return 0;
-}
 
-static void register_commands(void) {
-	kgfw_console_register_command("gfx", gfx_command);
+	gl_program_cache_header_t header = {
+		KGFW_GRAPHICS_GL_PROGRAM_CACHE_MAGIC, 0, key, 0
+	};
+
+	GLsizei written = 0;
+	GL_CALL(state.program_binary.get(program, length, &written, &header.format, binary));
+	header.length = written;
+
+	char path[256];
+	snprintf(path, sizeof(path), KGFW_GRAPHICS_GL_PROGRAM_CACHE_FMT, (unsigned long long int) key);
+	FILE * fp = fopen(path, "wb");
+	if (fp == NULL) {
+		kgfw_memory_free(binary);
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to open OpenGL program cache \"%s\" for writing", path);
+		return 4;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, fp) != 1 || fwrite(binary, 1, written, fp) != (size_t) written) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to write OpenGL program cache \"%s\"", path);
+	}
+
+	fclose(fp);
+	kgfw_memory_free(binary);
+	return 0;
 }
 
-static void gl_errors(void) {
-	GLenum err = -1;
-	while (1) {
-		err = glGetError();
-		if (err == GL_NO_ERROR) {
-			break;
-		}
-		kgfw_logf(KGFW_LOG_SEVERITY_DEBUG, "err %i", err);
+/* defines are spliced in after the #version line */
+static void shader_source(GLuint shader, const GLchar * source, const char * defines) {
+	const GLchar * body = source;
+	if (strncmp(source, "#version", 8) == 0) {
+		const GLchar * newline = strchr(source, '\n');
+		body = (newline == NULL) ? source + strlen(source) : newline + 1;
 	}
+
+	const GLchar * strings[4] = { source, "\n", defines, body };
+	GLint lengths[4] = { (GLint) (body - source), 1, (GLint) strlen(defines), -1 };
+	GL_CALL(glShaderSource(shader, 4, strings, lengths));
 }
 
-static int shaders_load(const char * vpath, const char * fpath, GLuint * out_program) {
+static int shaders_load(const char * vpath, const char * fpath, const char * defines, GLuint * out_program) {
 	const GLchar * fallback_vshader =
 		"#version 330 core\n"
 		"layout(location = 0) in vec3 in_pos; layout(location = 1) in vec3 in_color; layout(location = 2) in vec3 in_normal; layout(location = 3) in vec2 in_uv; uniform mat4 unif_m; uniform mat4 unif_vp; out vec3 v_pos; out vec3 v_color; out vec3 v_normal; out vec2 v_uv; void main() { gl_Position = unif_vp * unif_m * vec4(in_pos, 1.0); v_pos = vec3(unif_m * vec4(in_pos, 1.0)); v_color = in_color; v_normal = in_normal; v_uv = in_uv; }";
@@ -2929,7 +5529,7 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		fseek(fp, 0L, SEEK_END);
 		length = ftell(fp);
 		fseek(fp, 0L, SEEK_SET);
-		vshader = malloc(length + 1);
+		vshader = kgfw_memory_alloc(length + 1, KGFW_MEMORY_TAG_GRAPHICS);
 		if (vshader == NULL) {
 			length = 0;
 			fclose(fp);
@@ -2939,7 +5539,7 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		}
 		if (fread(vshader, 1, length, fp) != length) {
 			length = 0;
-			free(vshader);
+			kgfw_memory_free(vshader);
 			fclose(fp);
 			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to load vertex shader from \"%s\" falling back to default shader", vpath);
 			vshader = (GLchar *) fallback_vshader;
@@ -2957,7 +5557,7 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		fseek(fp, 0L, SEEK_END);
 		length = ftell(fp);
 		fseek(fp, 0L, SEEK_SET);
-		fshader = malloc(length + 1);
+		fshader = kgfw_memory_alloc(length + 1, KGFW_MEMORY_TAG_GRAPHICS);
 		if (fshader == NULL) {
 			length = 0;
 			fclose(fp);
@@ -2967,7 +5567,7 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		}
 		if (fread(fshader, 1, length, fp) != length) {
 			length = 0;
-			free(fshader);
+			kgfw_memory_free(fshader);
 			fclose(fp);
 			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to load fragment shader from \"%s\" falling back to default shader", fpath);
 			fshader = (GLchar *) fallback_fshader;
@@ -2977,8 +5577,18 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		fclose(fp);
 	end_fshader:;
 	}
+
+	GLchar * vsource = vshader;
+	GLchar * fsource = fshader;
+	double start = kgfw_time_seconds();
+	kgfw_hash_t key = program_cache_key(vsource, fsource, defines);
+	if (program_cache_load(*out_program, key) == 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "loaded shader program from cache in %.3f ms", (kgfw_time_seconds() - start) * 1000.0);
+		goto free_sources;
+	}
+
 	GLuint vert = GL_CALL(glCreateShader(GL_VERTEX_SHADER));
-	GL_CALL(glShaderSource(vert, 1, (const GLchar * const *) &vshader, NULL));
+	shader_source(vert, vshader, defines);
 	GL_CALL(glCompileShader(vert));
 	GLint success = GL_TRUE;
 	GL_CALL(glGetShaderiv(vert, GL_COMPILE_STATUS, &success));
@@ -2988,7 +5598,7 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "OpenGL user provided vertex shader compilation error: %s", msg);
 	vfallback_compilation:
 		vshader = (GLchar *) fallback_vshader;
-		GL_CALL(glShaderSource(vert, 1, (const GLchar * const *) &vshader, NULL));
+		shader_source(vert, vshader, defines);
 		GL_CALL(glCompileShader(vert));
 		GL_CALL(glGetShaderiv(vert, GL_COMPILE_STATUS, &success));
 		if (success == GL_FALSE) {
@@ -2998,7 +5608,7 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		}
 	}
 	GLuint frag = GL_CALL(glCreateShader(GL_FRAGMENT_SHADER));
-	GL_CALL(glShaderSource(frag, 1, (const GLchar * const *) &fshader, NULL));
+	shader_source(frag, fshader, defines);
 	GL_CALL(glCompileShader(frag));
 
 	GL_CALL(glGetShaderiv(frag, GL_COMPILE_STATUS, &success));
@@ -3008,7 +5618,7 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "OpenGL user provided fragment shader compilation error: %s", msg);
 	ffallback_compilation:
 		fshader = (GLchar *) fallback_fshader;
-		GL_CALL(glShaderSource(frag, 1, (const GLchar * const *) &fshader, NULL));
+		shader_source(frag, fshader, defines);
 		GL_CALL(glCompileShader(frag));
 		GL_CALL(glGetShaderiv(frag, GL_COMPILE_STATUS, &success));
 		if (success == GL_FALSE) {
@@ -3018,12 +5628,39 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 		}
 	}
 
+	if (state.program_binary.supported) {
+		GL_CALL(state.program_binary.parameteri(*out_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+	}
+
 	GL_CALL(glAttachShader(*out_program, vert));
 	GL_CALL(glAttachShader(*out_program, frag));
 	GL_CALL(glLinkProgram(*out_program));
+	GL_CALL(glDetachShader(*out_program, vert));
+	GL_CALL(glDetachShader(*out_program, frag));
 	GL_CALL(glDeleteShader(vert));
 	GL_CALL(glDeleteShader(frag));
 
+	GL_CALL(glGetProgramiv(*out_program, GL_LINK_STATUS, &success));
+	if (success == GL_FALSE) {
+		char msg[512];
+		GL_CALL(glGetProgramInfoLog(*out_program, 512, NULL, msg));
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "OpenGL shader program link error: %s", msg);
+	}
+	/* programs built from the fallback sources are not cached under the key of the user sources */
+	else if (vshader == vsource && fshader == fsource) {
+		program_cache_save(*out_program, key);
+	}
+
+	kgfw_logf(KGFW_LOG_SEVERITY_INFO, "compiled shader program in %.3f ms", (kgfw_time_seconds() - start) * 1000.0);
+
+free_sources:
+	if (vsource != fallback_vshader) {
+		kgfw_memory_free(vsource);
+	}
+	if (fsource != fallback_fshader) {
+		kgfw_memory_free(fsource);
+	}
+
 	return 0;
 }
 
@@ -3034,6 +5671,10 @@ static int shaders_load(const char * vpath, const char * fpath, GLuint * out_pro
 #include "kgfw_log.h"
 #include "kgfw_time.h"
 #include "kgfw_console.h"
+#include "kgfw_memory.h"
+#include "kgfw_math.h"
+#include "kgfw_frame.h"
+#include "kgfw_mesh.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -3063,6 +5704,7 @@ typedef struct mesh_node {
 		float rot[3];
 		float scale[3];
 		unsigned char absolute;
+		kgfw_quat_cache_t rotation;
 	} transform;
 
 	struct {
@@ -3084,6 +5726,7 @@ typedef struct mesh_node {
 
 		unsigned long long int vbo_size;
 		unsigned long long int ibo_size;
+		DXGI_FORMAT index_fmt;
 	} d3d11;
 } mesh_node_t;
 
@@ -3152,7 +5795,7 @@ struct {
 	mat4x4 model;
 	mat4x4 model_r;
 	vec3 pos;
-	vec3 rot;
+	kgfw_quat_t rot;
 	vec3 scale;
 } static recurse_state = {
 	{
@@ -3177,6 +5820,7 @@ static void meshes_free_recursive(mesh_node_t * mesh);
 static int shaders_load(const char * vpath, const char * ppath, ID3D11VertexShader ** out_vshader, ID3D11PixelShader ** out_pshader);
 
 void kgfw_graphics_settings_set(kgfw_graphics_settings_action_enum action, unsigned int settings) {
+	kgfw_frame_request_redraw();
 	unsigned int change = 0;
 
 	switch (action) {
@@ -3389,9 +6033,7 @@ int kgfw_graphics_draw(void) {
 		recurse_state.pos[0] = 0;
 		recurse_state.pos[1] = 0;
 		recurse_state.pos[2] = 0;
-		recurse_state.rot[0] = 0;
-		recurse_state.rot[1] = 0;
-		recurse_state.rot[2] = 0;
+		kgfw_quat_identity(&recurse_state.rot);
 		recurse_state.scale[0] = 1;
 		recurse_state.scale[1] = 1;
 		recurse_state.scale[2] = 1;
@@ -3407,6 +6049,7 @@ int kgfw_graphics_draw(void) {
 }
 
 void kgfw_graphics_mesh_texture(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_t * texture, kgfw_graphics_texture_use_enum use) {
+	kgfw_frame_request_redraw();
 	mesh_node_t * m = (mesh_node_t *) mesh;
 
 	if (m->d3d11.sampler != NULL) {
@@ -3453,6 +6096,7 @@ void kgfw_graphics_mesh_texture(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_
 }
 
 void kgfw_graphics_mesh_texture_detach(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_use_enum use) {
+	kgfw_frame_request_redraw();
 	mesh_node_t * m = (mesh_node_t *) mesh;
 	if (m->d3d11.sampler != NULL) {
 		m->d3d11.sampler->lpVtbl->Release(m->d3d11.sampler);
@@ -3464,7 +6108,32 @@ void kgfw_graphics_mesh_texture_detach(kgfw_graphics_mesh_node_t * mesh, kgfw_gr
 	}
 }
 
+void kgfw_graphics_mesh_set_lit(kgfw_graphics_mesh_node_t * mesh, unsigned char lit) {
+	return;
+}
+
+void kgfw_graphics_mesh_set_static(kgfw_graphics_mesh_node_t * mesh, unsigned char is_static) {
+	return;
+}
+
+void kgfw_graphics_static_invalidate(void) {
+	return;
+}
+
+int kgfw_graphics_light_new(const kgfw_graphics_light_t * light) {
+	return -1;
+}
+
+void kgfw_graphics_light_update(int id, const kgfw_graphics_light_t * light) {
+	return;
+}
+
+void kgfw_graphics_light_destroy(int id) {
+	return;
+}
+
 kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh, kgfw_graphics_mesh_node_t * parent) {
+	kgfw_frame_request_redraw();
 	mesh_node_t * node = meshes_new();
 	node->parent = (mesh_node_t *) parent;
 	memcpy(node->transform.pos, mesh->pos, sizeof(vec3));
@@ -3489,13 +6158,17 @@ kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh,
 
 		D3D11_CALL(state.dev->lpVtbl->CreateBuffer(state.dev, &desc, &init, &node->d3d11.vbo));
 
-		desc.ByteWidth = mesh->indices_count * sizeof(unsigned int);
+		unsigned short int * narrow = kgfw_mesh_indices_narrow(mesh);
+		node->d3d11.index_fmt = (narrow == NULL) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+
+		desc.ByteWidth = mesh->indices_count * ((narrow == NULL) ? sizeof(unsigned int) : sizeof(unsigned short int));
 		desc.Usage = D3D11_USAGE_DYNAMIC;
 		desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-		init.pSysMem = mesh->indices;
+		init.pSysMem = (narrow == NULL) ? (void *) mesh->indices : (void *) narrow;
 		D3D11_CALL(state.dev->lpVtbl->CreateBuffer(state.dev, &desc, &init, &node->d3d11.ibo));
+		kgfw_memory_free(narrow);
 
 		node->d3d11.vbo_size = mesh->vertices_count;
 		node->d3d11.ibo_size = mesh->indices_count;
@@ -3526,6 +6199,7 @@ kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh,
 }
 
 void kgfw_graphics_mesh_destroy(kgfw_graphics_mesh_node_t * mesh) {
+	kgfw_frame_request_redraw();
 	if (mesh == NULL) {
 		return;
 	}
@@ -3572,6 +6246,14 @@ void kgfw_graphics_viewport(unsigned int width, unsigned int height) {
 	backbuffer->lpVtbl->Release(backbuffer);
 }
 
+void kgfw_graphics_finish(void) {
+	state.devctx->lpVtbl->Flush(state.devctx);
+}
+
+int kgfw_graphics_read_pixels(void * out_rgba) {
+	return 1;
+}
+
 kgfw_window_t * kgfw_graphics_get_window(void) {
 	return state.window;
 }
@@ -3581,7 +6263,7 @@ void kgfw_graphics_deinit(void) {
 }
 
 static mesh_node_t * meshes_alloc(void) {
-	mesh_node_t * m = malloc(sizeof(mesh_node_t));
+	mesh_node_t * m = kgfw_memory_alloc(sizeof(mesh_node_t), KGFW_MEMORY_TAG_GRAPHICS);
 	if (m == NULL) {
 		return NULL;
 	}
@@ -3611,7 +6293,7 @@ static void meshes_free(mesh_node_t * node) {
 		node->d3d11.sampler->lpVtbl->Release(node->d3d11.sampler);
 	}
 
-	free(node);
+	kgfw_memory_free(node);
 }
 
 static mesh_node_t * meshes_new(void) {
@@ -3624,38 +6306,30 @@ static mesh_node_t * meshes_new(void) {
 }
 
 static void mesh_transform(mesh_node_t * mesh, mat4x4 out_m) {
+	float pos[3] = { recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[2] + mesh->transform.pos[2] };
 	if (mesh->transform.absolute) {
-		mat4x4_identity(out_m);
-		mat4x4_translate(out_m, recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[0] + mesh->transform.pos[2]);
 		recurse_state.pos[0] = mesh->transform.pos[0];
 		recurse_state.pos[1] = mesh->transform.pos[1];
 		recurse_state.pos[2] = mesh->transform.pos[2];
-		recurse_state.rot[0] = mesh->transform.rot[0];
-		recurse_state.rot[1] = mesh->transform.rot[1];
-		recurse_state.rot[2] = mesh->transform.rot[2];
+		recurse_state.rot = *kgfw_quat_cache_get(&mesh->transform.rotation, mesh->transform.rot);
 		recurse_state.scale[0] = mesh->transform.scale[0];
 		recurse_state.scale[1] = mesh->transform.scale[1];
 		recurse_state.scale[2] = mesh->transform.scale[2];
 	} else {
-		mat4x4_translate_in_place(out_m, recurse_state.pos[0] + mesh->transform.pos[0], recurse_state.pos[1] + mesh->transform.pos[1], recurse_state.pos[2] + mesh->transform.pos[2]);
 		recurse_state.pos[0] += mesh->transform.pos[0];
 		recurse_state.pos[1] += mesh->transform.pos[1];
 		recurse_state.pos[2] += mesh->transform.pos[2];
-		recurse_state.rot[0] += mesh->transform.rot[0];
-		recurse_state.rot[1] += mesh->transform.rot[1];
-		recurse_state.rot[2] += mesh->transform.rot[2];
+		kgfw_quat_mul(&recurse_state.rot, &recurse_state.rot, kgfw_quat_cache_get(&mesh->transform.rotation, mesh->transform.rot));
 		recurse_state.scale[0] *= mesh->transform.scale[0];
 		recurse_state.scale[1] *= mesh->transform.scale[1];
 		recurse_state.scale[2] *= mesh->transform.scale[2];
 	}
-	mat4x4_identity(recurse_state.model_r);
-	mat4x4_rotate_X(out_m, out_m, (recurse_state.rot[0]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Y(out_m, out_m, (recurse_state.rot[1]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Z(out_m, out_m, (recurse_state.rot[2]) * 3.141592f / 180.0f);
-	mat4x4_rotate_X(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[0]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Y(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[1]) * 3.141592f / 180.0f);
-	mat4x4_rotate_Z(recurse_state.model_r, recurse_state.model_r, (recurse_state.rot[2]) * 3.141592f / 180.0f);
-	mat4x4_scale_aniso(out_m, out_m, recurse_state.scale[0], recurse_state.scale[1], recurse_state.scale[2]);
+
+	kgfw_mat4_rotation_quat((kgfw_mat4_t *) recurse_state.model_r, &recurse_state.rot);
+	mat4x4_scale_aniso(out_m, recurse_state.model_r, recurse_state.scale[0], recurse_state.scale[1], recurse_state.scale[2]);
+	out_m[3][0] = pos[0];
+	out_m[3][1] = pos[1];
+	out_m[3][2] = pos[2];
 }
 
 static void mesh_draw(mesh_node_t * mesh, mat4x4 out_m) {
@@ -3681,7 +6355,7 @@ static void mesh_draw(mesh_node_t * mesh, mat4x4 out_m) {
 	UINT stride = sizeof(kgfw_graphics_vertex_t);
 	UINT offset = 0;
 	state.devctx->lpVtbl->IASetVertexBuffers(state.devctx, 0, 1, &mesh->d3d11.vbo, &stride, &offset);
-	state.devctx->lpVtbl->IASetIndexBuffer(state.devctx, mesh->d3d11.ibo, DXGI_FORMAT_R32_UINT, 0);
+	state.devctx->lpVtbl->IASetIndexBuffer(state.devctx, mesh->d3d11.ibo, mesh->d3d11.index_fmt, 0);
 
 	state.devctx->lpVtbl->VSSetConstantBuffers(state.devctx, 0, 1, &state.ubuffer);
 	state.devctx->lpVtbl->VSSetShader(state.devctx, state.vshader, NULL, 0);
@@ -3727,10 +6401,10 @@ static void meshes_draw_recursive_fchild(mesh_node_t * mesh) {
 	}
 
 	vec3 pos;
-	vec3 rot;
+	kgfw_quat_t rot;
 	vec3 scale;
 	memcpy(pos, recurse_state.pos, sizeof(pos));
-	memcpy(rot, recurse_state.rot, sizeof(rot));
+	rot = recurse_state.rot;
 	memcpy(scale, recurse_state.scale, sizeof(scale));
 	
 	meshes_draw_recursive(mesh);
@@ -3741,7 +6415,7 @@ static void meshes_draw_recursive_fchild(mesh_node_t * mesh) {
 		}
 
 		memcpy(recurse_state.pos, pos, sizeof(pos));
-		memcpy(recurse_state.rot, rot, sizeof(rot));
+		recurse_state.rot = rot;
 		memcpy(recurse_state.scale, scale, sizeof(scale));
 		meshes_draw_recursive(m);
 	}
@@ -3881,7 +6555,7 @@ static int shaders_load(const char * vpath, const char * ppath, ID3D11VertexShad
 		fseek(fp, 0L, SEEK_END);
 		length = ftell(fp);
 		fseek(fp, 0L, SEEK_SET);
-		vshader = malloc(length + 1);
+		vshader = kgfw_memory_alloc(length + 1, KGFW_MEMORY_TAG_GRAPHICS);
 		if (vshader == NULL) {
 			length = 0;
 			fclose(fp);
@@ -3891,7 +6565,7 @@ static int shaders_load(const char * vpath, const char * ppath, ID3D11VertexShad
 		}
 		if (fread(vshader, 1, length, fp) != length) {
 			length = 0;
-			free(vshader);
+			kgfw_memory_free(vshader);
 			fclose(fp);
 			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to load vertex shader from \"%s\" falling back to default shader", vpath);
 			vshader = (char *) fallback_vshader;
@@ -3910,7 +6584,7 @@ static int shaders_load(const char * vpath, const char * ppath, ID3D11VertexShad
 		fseek(fp, 0L, SEEK_END);
 		length = ftell(fp);
 		fseek(fp, 0L, SEEK_SET);
-		pshader = malloc(length + 1);
+		pshader = kgfw_memory_alloc(length + 1, KGFW_MEMORY_TAG_GRAPHICS);
 		if (pshader == NULL) {
 			length = 0;
 			fclose(fp);
@@ -3920,7 +6594,7 @@ static int shaders_load(const char * vpath, const char * ppath, ID3D11VertexShad
 		}
 		if (fread(pshader, 1, length, fp) != length) {
 			length = 0;
-			free(pshader);
+			kgfw_memory_free(pshader);
 			fclose(fp);
 			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to load fragment shader from \"%s\" falling back to default shader", ppath);
 			pshader = (char *) fallback_pshader;
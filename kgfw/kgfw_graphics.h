@@ -4,6 +4,7 @@
 #include "kgfw_defines.h"
 #include "kgfw_window.h"
 #include "kgfw_camera.h"
+#include "kgfw_math.h"
 #include "../lib/include/linmath.h"
 
 typedef struct kgfw_graphics_vertex {
@@ -38,6 +39,27 @@ typedef struct kgfw_graphics_texture {
 	kgfw_graphics_texture_filtering_enum filtering;
 } kgfw_graphics_texture_t;
 
+/* layout the vertices are stored in on the gpu, vertices are always provided as kgfw_graphics_vertex_t */
+typedef enum kgfw_graphics_vertex_format {
+	KGFW_GRAPHICS_VERTEX_FORMAT_FLOAT = 0,
+	/* 2_10_10_10 normals and half float uvs, color is dropped unless KGFW_GRAPHICS_VERTEX_FORMAT_COLOR is set */
+	KGFW_GRAPHICS_VERTEX_FORMAT_PACKED = 1,
+	/* half float positions, only suitable for meshes with small extents */
+	KGFW_GRAPHICS_VERTEX_FORMAT_HALF_POSITION = 2,
+	/* rgba8 vertex colors */
+	KGFW_GRAPHICS_VERTEX_FORMAT_COLOR = 4,
+} kgfw_graphics_vertex_format_enum;
+
+#define KGFW_GRAPHICS_MESH_LODS_MAX 4
+
+/* coarser index list over the same vertices as the mesh it belongs to */
+typedef struct kgfw_graphics_mesh_lod {
+	unsigned int * indices;
+	unsigned long long int indices_count;
+	/* object space distance the simplified surface may deviate from the original */
+	float error;
+} kgfw_graphics_mesh_lod_t;
+
 typedef struct kgfw_graphics_mesh {
 	kgfw_graphics_vertex_t * vertices;
 	unsigned long long int vertices_count;
@@ -47,14 +69,32 @@ typedef struct kgfw_graphics_mesh {
 	float pos[3];
 	float rot[3];
 	float scale[3];
+
+	/* kgfw_graphics_vertex_format_enum flags, only the OpenGL backend packs vertices */
+	unsigned int vertex_format;
+
+	/* ordered from finest to coarsest, only the OpenGL backend selects lods */
+	kgfw_graphics_mesh_lod_t * lods;
+	unsigned long long int lods_count;
 } kgfw_graphics_mesh_t;
 
+#define KGFW_GRAPHICS_LIGHTS_MAX 1024
+
+/* point light, its contribution fades out smoothly and reaches zero at radius */
+typedef struct kgfw_graphics_light {
+	float pos[3];
+	float color[3];
+	float intensity;
+	float radius;
+} kgfw_graphics_light_t;
+
 typedef struct kgfw_graphics_mesh_node {
 	struct {
 		float pos[3];
 		float rot[3];
 		float scale[3];
 		unsigned char absolute;
+		kgfw_quat_cache_t rotation;
 	} transform;
 
 	struct {
@@ -113,9 +153,15 @@ typedef enum kgfw_graphics_settings_action {
 
 typedef enum kgfw_graphics_settings {
 	KGFW_GRAPHICS_SETTINGS_VSYNC = 1,
+	/* opaque draws front to back, blended draws back to front */
+	KGFW_GRAPHICS_SETTINGS_SORT = 2,
+	/* depth only pass before shading opaque draws, only on OpenGL */
+	KGFW_GRAPHICS_SETTINGS_DEPTH_PREPASS = 4,
+	/* skip meshes whose bounding box was hidden last frame, only on OpenGL */
+	KGFW_GRAPHICS_SETTINGS_OCCLUSION = 8,
 } kgfw_graphics_settings_enum;
 
-#define KGFW_GRAPHICS_SETTINGS_DEFAULT (KGFW_GRAPHICS_SETTINGS_VSYNC)
+#define KGFW_GRAPHICS_SETTINGS_DEFAULT (KGFW_GRAPHICS_SETTINGS_VSYNC | KGFW_GRAPHICS_SETTINGS_SORT | KGFW_GRAPHICS_SETTINGS_OCCLUSION)
 
 typedef enum kgfw_graphics_texture_use {
 	KGFW_GRAPHICS_TEXTURE_USE_COLOR,
@@ -127,10 +173,24 @@ KGFW_PUBLIC void kgfw_graphics_set_window(kgfw_window_t * window);
 KGFW_PUBLIC kgfw_window_t * kgfw_graphics_get_window(void);
 KGFW_PUBLIC int kgfw_graphics_draw(void);
 KGFW_PUBLIC void kgfw_graphics_viewport(unsigned int width, unsigned int height);
+/* blocks until all submitted rendering has completed */
+KGFW_PUBLIC void kgfw_graphics_finish(void);
+/* reads the last rendered frame as rgba8 rows bottom to top, only supported on OpenGL */
+KGFW_PUBLIC int kgfw_graphics_read_pixels(void * out_rgba);
 KGFW_PUBLIC kgfw_graphics_mesh_node_t * kgfw_graphics_mesh_new(kgfw_graphics_mesh_t * mesh, kgfw_graphics_mesh_node_t * parent);
 KGFW_PUBLIC void kgfw_graphics_mesh_destroy(kgfw_graphics_mesh_node_t * mesh);
 KGFW_PUBLIC void kgfw_graphics_mesh_texture(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_t * texture, kgfw_graphics_texture_use_enum use);
 KGFW_PUBLIC void kgfw_graphics_mesh_texture_detach(kgfw_graphics_mesh_node_t * mesh, kgfw_graphics_texture_use_enum use);
+/* unlit meshes skip lighting entirely, meshes are lit by default */
+KGFW_PUBLIC void kgfw_graphics_mesh_set_lit(kgfw_graphics_mesh_node_t * mesh, unsigned char lit);
+/* static nodes are merged with compatible static nodes into pre-transformed batches, only the OpenGL backend batches.
+   the mesh a static node was created from must stay alive, call kgfw_graphics_static_invalidate after moving static nodes */
+KGFW_PUBLIC void kgfw_graphics_mesh_set_static(kgfw_graphics_mesh_node_t * mesh, unsigned char is_static);
+KGFW_PUBLIC void kgfw_graphics_static_invalidate(void);
+/* returns the id of the new light or -1 when all KGFW_GRAPHICS_LIGHTS_MAX lights are in use, only the OpenGL backend draws lights */
+KGFW_PUBLIC int kgfw_graphics_light_new(const kgfw_graphics_light_t * light);
+KGFW_PUBLIC void kgfw_graphics_light_update(int id, const kgfw_graphics_light_t * light);
+KGFW_PUBLIC void kgfw_graphics_light_destroy(int id);
 KGFW_PUBLIC void kgfw_graphics_deinit(void);
 KGFW_PUBLIC void kgfw_graphics_settings_set(kgfw_graphics_settings_action_enum action, unsigned int settings);
 KGFW_PUBLIC unsigned int kgfw_graphics_settings_get(void);
@@ -1,21 +1,31 @@
 #include "kgfw_hash.h"
+#include <string.h>
 
 kgfw_hash_t kgfw_hash(const char * string) {
-	kgfw_hash_t hash = 5381;
-
-	for (unsigned long long int i = 0; string[i] != '\0'; ++i) {
-		hash = (hash << 5) + hash + string[i];
-	}
-
-	return hash;
+	return kgfw_hash_length(string, strlen(string));
 }
 
 kgfw_hash_t kgfw_hash_length(const char * string, unsigned long long int length) {
-	kgfw_hash_t hash = 5381;
+	kgfw_hash_t sum = 0;
+	unsigned long long int words = length / 8;
+	unsigned long long int multiplier = KGFW_HASH_PRIME;
+
+	/* every supported target is little endian, so a plain load matches the literal macro */
+	for (unsigned long long int i = 0; i < words; ++i) {
+		unsigned long long int w;
+		memcpy(&w, string + i * 8, 8);
+		sum += KGFW_HASH_XORSHIFT_(KGFW_HASH_XORSHIFT_(w, 32) * multiplier, 29);
+		multiplier += KGFW_HASH_STEP;
+	}
 
-	for (unsigned long long int i = 0; i < length; ++i) {
-		hash = (hash << 5) + hash + string[i];
+	unsigned long long int rest = length % 8;
+	if (rest > 0) {
+		unsigned long long int w = 0;
+		for (unsigned long long int i = 0; i < rest; ++i) {
+			w |= (unsigned long long int) (unsigned char) string[words * 8 + i] << (i * 8);
+		}
+		sum += KGFW_HASH_XORSHIFT_(KGFW_HASH_XORSHIFT_(w, 32) * multiplier, 29);
 	}
 
-	return hash;
+	return KGFW_HASH_FINISH_(sum, length);
 }
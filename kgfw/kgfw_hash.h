@@ -5,7 +5,39 @@
 
 typedef unsigned long long int kgfw_hash_t;
 
+/*
+	strings are read as little endian 8 byte words, each word is mixed on its own with a
+	per-position multiplier and the results are summed, so words hash independently of
+	each other and the loop has no dependency chain beyond the sum
+*/
 KGFW_PUBLIC kgfw_hash_t kgfw_hash(const char * string);
 KGFW_PUBLIC kgfw_hash_t kgfw_hash_length(const char * string, unsigned long long int length);
 
+#define KGFW_HASH_SEED 0x9E3779B97F4A7C15ULL
+#define KGFW_HASH_PRIME 0xD6E8FEB86659FD93ULL
+#define KGFW_HASH_STEP 0xA0761D6478BD642EULL
+#define KGFW_HASH_CHARS_MAX 32
+
+#define KGFW_HASH_XORSHIFT_(x, s) ((x) ^ ((x) >> (s)))
+#define KGFW_HASH_MULTIPLIER_(i) (KGFW_HASH_PRIME + (unsigned long long int) (i) * KGFW_HASH_STEP)
+#define KGFW_HASH_WORD_MIX_(w, i) KGFW_HASH_XORSHIFT_(KGFW_HASH_XORSHIFT_(w, 32) * KGFW_HASH_MULTIPLIER_(i), 29)
+#define KGFW_HASH_FINISH_(x, length) KGFW_HASH_XORSHIFT_(((x) + ((length) + 1) * KGFW_HASH_SEED) * KGFW_HASH_PRIME, 32)
+
+/* padding characters are 0, so they add nothing to the length and a zero word adds nothing to the sum */
+#define KGFW_HASH_BYTE_(c, i) ((unsigned long long int) (unsigned char) (c) << ((i) * 8))
+/* fails to compile when more than KGFW_HASH_CHARS_MAX characters are given */
+#define KGFW_HASH_CHECK_(c) (sizeof(char[((c) == 0) ? 1 : -1]) * 0)
+#define KGFW_HASH_CHARS_(c0, c1, c2, c3, c4, c5, c6, c7, c8, c9, c10, c11, c12, c13, c14, c15, c16, c17, c18, c19, c20, c21, c22, c23, c24, c25, c26, c27, c28, c29, c30, c31, c32, ...) \
+	(KGFW_HASH_FINISH_(KGFW_HASH_WORD_MIX_((KGFW_HASH_BYTE_(c0, 0) | KGFW_HASH_BYTE_(c1, 1) | KGFW_HASH_BYTE_(c2, 2) | KGFW_HASH_BYTE_(c3, 3) | KGFW_HASH_BYTE_(c4, 4) | KGFW_HASH_BYTE_(c5, 5) | KGFW_HASH_BYTE_(c6, 6) | KGFW_HASH_BYTE_(c7, 7)), 0) \
+	+ KGFW_HASH_WORD_MIX_((KGFW_HASH_BYTE_(c8, 0) | KGFW_HASH_BYTE_(c9, 1) | KGFW_HASH_BYTE_(c10, 2) | KGFW_HASH_BYTE_(c11, 3) | KGFW_HASH_BYTE_(c12, 4) | KGFW_HASH_BYTE_(c13, 5) | KGFW_HASH_BYTE_(c14, 6) | KGFW_HASH_BYTE_(c15, 7)), 1) \
+	+ KGFW_HASH_WORD_MIX_((KGFW_HASH_BYTE_(c16, 0) | KGFW_HASH_BYTE_(c17, 1) | KGFW_HASH_BYTE_(c18, 2) | KGFW_HASH_BYTE_(c19, 3) | KGFW_HASH_BYTE_(c20, 4) | KGFW_HASH_BYTE_(c21, 5) | KGFW_HASH_BYTE_(c22, 6) | KGFW_HASH_BYTE_(c23, 7)), 2) \
+	+ KGFW_HASH_WORD_MIX_((KGFW_HASH_BYTE_(c24, 0) | KGFW_HASH_BYTE_(c25, 1) | KGFW_HASH_BYTE_(c26, 2) | KGFW_HASH_BYTE_(c27, 3) | KGFW_HASH_BYTE_(c28, 4) | KGFW_HASH_BYTE_(c29, 5) | KGFW_HASH_BYTE_(c30, 6) | KGFW_HASH_BYTE_(c31, 7)), 3), \
+	(unsigned long long int) (((c0) != 0) + ((c1) != 0) + ((c2) != 0) + ((c3) != 0) + ((c4) != 0) + ((c5) != 0) + ((c6) != 0) + ((c7) != 0) + ((c8) != 0) + ((c9) != 0) + ((c10) != 0) + ((c11) != 0) + ((c12) != 0) + ((c13) != 0) + ((c14) != 0) + ((c15) != 0) + ((c16) != 0) + ((c17) != 0) + ((c18) != 0) + ((c19) != 0) + ((c20) != 0) + ((c21) != 0) + ((c22) != 0) + ((c23) != 0) + ((c24) != 0) + ((c25) != 0) + ((c26) != 0) + ((c27) != 0) + ((c28) != 0) + ((c29) != 0) + ((c30) != 0) + ((c31) != 0))) + KGFW_HASH_CHECK_(c32))
+
+/*
+	integer constant expression equal to kgfw_hash of the given characters, usable in case labels
+	and static initializers, e.g. KGFW_HASH_CHARS('c', 'a', 'r') == kgfw_hash("car")
+*/
+#define KGFW_HASH_CHARS(...) KGFW_HASH_CHARS_(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+
 #endif
@@ -1,5 +1,6 @@
 #include "kgfw_defines.h"
 #include "kgfw_input.h"
+#include "kgfw_frame.h"
 #include "kgfw_log.h"
 
 #define KGFW_KEY_MAX_CALLBACKS 16
@@ -247,6 +248,7 @@ void kgfw_input_update(void) {
 static void kgfw_glfw_key(GLFWwindow * window, int key, int scancode, int action, int mods) {
 	key_state.prev_keys[glfw_key_to_kgfw(key) % KGFW_KEY_MAX] = key_state.keys[glfw_key_to_kgfw(key) % KGFW_KEY_MAX];
 	key_state.keys[glfw_key_to_kgfw(key) % KGFW_KEY_MAX] = (action);
+	kgfw_frame_request_redraw();
 	for (unsigned long long int i = 0; i < key_state.callback_count; ++i) {
 		key_state.callbacks[i](glfw_key_to_kgfw(key) % KGFW_KEY_MAX, (action));
 	}
@@ -257,11 +259,13 @@ static void kgfw_glfw_mouse(GLFWwindow * window, double x, double y) {
 	key_state.prev_mouse_y = key_state.mouse_y;
 	key_state.mouse_x = x;
 	key_state.mouse_y = y;
+	kgfw_frame_request_redraw();
 }
 
 static void kgfw_glfw_scroll(GLFWwindow * window, double x, double y) {
 	key_state.scroll_x = x;
 	key_state.scroll_y = y;
+	kgfw_frame_request_redraw();
 }
 
 static kgfw_input_key_enum glfw_key_to_kgfw(int key) {
@@ -290,6 +294,7 @@ static void kgfw_glfw_mouse_buttons(GLFWwindow * window, int button, int action,
 	}
 
 	key_state.mouse[button] = (action);
+	kgfw_frame_request_redraw();
 	for (unsigned long long int i = 0; i < key_state.mouse_callback_count; ++i) {
 		key_state.mouse_callbacks[i](button % KGFW_MOUSE_BUTTON_MAX, (action));
 	}
@@ -477,6 +482,7 @@ int kgfw_input_mouse_button_register_callback(kgfw_input_mouse_button_callback c
 void kgfw_input_press_key_down(kgfw_input_key_enum key) {
 	key_state.prev_keys[key % KGFW_KEY_MAX] = key_state.keys[key % KGFW_KEY_MAX];
 	key_state.keys[key % KGFW_KEY_MAX] = 1;
+	kgfw_frame_request_redraw();
 	for (unsigned long long int i = 0; i < key_state.callback_count; ++i) {
 		key_state.callbacks[i](key % KGFW_KEY_MAX, 1);
 	}
@@ -484,6 +490,7 @@ void kgfw_input_press_key_down(kgfw_input_key_enum key) {
 void kgfw_input_press_key_up(kgfw_input_key_enum key) {
 	key_state.prev_keys[key % KGFW_KEY_MAX] = key_state.keys[key % KGFW_KEY_MAX];
 	key_state.keys[key % KGFW_KEY_MAX] = 0;
+	kgfw_frame_request_redraw();
 	for (unsigned long long int i = 0; i < key_state.callback_count; ++i) {
 		key_state.callbacks[i](key % KGFW_KEY_MAX, 0);
 	}
@@ -495,6 +502,7 @@ void kgfw_input_press_mouse_button_down(kgfw_input_mouse_button_enum button) {
 	}
 
 	key_state.mouse[button % KGFW_MOUSE_BUTTON_MAX] = 1;
+	kgfw_frame_request_redraw();
 	for (unsigned long long int i = 0; i < key_state.mouse_callback_count; ++i) {
 		key_state.mouse_callbacks[i](button % KGFW_MOUSE_BUTTON_MAX, 1);
 	}
@@ -506,6 +514,7 @@ void kgfw_input_press_mouse_button_up(kgfw_input_mouse_button_enum button) {
 	}
 
 	key_state.mouse[button % KGFW_MOUSE_BUTTON_MAX] = 0;
+	kgfw_frame_request_redraw();
 	for (unsigned long long int i = 0; i < key_state.mouse_callback_count; ++i) {
 		key_state.mouse_callbacks[i](button % KGFW_MOUSE_BUTTON_MAX, 0);
 	}
@@ -516,11 +525,13 @@ void kgfw_input_set_mouse_pos(float x, float y) {
 	key_state.prev_mouse_y = key_state.mouse_y;
 	key_state.mouse_x = x;
 	key_state.mouse_y = y;
+	kgfw_frame_request_redraw();
 }
 
 void kgfw_input_set_mouse_scroll(float x, float y) {
 	key_state.scroll_x = x;
 	key_state.scroll_y = y;
+	kgfw_frame_request_redraw();
 }
 #endif
 
@@ -1,4 +1,5 @@
 #include "kgfw_list.h"
+#include "kgfw_memory.h"
 #include <stdlib.h>
 
 typedef struct {
@@ -8,7 +9,7 @@ typedef struct {
 } list_t;
 
 void * _kgfw_list_new(unsigned long long int type_size) {
-	list_t * list = malloc(sizeof(list_t) + type_size);
+	list_t * list = kgfw_memory_alloc(sizeof(list_t) + type_size, KGFW_MEMORY_TAG_GENERAL);
 	if (list == NULL) {
 		return NULL;
 	}
@@ -26,7 +27,7 @@ void * _kgfw_list_reserve(void * list, unsigned long long int capacity) {
 	}
 
 	list_t * l = (void *) (((unsigned long long int) list) - sizeof(list_t));
-	void * p = realloc(l, sizeof(list_t) + l->type_size * capacity);
+	void * p = kgfw_memory_realloc(l, sizeof(list_t) + l->type_size * capacity, KGFW_MEMORY_TAG_GENERAL);
 	if (p == NULL) {
 		return NULL;
 	}
@@ -46,6 +47,6 @@ void * _kgfw_list_expand_from(void * list, unsigned long long int index) {
 
 void _kgfw_list_destroy(void * list) {
 	if (list != NULL) {
-		free((void *) (((unsigned long long int) list) - sizeof(list_t)));
+		kgfw_memory_free((void *) (((unsigned long long int) list) - sizeof(list_t)));
 	}
 }
@@ -1,4 +1,5 @@
 #include "kgfw_log.h"
+#include "kgfw_frame.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,14 +33,26 @@ void kgfw_log(kgfw_log_severity_enum severity, char * message) {
 
 void kgfw_logf(kgfw_log_severity_enum severity, char * format, ...) {
 	va_list args;
+	va_list again;
 	va_start(args, format);
+	va_copy(again, args);
 
 	char buffer[1024];
+	char * message = buffer;
 
-	vsnprintf(buffer, 1024, format, args);
+	int length = vsnprintf(buffer, 1024, format, args);
 	va_end(args);
+	/* long messages are formatted again into frame memory rather than truncated */
+	if (length >= 1024) {
+		char * p = kgfw_frame_alloc(length + 1);
+		if (p != NULL) {
+			vsnprintf(p, length + 1, format, again);
+			message = p;
+		}
+	}
+	va_end(again);
 
 	if (kgfw_log_callback != NULL) {
-		kgfw_log_callback(severity, buffer);
+		kgfw_log_callback(severity, message);
 	}
 }
@@ -0,0 +1,406 @@
+#include "kgfw_math.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(KGFW_SSE)
+#include <xmmintrin.h>
+
+typedef __m128 simd_t;
+
+#define simd_load(p) _mm_loadu_ps(p)
+#define simd_store(p, a) _mm_storeu_ps(p, a)
+#define simd_splat(f) _mm_set1_ps(f)
+#define simd_add(a, b) _mm_add_ps(a, b)
+#define simd_mul(a, b) _mm_mul_ps(a, b)
+#define simd_max(a, b) _mm_max_ps(a, b)
+#define simd_madd(acc, a, b) _mm_add_ps(acc, _mm_mul_ps(a, b))
+#define simd_any_negative(a) (_mm_movemask_ps(_mm_cmplt_ps(a, _mm_setzero_ps())) != 0)
+#elif defined(KGFW_NEON)
+#include <arm_neon.h>
+
+typedef float32x4_t simd_t;
+
+#define simd_load(p) vld1q_f32(p)
+#define simd_store(p, a) vst1q_f32(p, a)
+#define simd_splat(f) vdupq_n_f32(f)
+#define simd_add(a, b) vaddq_f32(a, b)
+#define simd_mul(a, b) vmulq_f32(a, b)
+#define simd_max(a, b) vmaxq_f32(a, b)
+#define simd_madd(acc, a, b) vmlaq_f32(acc, a, b)
+#define simd_any_negative(a) ((vgetq_lane_u32(vcltq_f32(a, vdupq_n_f32(0)), 0) | vgetq_lane_u32(vcltq_f32(a, vdupq_n_f32(0)), 1) | vgetq_lane_u32(vcltq_f32(a, vdupq_n_f32(0)), 2) | vgetq_lane_u32(vcltq_f32(a, vdupq_n_f32(0)), 3)) != 0)
+#else
+/* plain four wide structs, compilers vectorize these where they can */
+typedef struct simd {
+	float f[4];
+} simd_t;
+
+static simd_t simd_load(const float * p) {
+	simd_t r = { { p[0], p[1], p[2], p[3] } };
+	return r;
+}
+
+static void simd_store(float * p, simd_t a) {
+	memcpy(p, a.f, sizeof(a.f));
+}
+
+static simd_t simd_splat(float f) {
+	simd_t r = { { f, f, f, f } };
+	return r;
+}
+
+static simd_t simd_add(simd_t a, simd_t b) {
+	simd_t r = { { a.f[0] + b.f[0], a.f[1] + b.f[1], a.f[2] + b.f[2], a.f[3] + b.f[3] } };
+	return r;
+}
+
+static simd_t simd_mul(simd_t a, simd_t b) {
+	simd_t r = { { a.f[0] * b.f[0], a.f[1] * b.f[1], a.f[2] * b.f[2], a.f[3] * b.f[3] } };
+	return r;
+}
+
+static simd_t simd_max(simd_t a, simd_t b) {
+	simd_t r = { { fmaxf(a.f[0], b.f[0]), fmaxf(a.f[1], b.f[1]), fmaxf(a.f[2], b.f[2]), fmaxf(a.f[3], b.f[3]) } };
+	return r;
+}
+
+static simd_t simd_madd(simd_t acc, simd_t a, simd_t b) {
+	return simd_add(acc, simd_mul(a, b));
+}
+
+static int simd_any_negative(simd_t a) {
+	return a.f[0] < 0 || a.f[1] < 0 || a.f[2] < 0 || a.f[3] < 0;
+}
+#endif
+
+#define KGFW_MATH_RADIANS (3.141592f / 180.0f)
+
+void kgfw_mat4_identity(kgfw_mat4_t * out) {
+	memset(out, 0, sizeof(*out));
+	out->m[0][0] = 1;
+	out->m[1][1] = 1;
+	out->m[2][2] = 1;
+	out->m[3][3] = 1;
+}
+
+void kgfw_mat4_mul(kgfw_mat4_t * out, const kgfw_mat4_t * a, const kgfw_mat4_t * b) {
+	simd_t a0 = simd_load(a->m[0]);
+	simd_t a1 = simd_load(a->m[1]);
+	simd_t a2 = simd_load(a->m[2]);
+	simd_t a3 = simd_load(a->m[3]);
+
+	/* each column of b is read whole before the same column of out is written, so out may alias b */
+	for (unsigned int i = 0; i < 4; ++i) {
+		float b0 = b->m[i][0];
+		float b1 = b->m[i][1];
+		float b2 = b->m[i][2];
+		float b3 = b->m[i][3];
+		simd_t r = simd_mul(a0, simd_splat(b0));
+		r = simd_madd(r, a1, simd_splat(b1));
+		r = simd_madd(r, a2, simd_splat(b2));
+		r = simd_madd(r, a3, simd_splat(b3));
+		simd_store(out->m[i], r);
+	}
+}
+
+void kgfw_mat4_mul_batch(kgfw_mat4_t * out, const kgfw_mat4_t * a, const kgfw_mat4_t * b, unsigned long long int count) {
+	simd_t a0 = simd_load(a->m[0]);
+	simd_t a1 = simd_load(a->m[1]);
+	simd_t a2 = simd_load(a->m[2]);
+	simd_t a3 = simd_load(a->m[3]);
+
+	for (unsigned long long int n = 0; n < count; ++n) {
+		for (unsigned int i = 0; i < 4; ++i) {
+			float b0 = b[n].m[i][0];
+			float b1 = b[n].m[i][1];
+			float b2 = b[n].m[i][2];
+			float b3 = b[n].m[i][3];
+			simd_t r = simd_mul(a0, simd_splat(b0));
+			r = simd_madd(r, a1, simd_splat(b1));
+			r = simd_madd(r, a2, simd_splat(b2));
+			r = simd_madd(r, a3, simd_splat(b3));
+			simd_store(out[n].m[i], r);
+		}
+	}
+}
+
+void kgfw_mat4_mul_vec4(kgfw_vec4_t * out, const kgfw_mat4_t * m, const kgfw_vec4_t * v) {
+	float x = v->v[0];
+	float y = v->v[1];
+	float z = v->v[2];
+	float w = v->v[3];
+	simd_t r = simd_mul(simd_load(m->m[0]), simd_splat(x));
+	r = simd_madd(r, simd_load(m->m[1]), simd_splat(y));
+	r = simd_madd(r, simd_load(m->m[2]), simd_splat(z));
+	r = simd_madd(r, simd_load(m->m[3]), simd_splat(w));
+	simd_store(out->v, r);
+}
+
+void kgfw_mat4_transform_batch(const kgfw_mat4_t * m, float * xyz, unsigned long long int stride, unsigned long long int count, float w) {
+	simd_t c0 = simd_load(m->m[0]);
+	simd_t c1 = simd_load(m->m[1]);
+	simd_t c2 = simd_load(m->m[2]);
+	simd_t c3 = simd_mul(simd_load(m->m[3]), simd_splat(w));
+
+	unsigned char * p = (unsigned char *) xyz;
+	for (unsigned long long int i = 0; i < count; ++i, p += stride) {
+		float * v = (float *) p;
+		simd_t r = simd_madd(c3, c0, simd_splat(v[0]));
+		r = simd_madd(r, c1, simd_splat(v[1]));
+		r = simd_madd(r, c2, simd_splat(v[2]));
+
+		/* only three lanes are written back, the fourth float belongs to whatever follows in the element */
+		float result[4];
+		simd_store(result, r);
+		v[0] = result[0];
+		v[1] = result[1];
+		v[2] = result[2];
+	}
+}
+
+void kgfw_mat4_rotation(kgfw_mat4_t * out, const float rot[3]) {
+	float sx = sinf(rot[0] * KGFW_MATH_RADIANS);
+	float cx = cosf(rot[0] * KGFW_MATH_RADIANS);
+	float sy = sinf(rot[1] * KGFW_MATH_RADIANS);
+	float cy = cosf(rot[1] * KGFW_MATH_RADIANS);
+	float sz = sinf(rot[2] * KGFW_MATH_RADIANS);
+	float cz = cosf(rot[2] * KGFW_MATH_RADIANS);
+
+	out->m[0][0] = cy * cz;
+	out->m[0][1] = cx * sz + sx * sy * cz;
+	out->m[0][2] = sx * sz - cx * sy * cz;
+	out->m[0][3] = 0;
+
+	out->m[1][0] = -cy * sz;
+	out->m[1][1] = cx * cz - sx * sy * sz;
+	out->m[1][2] = sx * cz + cx * sy * sz;
+	out->m[1][3] = 0;
+
+	out->m[2][0] = sy;
+	out->m[2][1] = -sx * cy;
+	out->m[2][2] = cx * cy;
+	out->m[2][3] = 0;
+
+	out->m[3][0] = 0;
+	out->m[3][1] = 0;
+	out->m[3][2] = 0;
+	out->m[3][3] = 1;
+}
+
+void kgfw_mat4_trs(kgfw_mat4_t * out, const float pos[3], const float rot[3], const float scale[3]) {
+	kgfw_mat4_rotation(out, rot);
+	for (unsigned int i = 0; i < 3; ++i) {
+		out->m[i][0] *= scale[i];
+		out->m[i][1] *= scale[i];
+		out->m[i][2] *= scale[i];
+	}
+	out->m[3][0] = pos[0];
+	out->m[3][1] = pos[1];
+	out->m[3][2] = pos[2];
+}
+
+void kgfw_mat4_rotation_quat(kgfw_mat4_t * out, const kgfw_quat_t * rot) {
+	float x = rot->q[0];
+	float y = rot->q[1];
+	float z = rot->q[2];
+	float w = rot->q[3];
+
+	out->m[0][0] = 1 - 2 * (y * y + z * z);
+	out->m[0][1] = 2 * (x * y + w * z);
+	out->m[0][2] = 2 * (x * z - w * y);
+	out->m[0][3] = 0;
+
+	out->m[1][0] = 2 * (x * y - w * z);
+	out->m[1][1] = 1 - 2 * (x * x + z * z);
+	out->m[1][2] = 2 * (y * z + w * x);
+	out->m[1][3] = 0;
+
+	out->m[2][0] = 2 * (x * z + w * y);
+	out->m[2][1] = 2 * (y * z - w * x);
+	out->m[2][2] = 1 - 2 * (x * x + y * y);
+	out->m[2][3] = 0;
+
+	out->m[3][0] = 0;
+	out->m[3][1] = 0;
+	out->m[3][2] = 0;
+	out->m[3][3] = 1;
+}
+
+void kgfw_mat4_trs_quat(kgfw_mat4_t * out, const float pos[3], const kgfw_quat_t * rot, const float scale[3]) {
+	kgfw_mat4_rotation_quat(out, rot);
+	for (unsigned int i = 0; i < 3; ++i) {
+		out->m[i][0] *= scale[i];
+		out->m[i][1] *= scale[i];
+		out->m[i][2] *= scale[i];
+	}
+	out->m[3][0] = pos[0];
+	out->m[3][1] = pos[1];
+	out->m[3][2] = pos[2];
+}
+
+void kgfw_quat_identity(kgfw_quat_t * out) {
+	out->q[0] = 0;
+	out->q[1] = 0;
+	out->q[2] = 0;
+	out->q[3] = 1;
+}
+
+void kgfw_quat_from_euler(kgfw_quat_t * out, const float rot[3]) {
+	float sx = sinf(rot[0] * KGFW_MATH_RADIANS * 0.5f);
+	float cx = cosf(rot[0] * KGFW_MATH_RADIANS * 0.5f);
+	float sy = sinf(rot[1] * KGFW_MATH_RADIANS * 0.5f);
+	float cy = cosf(rot[1] * KGFW_MATH_RADIANS * 0.5f);
+	float sz = sinf(rot[2] * KGFW_MATH_RADIANS * 0.5f);
+	float cz = cosf(rot[2] * KGFW_MATH_RADIANS * 0.5f);
+
+	/* X * Y * Z expanded */
+	out->q[0] = sx * cy * cz + cx * sy * sz;
+	out->q[1] = cx * sy * cz - sx * cy * sz;
+	out->q[2] = cx * cy * sz + sx * sy * cz;
+	out->q[3] = cx * cy * cz - sx * sy * sz;
+}
+
+void kgfw_quat_to_euler(float out[3], const kgfw_quat_t * rot) {
+	float x = rot->q[0];
+	float y = rot->q[1];
+	float z = rot->q[2];
+	float w = rot->q[3];
+
+	float sy = 2 * (x * z + w * y);
+	sy = (sy > 1) ? 1 : (sy < -1) ? -1 : sy;
+	out[0] = atan2f(-2 * (y * z - w * x), 1 - 2 * (x * x + y * y)) / KGFW_MATH_RADIANS;
+	out[1] = asinf(sy) / KGFW_MATH_RADIANS;
+	out[2] = atan2f(-2 * (x * y - w * z), 1 - 2 * (y * y + z * z)) / KGFW_MATH_RADIANS;
+}
+
+void kgfw_quat_mul(kgfw_quat_t * out, const kgfw_quat_t * a, const kgfw_quat_t * b) {
+	float x = a->q[3] * b->q[0] + a->q[0] * b->q[3] + a->q[1] * b->q[2] - a->q[2] * b->q[1];
+	float y = a->q[3] * b->q[1] - a->q[0] * b->q[2] + a->q[1] * b->q[3] + a->q[2] * b->q[0];
+	float z = a->q[3] * b->q[2] + a->q[0] * b->q[1] - a->q[1] * b->q[0] + a->q[2] * b->q[3];
+	float w = a->q[3] * b->q[3] - a->q[0] * b->q[0] - a->q[1] * b->q[1] - a->q[2] * b->q[2];
+	out->q[0] = x;
+	out->q[1] = y;
+	out->q[2] = z;
+	out->q[3] = w;
+}
+
+void kgfw_quat_conjugate(kgfw_quat_t * out, const kgfw_quat_t * rot) {
+	out->q[0] = -rot->q[0];
+	out->q[1] = -rot->q[1];
+	out->q[2] = -rot->q[2];
+	out->q[3] = rot->q[3];
+}
+
+void kgfw_quat_normalize(kgfw_quat_t * out, const kgfw_quat_t * rot) {
+	float length = sqrtf(rot->q[0] * rot->q[0] + rot->q[1] * rot->q[1] + rot->q[2] * rot->q[2] + rot->q[3] * rot->q[3]);
+	if (length == 0) {
+		kgfw_quat_identity(out);
+		return;
+	}
+
+	length = 1 / length;
+	for (unsigned int i = 0; i < 4; ++i) {
+		out->q[i] = rot->q[i] * length;
+	}
+}
+
+void kgfw_quat_rotate(float out[3], const kgfw_quat_t * rot, const float v[3]) {
+	/* v + 2w(u x v) + 2u x (u x v) with u the vector part */
+	const float * u = rot->q;
+	float w = rot->q[3];
+	float t[3] = {
+		2 * (u[1] * v[2] - u[2] * v[1]),
+		2 * (u[2] * v[0] - u[0] * v[2]),
+		2 * (u[0] * v[1] - u[1] * v[0]),
+	};
+	float r[3] = {
+		v[0] + w * t[0] + u[1] * t[2] - u[2] * t[1],
+		v[1] + w * t[1] + u[2] * t[0] - u[0] * t[2],
+		v[2] + w * t[2] + u[0] * t[1] - u[1] * t[0],
+	};
+	out[0] = r[0];
+	out[1] = r[1];
+	out[2] = r[2];
+}
+
+const kgfw_quat_t * kgfw_quat_cache_get(kgfw_quat_cache_t * cache, const float euler[3]) {
+	if (!cache->valid || cache->euler[0] != euler[0] || cache->euler[1] != euler[1] || cache->euler[2] != euler[2]) {
+		cache->euler[0] = euler[0];
+		cache->euler[1] = euler[1];
+		cache->euler[2] = euler[2];
+		kgfw_quat_from_euler(&cache->quat, euler);
+		cache->valid = 1;
+	}
+
+	return &cache->quat;
+}
+
+void kgfw_frustum_from(kgfw_frustum_t * out, const kgfw_mat4_t * vp) {
+	/* left, right, bottom, top, near, far from the rows of the view projection matrix */
+	for (unsigned int i = 0; i < 6; ++i) {
+		float sign = (i & 1) ? -1.0f : 1.0f;
+		float plane[4];
+		for (unsigned int k = 0; k < 4; ++k) {
+			plane[k] = vp->m[k][3] + sign * vp->m[k][i / 2];
+		}
+
+		float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (length > 0) {
+			length = 1 / length;
+		}
+		out->x[i] = plane[0] * length;
+		out->y[i] = plane[1] * length;
+		out->z[i] = plane[2] * length;
+		out->d[i] = plane[3] * length;
+	}
+
+	for (unsigned int i = 6; i < 8; ++i) {
+		out->x[i] = 0;
+		out->y[i] = 0;
+		out->z[i] = 0;
+		out->d[i] = 1e30f;
+	}
+}
+
+int kgfw_frustum_sphere(const kgfw_frustum_t * frustum, const float center[3], float radius) {
+	simd_t cx = simd_splat(center[0]);
+	simd_t cy = simd_splat(center[1]);
+	simd_t cz = simd_splat(center[2]);
+	simd_t r = simd_splat(radius);
+
+	for (unsigned int i = 0; i < 8; i += 4) {
+		simd_t distance = simd_add(simd_load(&frustum->d[i]), r);
+		distance = simd_madd(distance, simd_load(&frustum->x[i]), cx);
+		distance = simd_madd(distance, simd_load(&frustum->y[i]), cy);
+		distance = simd_madd(distance, simd_load(&frustum->z[i]), cz);
+		if (simd_any_negative(distance)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int kgfw_frustum_aabb(const kgfw_frustum_t * frustum, const float min[3], const float max[3]) {
+	simd_t min_x = simd_splat(min[0]);
+	simd_t min_y = simd_splat(min[1]);
+	simd_t min_z = simd_splat(min[2]);
+	simd_t max_x = simd_splat(max[0]);
+	simd_t max_y = simd_splat(max[1]);
+	simd_t max_z = simd_splat(max[2]);
+
+	/* the corner furthest along each plane normal gives the larger product per axis */
+	for (unsigned int i = 0; i < 8; i += 4) {
+		simd_t x = simd_load(&frustum->x[i]);
+		simd_t y = simd_load(&frustum->y[i]);
+		simd_t z = simd_load(&frustum->z[i]);
+		simd_t distance = simd_load(&frustum->d[i]);
+		distance = simd_add(distance, simd_max(simd_mul(x, min_x), simd_mul(x, max_x)));
+		distance = simd_add(distance, simd_max(simd_mul(y, min_y), simd_mul(y, max_y)));
+		distance = simd_add(distance, simd_max(simd_mul(z, min_z), simd_mul(z, max_z)));
+		if (simd_any_negative(distance)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
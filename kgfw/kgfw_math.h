@@ -0,0 +1,72 @@
+#ifndef KRISVERS_KGFW_MATH_H
+#define KRISVERS_KGFW_MATH_H
+
+#include "kgfw_defines.h"
+
+/* column major like linmath, m[column][row], so .m can be handed to linmath functions taking mat4x4 */
+typedef struct KGFW_ALIGN(16) kgfw_mat4 {
+	float m[4][4];
+} kgfw_mat4_t;
+
+typedef struct KGFW_ALIGN(16) kgfw_vec4 {
+	float v[4];
+} kgfw_vec4_t;
+
+/* x, y, z, w */
+typedef struct KGFW_ALIGN(16) kgfw_quat {
+	float q[4];
+} kgfw_quat_t;
+
+/* quaternion of an euler rotation, only rebuilt when the angles differ from the last lookup */
+typedef struct kgfw_quat_cache {
+	float euler[3];
+	unsigned char valid;
+	kgfw_quat_t quat;
+} kgfw_quat_cache_t;
+
+/* planes stored as structure of arrays, padded to 8 with planes that never reject */
+typedef struct KGFW_ALIGN(16) kgfw_frustum {
+	float x[8];
+	float y[8];
+	float z[8];
+	float d[8];
+} kgfw_frustum_t;
+
+/* unaligned pointers are accepted everywhere, alignment only saves a cache line split */
+KGFW_PUBLIC void kgfw_mat4_identity(kgfw_mat4_t * out);
+/* out = a * b, out may alias either */
+KGFW_PUBLIC void kgfw_mat4_mul(kgfw_mat4_t * out, const kgfw_mat4_t * a, const kgfw_mat4_t * b);
+/* out[i] = a * b[i] */
+KGFW_PUBLIC void kgfw_mat4_mul_batch(kgfw_mat4_t * out, const kgfw_mat4_t * a, const kgfw_mat4_t * b, unsigned long long int count);
+KGFW_PUBLIC void kgfw_mat4_mul_vec4(kgfw_vec4_t * out, const kgfw_mat4_t * m, const kgfw_vec4_t * v);
+/* transforms count xyz triples spaced stride bytes apart in place, w is 1 for points and 0 for directions */
+KGFW_PUBLIC void kgfw_mat4_transform_batch(const kgfw_mat4_t * m, float * xyz, unsigned long long int stride, unsigned long long int count, float w);
+/* translate * rotate X * rotate Y * rotate Z * scale with angles in degrees, the same matrix linmath builds in five calls */
+KGFW_PUBLIC void kgfw_mat4_trs(kgfw_mat4_t * out, const float pos[3], const float rot[3], const float scale[3]);
+/* rotate X * rotate Y * rotate Z with angles in degrees */
+KGFW_PUBLIC void kgfw_mat4_rotation(kgfw_mat4_t * out, const float rot[3]);
+
+/* translate * rotate * scale without any trigonometry */
+KGFW_PUBLIC void kgfw_mat4_trs_quat(kgfw_mat4_t * out, const float pos[3], const kgfw_quat_t * rot, const float scale[3]);
+KGFW_PUBLIC void kgfw_mat4_rotation_quat(kgfw_mat4_t * out, const kgfw_quat_t * rot);
+
+KGFW_PUBLIC void kgfw_quat_identity(kgfw_quat_t * out);
+/* same rotation as kgfw_mat4_rotation of the angles */
+KGFW_PUBLIC void kgfw_quat_from_euler(kgfw_quat_t * out, const float rot[3]);
+/* angles in degrees, y is kept within -90 to 90 */
+KGFW_PUBLIC void kgfw_quat_to_euler(float out[3], const kgfw_quat_t * rot);
+/* out = a * b, rotates by b and then by a, out may alias either */
+KGFW_PUBLIC void kgfw_quat_mul(kgfw_quat_t * out, const kgfw_quat_t * a, const kgfw_quat_t * b);
+KGFW_PUBLIC void kgfw_quat_conjugate(kgfw_quat_t * out, const kgfw_quat_t * rot);
+KGFW_PUBLIC void kgfw_quat_normalize(kgfw_quat_t * out, const kgfw_quat_t * rot);
+KGFW_PUBLIC void kgfw_quat_rotate(float out[3], const kgfw_quat_t * rot, const float v[3]);
+/* zeroed caches are valid and rebuild on first use */
+KGFW_PUBLIC const kgfw_quat_t * kgfw_quat_cache_get(kgfw_quat_cache_t * cache, const float euler[3]);
+
+/* normalized planes of a view projection matrix, a point is inside when every plane distance is positive */
+KGFW_PUBLIC void kgfw_frustum_from(kgfw_frustum_t * out, const kgfw_mat4_t * vp);
+/* return 0 when the volume is fully outside, 1 when it may be visible */
+KGFW_PUBLIC int kgfw_frustum_sphere(const kgfw_frustum_t * frustum, const float center[3], float radius);
+KGFW_PUBLIC int kgfw_frustum_aabb(const kgfw_frustum_t * frustum, const float min[3], const float max[3]);
+
+#endif
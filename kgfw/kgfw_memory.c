@@ -0,0 +1,158 @@
+#include "kgfw_memory.h"
+#include "kgfw_thread.h"
+#include "kgfw_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* two 8 byte fields keep the user pointer at malloc's own alignment */
+typedef struct memory_header {
+	unsigned long long int size;
+	unsigned long long int tag;
+} memory_header_t;
+
+static struct {
+	kgfw_mutex_t mutex;
+	/* allocations before init happen on the main thread and skip the lock */
+	unsigned char initialized;
+	kgfw_memory_stats_t tags[KGFW_MEMORY_TAG_COUNT];
+} state = {
+	.initialized = 0,
+};
+
+static const char * tag_names[KGFW_MEMORY_TAG_COUNT] = {
+	"general",
+	"ecs",
+	"graphics",
+	"audio",
+	"console",
+	"koml",
+	"frame",
+};
+
+static void memory_lock(void) {
+	if (state.initialized) {
+		kgfw_mutex_lock(&state.mutex);
+	}
+}
+
+static void memory_unlock(void) {
+	if (state.initialized) {
+		kgfw_mutex_unlock(&state.mutex);
+	}
+}
+
+static void memory_track(unsigned long long int tag, unsigned long long int size) {
+	kgfw_memory_stats_t * stats = &state.tags[tag];
+	stats->current += size;
+	if (stats->current > stats->peak) {
+		stats->peak = stats->current;
+	}
+	++stats->allocations;
+	++stats->live;
+}
+
+static void memory_untrack(unsigned long long int tag, unsigned long long int size) {
+	kgfw_memory_stats_t * stats = &state.tags[tag];
+	stats->current -= size;
+	--stats->live;
+}
+
+int kgfw_memory_init(void) {
+	if (kgfw_mutex_init(&state.mutex) != 0) {
+		return 1;
+	}
+	state.initialized = 1;
+
+	return 0;
+}
+
+void kgfw_memory_deinit(void) {
+	#ifdef KGFW_DEBUG
+	for (unsigned int i = 0; i < KGFW_MEMORY_TAG_COUNT; ++i) {
+		if (state.tags[i].live > 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "%s leaked %llu bytes in %llu allocations", tag_names[i], state.tags[i].current, state.tags[i].live);
+		}
+	}
+	#endif
+
+	state.initialized = 0;
+	kgfw_mutex_deinit(&state.mutex);
+}
+
+void * kgfw_memory_alloc(unsigned long long int size, kgfw_memory_tag_enum tag) {
+	memory_header_t * header = malloc(sizeof(memory_header_t) + size);
+	if (header == NULL) {
+		return NULL;
+	}
+
+	header->size = size;
+	header->tag = tag;
+	memory_lock();
+	memory_track(tag, size);
+	memory_unlock();
+
+	return header + 1;
+}
+
+void * kgfw_memory_calloc(unsigned long long int count, unsigned long long int size, kgfw_memory_tag_enum tag) {
+	if (size != 0 && count > (~0ULL - sizeof(memory_header_t)) / size) {
+		return NULL;
+	}
+
+	void * p = kgfw_memory_alloc(count * size, tag);
+	if (p != NULL) {
+		memset(p, 0, count * size);
+	}
+
+	return p;
+}
+
+void * kgfw_memory_realloc(void * p, unsigned long long int size, kgfw_memory_tag_enum tag) {
+	if (p == NULL) {
+		return kgfw_memory_alloc(size, tag);
+	}
+
+	memory_header_t * header = ((memory_header_t *) p) - 1;
+	unsigned long long int old_size = header->size;
+	memory_header_t * resized = realloc(header, sizeof(memory_header_t) + size);
+	if (resized == NULL) {
+		return NULL;
+	}
+
+	resized->size = size;
+	memory_lock();
+	state.tags[resized->tag].current -= old_size;
+	state.tags[resized->tag].current += size;
+	if (state.tags[resized->tag].current > state.tags[resized->tag].peak) {
+		state.tags[resized->tag].peak = state.tags[resized->tag].current;
+	}
+	memory_unlock();
+
+	return resized + 1;
+}
+
+void kgfw_memory_free(void * p) {
+	if (p == NULL) {
+		return;
+	}
+
+	memory_header_t * header = ((memory_header_t *) p) - 1;
+	memory_lock();
+	memory_untrack(header->tag, header->size);
+	memory_unlock();
+	free(header);
+}
+
+void kgfw_memory_stats(kgfw_memory_tag_enum tag, kgfw_memory_stats_t * out_stats) {
+	memory_lock();
+	*out_stats = state.tags[tag];
+	memory_unlock();
+}
+
+const char * kgfw_memory_tag_name(kgfw_memory_tag_enum tag) {
+	if (tag >= KGFW_MEMORY_TAG_COUNT) {
+		return "unknown";
+	}
+
+	return tag_names[tag];
+}
@@ -0,0 +1,42 @@
+#ifndef KRISVERS_KGFW_MEMORY_H
+#define KRISVERS_KGFW_MEMORY_H
+
+#include "kgfw_defines.h"
+
+typedef enum kgfw_memory_tag {
+	KGFW_MEMORY_TAG_GENERAL = 0,
+	KGFW_MEMORY_TAG_ECS,
+	KGFW_MEMORY_TAG_GRAPHICS,
+	KGFW_MEMORY_TAG_AUDIO,
+	KGFW_MEMORY_TAG_CONSOLE,
+	KGFW_MEMORY_TAG_KOML,
+	KGFW_MEMORY_TAG_FRAME,
+	KGFW_MEMORY_TAG_COUNT,
+} kgfw_memory_tag_enum;
+
+typedef struct kgfw_memory_stats {
+	/* bytes currently held */
+	unsigned long long int current;
+	/* most bytes held at once */
+	unsigned long long int peak;
+	/* allocations made since init */
+	unsigned long long int allocations;
+	/* allocations not yet freed */
+	unsigned long long int live;
+} kgfw_memory_stats_t;
+
+KGFW_PUBLIC int kgfw_memory_init(void);
+/* logs every tag still holding memory when KGFW_DEBUG is defined */
+KGFW_PUBLIC void kgfw_memory_deinit(void);
+
+/* memory from these must only be released with kgfw_memory_free or resized with kgfw_memory_realloc */
+KGFW_PUBLIC void * kgfw_memory_alloc(unsigned long long int size, kgfw_memory_tag_enum tag);
+KGFW_PUBLIC void * kgfw_memory_calloc(unsigned long long int count, unsigned long long int size, kgfw_memory_tag_enum tag);
+/* p == NULL allocates, keeps the tag p was allocated with */
+KGFW_PUBLIC void * kgfw_memory_realloc(void * p, unsigned long long int size, kgfw_memory_tag_enum tag);
+KGFW_PUBLIC void kgfw_memory_free(void * p);
+
+KGFW_PUBLIC void kgfw_memory_stats(kgfw_memory_tag_enum tag, kgfw_memory_stats_t * out_stats);
+KGFW_PUBLIC const char * kgfw_memory_tag_name(kgfw_memory_tag_enum tag);
+
+#endif
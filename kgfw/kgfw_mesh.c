@@ -0,0 +1,924 @@
+#include "kgfw_mesh.h"
+#include "kgfw_log.h"
+#include "kgfw_memory.h"
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KGFW_MESH_CACHE_MAGIC 0x4b4d4331
+#define KGFW_MESH_CACHE_VERSION 2
+
+typedef struct mesh_cache_header {
+	unsigned int magic;
+	unsigned int version;
+	unsigned long long int source_hash;
+	unsigned long long int vertices_count;
+	unsigned long long int indices_count;
+	unsigned long long int lods_count;
+} mesh_cache_header_t;
+
+typedef struct mesh_cache_lod {
+	unsigned long long int indices_count;
+	float error;
+} mesh_cache_lod_t;
+
+/* triangles adjacent to each vertex, triangles of vertex v are triangles[offsets[v]] to triangles[offsets[v] + counts[v]] */
+typedef struct adjacency {
+	unsigned int * counts;
+	unsigned int * offsets;
+	unsigned int * triangles;
+} adjacency_t;
+
+static int adjacency_build(adjacency_t * adj, const unsigned int * indices, unsigned long long int indices_count, unsigned long long int vertices_count) {
+	adj->counts = kgfw_memory_calloc(vertices_count, sizeof(unsigned int), KGFW_MEMORY_TAG_GRAPHICS);
+	adj->offsets = kgfw_memory_alloc(sizeof(unsigned int) * vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	adj->triangles = kgfw_memory_alloc(sizeof(unsigned int) * indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (adj->counts == NULL || adj->offsets == NULL || adj->triangles == NULL) {
+		kgfw_memory_free(adj->counts);
+		kgfw_memory_free(adj->offsets);
+		kgfw_memory_free(adj->triangles);
+		return 1;
+	}
+
+	for (unsigned long long int i = 0; i < indices_count; ++i) {
+		++adj->counts[indices[i]];
+	}
+
+	unsigned int offset = 0;
+	for (unsigned long long int v = 0; v < vertices_count; ++v) {
+		adj->offsets[v] = offset;
+		offset += adj->counts[v];
+		adj->counts[v] = 0;
+	}
+
+	for (unsigned long long int i = 0; i < indices_count; ++i) {
+		unsigned int v = indices[i];
+		adj->triangles[adj->offsets[v] + adj->counts[v]++] = (unsigned int) (i / 3);
+	}
+
+	return 0;
+}
+
+static void adjacency_destroy(adjacency_t * adj) {
+	kgfw_memory_free(adj->counts);
+	kgfw_memory_free(adj->offsets);
+	kgfw_memory_free(adj->triangles);
+}
+
+void kgfw_mesh_analyze(const unsigned int * indices, unsigned long long int indices_count, unsigned long long int vertices_count, unsigned int cache_size, kgfw_mesh_stats_t * out_stats) {
+	out_stats->acmr = 0;
+	out_stats->atvr = 0;
+	if (indices_count < 3 || vertices_count == 0) {
+		return;
+	}
+
+	/* timestamps instead of an explicit fifo, a vertex is cached while it was inserted less than cache_size misses ago */
+	unsigned long long int * inserted = kgfw_memory_calloc(vertices_count, sizeof(unsigned long long int), KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned char * seen = kgfw_memory_calloc(vertices_count, 1, KGFW_MEMORY_TAG_GRAPHICS);
+	if (inserted == NULL || seen == NULL) {
+		kgfw_memory_free(inserted);
+		kgfw_memory_free(seen);
+		return;
+	}
+
+	unsigned long long int misses = 0;
+	unsigned long long int unique = 0;
+	for (unsigned long long int i = 0; i < indices_count; ++i) {
+		unsigned int v = indices[i];
+		if (!seen[v]) {
+			seen[v] = 1;
+			++unique;
+		}
+
+		if (inserted[v] == 0 || misses - inserted[v] >= cache_size) {
+			++misses;
+			inserted[v] = misses;
+		}
+	}
+
+	out_stats->acmr = (float) misses / (float) (indices_count / 3);
+	out_stats->atvr = (unique == 0) ? 0 : (float) misses / (float) unique;
+
+	kgfw_memory_free(inserted);
+	kgfw_memory_free(seen);
+}
+
+/* Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" */
+int kgfw_mesh_optimize_vertex_cache(unsigned int * indices, unsigned long long int indices_count, unsigned long long int vertices_count, unsigned int cache_size) {
+	/* trailing indices of a partial triangle would index past the per triangle arrays */
+	if (indices_count % 3 != 0) {
+		return 1;
+	}
+
+	unsigned long long int triangles_count = indices_count / 3;
+	if (triangles_count == 0 || vertices_count == 0) {
+		return 0;
+	}
+
+	adjacency_t adj;
+	if (adjacency_build(&adj, indices, indices_count, vertices_count) != 0) {
+		return 1;
+	}
+
+	unsigned int * live = kgfw_memory_alloc(sizeof(unsigned int) * vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned long long int * stamps = kgfw_memory_calloc(vertices_count, sizeof(unsigned long long int), KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned char * emitted = kgfw_memory_calloc(triangles_count, 1, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned int * dead_ends = kgfw_memory_alloc(sizeof(unsigned int) * indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned int * candidates = kgfw_memory_alloc(sizeof(unsigned int) * indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned int * output = kgfw_memory_alloc(sizeof(unsigned int) * indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (live == NULL || stamps == NULL || emitted == NULL || dead_ends == NULL || candidates == NULL || output == NULL) {
+		kgfw_memory_free(live);
+		kgfw_memory_free(stamps);
+		kgfw_memory_free(emitted);
+		kgfw_memory_free(dead_ends);
+		kgfw_memory_free(candidates);
+		kgfw_memory_free(output);
+		adjacency_destroy(&adj);
+		return 1;
+	}
+
+	memcpy(live, adj.counts, sizeof(unsigned int) * vertices_count);
+
+	unsigned long long int dead_ends_count = 0;
+	unsigned long long int output_count = 0;
+	unsigned long long int time = cache_size + 1;
+	unsigned long long int cursor = 1;
+	long long int fanning = 0;
+
+	while (fanning >= 0) {
+		unsigned long long int candidates_count = 0;
+		unsigned int f = (unsigned int) fanning;
+
+		for (unsigned int t = 0; t < adj.counts[f]; ++t) {
+			unsigned int triangle = adj.triangles[adj.offsets[f] + t];
+			if (emitted[triangle]) {
+				continue;
+			}
+
+			for (unsigned int k = 0; k < 3; ++k) {
+				unsigned int v = indices[triangle * 3 + k];
+				output[output_count++] = v;
+				dead_ends[dead_ends_count++] = v;
+				candidates[candidates_count++] = v;
+				--live[v];
+				if (time - stamps[v] > cache_size) {
+					stamps[v] = time++;
+				}
+			}
+			emitted[triangle] = 1;
+		}
+
+		/* prefer the candidate that stays in cache the longest while still having live triangles */
+		long long int best = -1;
+		long long int best_priority = -1;
+		for (unsigned long long int i = 0; i < candidates_count; ++i) {
+			unsigned int v = candidates[i];
+			if (live[v] == 0) {
+				continue;
+			}
+
+			long long int priority = 0;
+			if (time - stamps[v] + 2 * live[v] <= cache_size) {
+				priority = time - stamps[v];
+			}
+			if (priority > best_priority) {
+				best = v;
+				best_priority = priority;
+			}
+		}
+
+		if (best == -1) {
+			while (dead_ends_count > 0) {
+				unsigned int v = dead_ends[--dead_ends_count];
+				if (live[v] > 0) {
+					best = v;
+					break;
+				}
+			}
+		}
+
+		if (best == -1) {
+			while (cursor < vertices_count) {
+				if (live[cursor] > 0) {
+					best = cursor;
+					break;
+				}
+				++cursor;
+			}
+		}
+
+		fanning = best;
+	}
+
+	memcpy(indices, output, sizeof(unsigned int) * output_count);
+
+	kgfw_memory_free(live);
+	kgfw_memory_free(stamps);
+	kgfw_memory_free(emitted);
+	kgfw_memory_free(dead_ends);
+	kgfw_memory_free(candidates);
+	kgfw_memory_free(output);
+	adjacency_destroy(&adj);
+	return 0;
+}
+
+typedef struct overdraw_cluster {
+	unsigned long long int begin;
+	unsigned long long int end;
+	float sort;
+} overdraw_cluster_t;
+
+static int cluster_compare(const void * a, const void * b) {
+	float sa = ((const overdraw_cluster_t *) a)->sort;
+	float sb = ((const overdraw_cluster_t *) b)->sort;
+	return (sa < sb) - (sa > sb);
+}
+
+int kgfw_mesh_optimize_overdraw(unsigned int * indices, unsigned long long int indices_count, const kgfw_graphics_vertex_t * vertices, unsigned long long int vertices_count, unsigned int cache_size, float threshold) {
+	unsigned long long int triangles_count = indices_count / 3;
+	if (triangles_count < 2) {
+		return 0;
+	}
+
+	overdraw_cluster_t * clusters = kgfw_memory_alloc(sizeof(overdraw_cluster_t) * triangles_count, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned long long int * inserted = kgfw_memory_calloc(vertices_count, sizeof(unsigned long long int), KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned int * sorted = kgfw_memory_alloc(sizeof(unsigned int) * indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (clusters == NULL || inserted == NULL || sorted == NULL) {
+		kgfw_memory_free(clusters);
+		kgfw_memory_free(inserted);
+		kgfw_memory_free(sorted);
+		return 1;
+	}
+
+	/* a triangle that misses the cache on all three vertices starts a new cluster, this is where the cache order restarted anyway */
+	unsigned long long int clusters_count = 0;
+	unsigned long long int misses = 0;
+	for (unsigned long long int t = 0; t < triangles_count; ++t) {
+		unsigned int triangle_misses = 0;
+		for (unsigned int k = 0; k < 3; ++k) {
+			unsigned int v = indices[t * 3 + k];
+			if (inserted[v] == 0 || misses - inserted[v] >= cache_size) {
+				++misses;
+				++triangle_misses;
+				inserted[v] = misses;
+			}
+		}
+
+		if (t == 0 || triangle_misses == 3) {
+			if (clusters_count > 0) {
+				clusters[clusters_count - 1].end = t * 3;
+			}
+			clusters[clusters_count].begin = t * 3;
+			++clusters_count;
+		}
+	}
+	clusters[clusters_count - 1].end = indices_count;
+
+	/* clusters facing away from the mesh center are likely in front, so they are drawn first */
+	vec3 center = { 0, 0, 0 };
+	float total_area = 0;
+	for (unsigned long long int t = 0; t < triangles_count; ++t) {
+		const kgfw_graphics_vertex_t * a = &vertices[indices[t * 3 + 0]];
+		const kgfw_graphics_vertex_t * b = &vertices[indices[t * 3 + 1]];
+		const kgfw_graphics_vertex_t * c = &vertices[indices[t * 3 + 2]];
+		vec3 e1 = { b->x - a->x, b->y - a->y, b->z - a->z };
+		vec3 e2 = { c->x - a->x, c->y - a->y, c->z - a->z };
+		vec3 n;
+		vec3_mul_cross(n, e1, e2);
+		float area = vec3_len(n);
+
+		center[0] += (a->x + b->x + c->x) / 3 * area;
+		center[1] += (a->y + b->y + c->y) / 3 * area;
+		center[2] += (a->z + b->z + c->z) / 3 * area;
+		total_area += area;
+	}
+	if (total_area > 0) {
+		vec3_scale(center, center, 1.0f / total_area);
+	}
+
+	for (unsigned long long int i = 0; i < clusters_count; ++i) {
+		vec3 centroid = { 0, 0, 0 };
+		vec3 normal = { 0, 0, 0 };
+		float area_sum = 0;
+		for (unsigned long long int j = clusters[i].begin; j < clusters[i].end; j += 3) {
+			const kgfw_graphics_vertex_t * a = &vertices[indices[j + 0]];
+			const kgfw_graphics_vertex_t * b = &vertices[indices[j + 1]];
+			const kgfw_graphics_vertex_t * c = &vertices[indices[j + 2]];
+			vec3 e1 = { b->x - a->x, b->y - a->y, b->z - a->z };
+			vec3 e2 = { c->x - a->x, c->y - a->y, c->z - a->z };
+			vec3 n;
+			vec3_mul_cross(n, e1, e2);
+			float area = vec3_len(n);
+
+			centroid[0] += (a->x + b->x + c->x) / 3 * area;
+			centroid[1] += (a->y + b->y + c->y) / 3 * area;
+			centroid[2] += (a->z + b->z + c->z) / 3 * area;
+			vec3_add(normal, normal, n);
+			area_sum += area;
+		}
+
+		if (area_sum > 0) {
+			vec3_scale(centroid, centroid, 1.0f / area_sum);
+		}
+		float length = vec3_len(normal);
+		if (length > 0) {
+			vec3_scale(normal, normal, 1.0f / length);
+		}
+
+		vec3 offset;
+		vec3_sub(offset, centroid, center);
+		clusters[i].sort = vec3_mul_inner(offset, normal);
+	}
+
+	qsort(clusters, clusters_count, sizeof(overdraw_cluster_t), cluster_compare);
+
+	unsigned long long int offset = 0;
+	for (unsigned long long int i = 0; i < clusters_count; ++i) {
+		unsigned long long int length = clusters[i].end - clusters[i].begin;
+		memcpy(sorted + offset, indices + clusters[i].begin, sizeof(unsigned int) * length);
+		offset += length;
+	}
+
+	kgfw_mesh_stats_t before;
+	kgfw_mesh_stats_t after;
+	kgfw_mesh_analyze(indices, indices_count, vertices_count, cache_size, &before);
+	kgfw_mesh_analyze(sorted, indices_count, vertices_count, cache_size, &after);
+	if (after.acmr <= before.acmr * threshold) {
+		memcpy(indices, sorted, sizeof(unsigned int) * indices_count);
+	}
+
+	kgfw_memory_free(clusters);
+	kgfw_memory_free(inserted);
+	kgfw_memory_free(sorted);
+	return 0;
+}
+
+int kgfw_mesh_optimize_vertex_fetch(kgfw_graphics_mesh_t * mesh) {
+	unsigned int * remap = kgfw_memory_alloc(sizeof(unsigned int) * mesh->vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	kgfw_graphics_vertex_t * vertices = kgfw_memory_alloc(sizeof(kgfw_graphics_vertex_t) * mesh->vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (remap == NULL || vertices == NULL) {
+		kgfw_memory_free(remap);
+		kgfw_memory_free(vertices);
+		return 1;
+	}
+
+	memset(remap, 0xFF, sizeof(unsigned int) * mesh->vertices_count);
+
+	unsigned int next = 0;
+	for (unsigned long long int i = 0; i < mesh->indices_count; ++i) {
+		unsigned int v = mesh->indices[i];
+		if (remap[v] == 0xFFFFFFFF) {
+			remap[v] = next;
+			vertices[next] = mesh->vertices[v];
+			++next;
+		}
+		mesh->indices[i] = remap[v];
+	}
+
+	kgfw_memory_free(mesh->vertices);
+	kgfw_memory_free(remap);
+	mesh->vertices = vertices;
+	mesh->vertices_count = next;
+	return 0;
+}
+
+int kgfw_mesh_optimize(kgfw_graphics_mesh_t * mesh, kgfw_mesh_stats_t * out_before, kgfw_mesh_stats_t * out_after) {
+	if (out_before != NULL) {
+		kgfw_mesh_analyze(mesh->indices, mesh->indices_count, mesh->vertices_count, KGFW_MESH_CACHE_SIZE, out_before);
+	}
+
+	if (kgfw_mesh_optimize_vertex_cache(mesh->indices, mesh->indices_count, mesh->vertices_count, KGFW_MESH_CACHE_SIZE) != 0) {
+		return 1;
+	}
+	if (kgfw_mesh_optimize_overdraw(mesh->indices, mesh->indices_count, mesh->vertices, mesh->vertices_count, KGFW_MESH_CACHE_SIZE, 1.05f) != 0) {
+		return 2;
+	}
+	if (kgfw_mesh_optimize_vertex_fetch(mesh) != 0) {
+		return 3;
+	}
+
+	if (out_after != NULL) {
+		kgfw_mesh_analyze(mesh->indices, mesh->indices_count, mesh->vertices_count, KGFW_MESH_CACHE_SIZE, out_after);
+	}
+
+	return 0;
+}
+
+typedef struct quadric {
+	double a, b, c, d, e, f, g, h, i, j;
+} quadric_t;
+
+static void quadric_plane(quadric_t * q, double a, double b, double c, double d, double weight) {
+	q->a = a * a * weight;
+	q->b = a * b * weight;
+	q->c = a * c * weight;
+	q->d = a * d * weight;
+	q->e = b * b * weight;
+	q->f = b * c * weight;
+	q->g = b * d * weight;
+	q->h = c * c * weight;
+	q->i = c * d * weight;
+	q->j = d * d * weight;
+}
+
+static void quadric_add(quadric_t * q, const quadric_t * r) {
+	q->a += r->a;
+	q->b += r->b;
+	q->c += r->c;
+	q->d += r->d;
+	q->e += r->e;
+	q->f += r->f;
+	q->g += r->g;
+	q->h += r->h;
+	q->i += r->i;
+	q->j += r->j;
+}
+
+static double quadric_error(const quadric_t * q, const kgfw_graphics_vertex_t * v) {
+	double x = v->x;
+	double y = v->y;
+	double z = v->z;
+	double error = q->a * x * x + 2 * q->b * x * y + 2 * q->c * x * z + 2 * q->d * x
+		+ q->e * y * y + 2 * q->f * y * z + 2 * q->g * y
+		+ q->h * z * z + 2 * q->i * z
+		+ q->j;
+	return (error < 0) ? 0 : error;
+}
+
+typedef struct collapse {
+	unsigned int from;
+	unsigned int to;
+	double error;
+} collapse_t;
+
+static int collapse_compare(const void * a, const void * b) {
+	double ea = ((const collapse_t *) a)->error;
+	double eb = ((const collapse_t *) b)->error;
+	return (ea > eb) - (ea < eb);
+}
+
+static unsigned int position_hash(const kgfw_graphics_vertex_t * v) {
+	unsigned int bits[3];
+	memcpy(&bits[0], &v->x, sizeof(unsigned int));
+	memcpy(&bits[1], &v->y, sizeof(unsigned int));
+	memcpy(&bits[2], &v->z, sizeof(unsigned int));
+	return (bits[0] * 73856093) ^ (bits[1] * 19349663) ^ (bits[2] * 83492791);
+}
+
+/* vertices sharing a position with another vertex (uv or normal seams) and vertices on open borders never move */
+static unsigned char * vertices_locked(const kgfw_graphics_vertex_t * vertices, unsigned long long int vertices_count, const unsigned int * indices, unsigned long long int indices_count, const adjacency_t * adj) {
+	unsigned char * locked = kgfw_memory_calloc(vertices_count, 1, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned long long int buckets = 1;
+	while (buckets < vertices_count * 2) {
+		buckets <<= 1;
+	}
+	unsigned int * table = kgfw_memory_alloc(sizeof(unsigned int) * buckets, KGFW_MEMORY_TAG_GRAPHICS);
+	if (locked == NULL || table == NULL) {
+		kgfw_memory_free(locked);
+		kgfw_memory_free(table);
+		return NULL;
+	}
+	memset(table, 0xFF, sizeof(unsigned int) * buckets);
+
+	for (unsigned long long int v = 0; v < vertices_count; ++v) {
+		unsigned long long int slot = position_hash(&vertices[v]) & (buckets - 1);
+		while (table[slot] != 0xFFFFFFFF) {
+			const kgfw_graphics_vertex_t * o = &vertices[table[slot]];
+			if (o->x == vertices[v].x && o->y == vertices[v].y && o->z == vertices[v].z) {
+				locked[v] = 1;
+				locked[table[slot]] = 1;
+				break;
+			}
+			slot = (slot + 1) & (buckets - 1);
+		}
+		if (table[slot] == 0xFFFFFFFF) {
+			table[slot] = (unsigned int) v;
+		}
+	}
+	kgfw_memory_free(table);
+
+	/* an edge is on a border when no other triangle uses it in the opposite direction */
+	for (unsigned long long int i = 0; i < indices_count; ++i) {
+		unsigned int a = indices[i];
+		unsigned int b = indices[(i % 3 == 2) ? i - 2 : i + 1];
+		unsigned char shared = 0;
+		for (unsigned int t = 0; t < adj->counts[b] && !shared; ++t) {
+			unsigned int triangle = adj->triangles[adj->offsets[b] + t];
+			for (unsigned int k = 0; k < 3; ++k) {
+				if (indices[triangle * 3 + k] == b && indices[triangle * 3 + (k + 1) % 3] == a) {
+					shared = 1;
+					break;
+				}
+			}
+		}
+		if (!shared) {
+			locked[a] = 1;
+			locked[b] = 1;
+		}
+	}
+
+	return locked;
+}
+
+/* moving from onto to must not flip any triangle around from that survives the collapse */
+static unsigned char collapse_flips(const kgfw_graphics_vertex_t * vertices, const unsigned int * indices, const adjacency_t * adj, unsigned int from, unsigned int to) {
+	const kgfw_graphics_vertex_t * f = &vertices[from];
+	const kgfw_graphics_vertex_t * t = &vertices[to];
+	for (unsigned int i = 0; i < adj->counts[from]; ++i) {
+		unsigned int triangle = adj->triangles[adj->offsets[from] + i];
+		unsigned int k = 0;
+		while (indices[triangle * 3 + k] != from) {
+			++k;
+		}
+		unsigned int b = indices[triangle * 3 + (k + 1) % 3];
+		unsigned int c = indices[triangle * 3 + (k + 2) % 3];
+		if (b == to || c == to) {
+			continue;
+		}
+
+		const kgfw_graphics_vertex_t * vb = &vertices[b];
+		const kgfw_graphics_vertex_t * vc = &vertices[c];
+		vec3 e1 = { vb->x - f->x, vb->y - f->y, vb->z - f->z };
+		vec3 e2 = { vc->x - f->x, vc->y - f->y, vc->z - f->z };
+		vec3 n0;
+		vec3_mul_cross(n0, e1, e2);
+		vec3 e3 = { vb->x - t->x, vb->y - t->y, vb->z - t->z };
+		vec3 e4 = { vc->x - t->x, vc->y - t->y, vc->z - t->z };
+		vec3 n1;
+		vec3_mul_cross(n1, e3, e4);
+		if (vec3_mul_inner(n0, n1) <= 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+unsigned long long int kgfw_mesh_simplify(const kgfw_graphics_vertex_t * vertices, unsigned long long int vertices_count, const unsigned int * indices, unsigned long long int indices_count, unsigned long long int target_indices_count, float target_error, unsigned int * out_indices, float * out_error) {
+	memcpy(out_indices, indices, sizeof(unsigned int) * indices_count);
+	if (out_error != NULL) {
+		*out_error = 0;
+	}
+	/* partial triangles are left alone, the per triangle passes would read past the indices */
+	if (indices_count <= target_indices_count || vertices_count == 0 || indices_count % 3 != 0) {
+		return indices_count;
+	}
+
+	adjacency_t adj;
+	if (adjacency_build(&adj, indices, indices_count, vertices_count) != 0) {
+		return indices_count;
+	}
+
+	quadric_t * quadrics = kgfw_memory_calloc(vertices_count, sizeof(quadric_t), KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned char * locked = vertices_locked(vertices, vertices_count, indices, indices_count, &adj);
+	unsigned int * remap = kgfw_memory_alloc(sizeof(unsigned int) * vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned char * touched = kgfw_memory_alloc(vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	collapse_t * collapses = kgfw_memory_alloc(sizeof(collapse_t) * indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	adjacency_destroy(&adj);
+	if (quadrics == NULL || locked == NULL || remap == NULL || touched == NULL || collapses == NULL) {
+		kgfw_memory_free(quadrics);
+		kgfw_memory_free(locked);
+		kgfw_memory_free(remap);
+		kgfw_memory_free(touched);
+		kgfw_memory_free(collapses);
+		return indices_count;
+	}
+
+	for (unsigned long long int i = 0; i < indices_count; i += 3) {
+		const kgfw_graphics_vertex_t * a = &vertices[indices[i + 0]];
+		const kgfw_graphics_vertex_t * b = &vertices[indices[i + 1]];
+		const kgfw_graphics_vertex_t * c = &vertices[indices[i + 2]];
+		vec3 e1 = { b->x - a->x, b->y - a->y, b->z - a->z };
+		vec3 e2 = { c->x - a->x, c->y - a->y, c->z - a->z };
+		vec3 n;
+		vec3_mul_cross(n, e1, e2);
+		float area = vec3_len(n);
+		if (area <= 0) {
+			continue;
+		}
+		vec3_scale(n, n, 1.0f / area);
+
+		quadric_t q;
+		quadric_plane(&q, n[0], n[1], n[2], -(n[0] * a->x + n[1] * a->y + n[2] * a->z), area * 0.5);
+		for (unsigned int k = 0; k < 3; ++k) {
+			quadric_add(&quadrics[indices[i + k]], &q);
+		}
+	}
+
+	double error_limit = (double) target_error * target_error;
+	double error_max = 0;
+	unsigned long long int count = indices_count;
+	while (count > target_indices_count) {
+		if (adjacency_build(&adj, out_indices, count, vertices_count) != 0) {
+			break;
+		}
+
+		unsigned long long int collapses_count = 0;
+		for (unsigned long long int i = 0; i < count; ++i) {
+			unsigned int from = out_indices[i];
+			unsigned int to = out_indices[(i % 3 == 2) ? i - 2 : i + 1];
+			if (locked[from]) {
+				continue;
+			}
+
+			quadric_t q = quadrics[from];
+			quadric_add(&q, &quadrics[to]);
+			collapses[collapses_count].from = from;
+			collapses[collapses_count].to = to;
+			collapses[collapses_count].error = quadric_error(&q, &vertices[to]);
+			++collapses_count;
+		}
+
+		qsort(collapses, collapses_count, sizeof(collapse_t), collapse_compare);
+
+		for (unsigned long long int v = 0; v < vertices_count; ++v) {
+			remap[v] = (unsigned int) v;
+		}
+		memset(touched, 0, vertices_count);
+
+		/* every collapse removes roughly two triangles, collapses are kept independent so flip checks stay valid within a pass */
+		unsigned long long int needed = (count - target_indices_count) / 6 + 1;
+		unsigned long long int performed = 0;
+		for (unsigned long long int i = 0; i < collapses_count && performed < needed; ++i) {
+			collapse_t * c = &collapses[i];
+			if (c->error > error_limit) {
+				break;
+			}
+			if (touched[c->from] || touched[c->to]) {
+				continue;
+			}
+			if (collapse_flips(vertices, out_indices, &adj, c->from, c->to)) {
+				continue;
+			}
+
+			remap[c->from] = c->to;
+			quadric_add(&quadrics[c->to], &quadrics[c->from]);
+			if (c->error > error_max) {
+				error_max = c->error;
+			}
+
+			for (unsigned int t = 0; t < adj.counts[c->from]; ++t) {
+				unsigned int triangle = adj.triangles[adj.offsets[c->from] + t];
+				touched[out_indices[triangle * 3 + 0]] = 1;
+				touched[out_indices[triangle * 3 + 1]] = 1;
+				touched[out_indices[triangle * 3 + 2]] = 1;
+			}
+			++performed;
+		}
+		adjacency_destroy(&adj);
+
+		if (performed == 0) {
+			break;
+		}
+
+		unsigned long long int write = 0;
+		for (unsigned long long int i = 0; i < count; i += 3) {
+			unsigned int a = remap[out_indices[i + 0]];
+			unsigned int b = remap[out_indices[i + 1]];
+			unsigned int c = remap[out_indices[i + 2]];
+			if (a == b || b == c || c == a) {
+				continue;
+			}
+			out_indices[write++] = a;
+			out_indices[write++] = b;
+			out_indices[write++] = c;
+		}
+		count = write;
+	}
+
+	if (out_error != NULL) {
+		*out_error = (float) sqrt(error_max);
+	}
+
+	kgfw_memory_free(quadrics);
+	kgfw_memory_free(locked);
+	kgfw_memory_free(remap);
+	kgfw_memory_free(touched);
+	kgfw_memory_free(collapses);
+	return count;
+}
+
+int kgfw_mesh_lods_generate(kgfw_graphics_mesh_t * mesh, unsigned long long int lods_count) {
+	kgfw_mesh_lods_destroy(mesh);
+	if (lods_count > KGFW_GRAPHICS_MESH_LODS_MAX) {
+		lods_count = KGFW_GRAPHICS_MESH_LODS_MAX;
+	}
+	if (lods_count == 0 || mesh->indices_count < 3) {
+		return 0;
+	}
+
+	mesh->lods = kgfw_memory_calloc(lods_count, sizeof(kgfw_graphics_mesh_lod_t), KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned int * scratch = kgfw_memory_alloc(sizeof(unsigned int) * mesh->indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (mesh->lods == NULL || scratch == NULL) {
+		kgfw_memory_free(mesh->lods);
+		kgfw_memory_free(scratch);
+		mesh->lods = NULL;
+		return 1;
+	}
+
+	/* each level simplifies the previous one, errors accumulate so they are summed */
+	const unsigned int * source = mesh->indices;
+	unsigned long long int source_count = mesh->indices_count;
+	float error = 0;
+	for (unsigned long long int l = 0; l < lods_count; ++l) {
+		unsigned long long int target = (source_count / 6) * 3;
+		float lod_error = 0;
+		unsigned long long int count = kgfw_mesh_simplify(mesh->vertices, mesh->vertices_count, source, source_count, target, FLT_MAX, scratch, &lod_error);
+		/* not worth a level if it barely reduced anything */
+		if (count == 0 || count > source_count - source_count / 4) {
+			break;
+		}
+
+		kgfw_graphics_mesh_lod_t * lod = &mesh->lods[mesh->lods_count];
+		lod->indices = kgfw_memory_alloc(sizeof(unsigned int) * count, KGFW_MEMORY_TAG_GRAPHICS);
+		if (lod->indices == NULL) {
+			break;
+		}
+		memcpy(lod->indices, scratch, sizeof(unsigned int) * count);
+		lod->indices_count = count;
+		error += lod_error;
+		lod->error = error;
+		kgfw_mesh_optimize_vertex_cache(lod->indices, lod->indices_count, mesh->vertices_count, KGFW_MESH_CACHE_SIZE);
+		++mesh->lods_count;
+
+		source = lod->indices;
+		source_count = count;
+	}
+
+	kgfw_memory_free(scratch);
+	if (mesh->lods_count == 0) {
+		kgfw_memory_free(mesh->lods);
+		mesh->lods = NULL;
+	}
+	return 0;
+}
+
+void kgfw_mesh_lods_destroy(kgfw_graphics_mesh_t * mesh) {
+	for (unsigned long long int i = 0; i < mesh->lods_count; ++i) {
+		kgfw_memory_free(mesh->lods[i].indices);
+	}
+	kgfw_memory_free(mesh->lods);
+	mesh->lods = NULL;
+	mesh->lods_count = 0;
+}
+
+unsigned short int * kgfw_mesh_indices_narrow(const kgfw_graphics_mesh_t * mesh) {
+	if (mesh->vertices_count > 65536) {
+		return NULL;
+	}
+
+	unsigned short int * indices = kgfw_memory_alloc(sizeof(unsigned short int) * mesh->indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (indices == NULL) {
+		return NULL;
+	}
+
+	for (unsigned long long int i = 0; i < mesh->indices_count; ++i) {
+		indices[i] = (unsigned short int) mesh->indices[i];
+	}
+
+	return indices;
+}
+
+static int indices_valid(const unsigned int * indices, unsigned long long int indices_count, unsigned long long int vertices_count) {
+	for (unsigned long long int i = 0; i < indices_count; ++i) {
+		if (indices[i] >= vertices_count) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int kgfw_mesh_cache_load(const char * path, kgfw_hash_t source_hash, kgfw_graphics_mesh_t * out_mesh) {
+	FILE * fp = fopen(path, "rb");
+	if (fp == NULL) {
+		return 1;
+	}
+
+	/* counts come from the file, they are checked against its length before anything is allocated */
+	long length = -1;
+	if (fseek(fp, 0, SEEK_END) == 0) {
+		length = ftell(fp);
+		if (fseek(fp, 0, SEEK_SET) != 0) {
+			length = -1;
+		}
+	}
+
+	mesh_cache_header_t header;
+	if (length < (long) sizeof(header) || fread(&header, sizeof(header), 1, fp) != 1 || header.magic != KGFW_MESH_CACHE_MAGIC || header.version != KGFW_MESH_CACHE_VERSION || header.source_hash != source_hash || header.lods_count > KGFW_GRAPHICS_MESH_LODS_MAX) {
+		fclose(fp);
+		return 2;
+	}
+
+	unsigned long long int remaining = (unsigned long long int) length - sizeof(header);
+	if (header.vertices_count > remaining / sizeof(kgfw_graphics_vertex_t) || header.indices_count > (remaining - header.vertices_count * sizeof(kgfw_graphics_vertex_t)) / sizeof(unsigned int)) {
+		fclose(fp);
+		return 2;
+	}
+	remaining -= header.vertices_count * sizeof(kgfw_graphics_vertex_t) + header.indices_count * sizeof(unsigned int);
+
+	kgfw_graphics_vertex_t * vertices = kgfw_memory_alloc(sizeof(kgfw_graphics_vertex_t) * header.vertices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	unsigned int * indices = kgfw_memory_alloc(sizeof(unsigned int) * header.indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+	if (vertices == NULL || indices == NULL) {
+		kgfw_memory_free(vertices);
+		kgfw_memory_free(indices);
+		fclose(fp);
+		return 3;
+	}
+
+	/* an index past the vertices would be read by the optimizer, static batching and the gpu */
+	if (fread(vertices, sizeof(kgfw_graphics_vertex_t), header.vertices_count, fp) != header.vertices_count || fread(indices, sizeof(unsigned int), header.indices_count, fp) != header.indices_count || !indices_valid(indices, header.indices_count, header.vertices_count)) {
+		kgfw_memory_free(vertices);
+		kgfw_memory_free(indices);
+		fclose(fp);
+		return 4;
+	}
+
+	out_mesh->vertices = vertices;
+	out_mesh->vertices_count = header.vertices_count;
+	out_mesh->indices = indices;
+	out_mesh->indices_count = header.indices_count;
+	out_mesh->lods = NULL;
+	out_mesh->lods_count = 0;
+	if (header.lods_count == 0) {
+		fclose(fp);
+		return 0;
+	}
+
+	out_mesh->lods = kgfw_memory_calloc(header.lods_count, sizeof(kgfw_graphics_mesh_lod_t), KGFW_MEMORY_TAG_GRAPHICS);
+	if (out_mesh->lods == NULL) {
+		fclose(fp);
+		return 0;
+	}
+
+	/* a bad lod rejects the whole cache so the source is processed again */
+	for (unsigned long long int i = 0; i < header.lods_count; ++i) {
+		mesh_cache_lod_t lod;
+		if (remaining < sizeof(lod) || fread(&lod, sizeof(lod), 1, fp) != 1 || lod.indices_count > header.indices_count || lod.indices_count > (remaining - sizeof(lod)) / sizeof(unsigned int)) {
+			goto invalid;
+		}
+		remaining -= sizeof(lod) + lod.indices_count * sizeof(unsigned int);
+
+		kgfw_graphics_mesh_lod_t * l = &out_mesh->lods[out_mesh->lods_count];
+		l->indices = kgfw_memory_alloc(sizeof(unsigned int) * lod.indices_count, KGFW_MEMORY_TAG_GRAPHICS);
+		if (l->indices == NULL) {
+			goto invalid;
+		}
+		if (fread(l->indices, sizeof(unsigned int), lod.indices_count, fp) != lod.indices_count || !indices_valid(l->indices, lod.indices_count, header.vertices_count)) {
+			kgfw_memory_free(l->indices);
+			l->indices = NULL;
+			goto invalid;
+		}
+		l->indices_count = lod.indices_count;
+		l->error = lod.error;
+		++out_mesh->lods_count;
+	}
+
+	fclose(fp);
+	return 0;
+
+invalid:
+	kgfw_mesh_lods_destroy(out_mesh);
+	kgfw_memory_free(out_mesh->vertices);
+	kgfw_memory_free(out_mesh->indices);
+	out_mesh->vertices = NULL;
+	out_mesh->vertices_count = 0;
+	out_mesh->indices = NULL;
+	out_mesh->indices_count = 0;
+	fclose(fp);
+	return 5;
+}
+
+int kgfw_mesh_cache_save(const char * path, kgfw_hash_t source_hash, const kgfw_graphics_mesh_t * mesh) {
+	FILE * fp = fopen(path, "wb");
+	if (fp == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to open mesh cache \"%s\" for writing", path);
+		return 1;
+	}
+
+	mesh_cache_header_t header = {
+		KGFW_MESH_CACHE_MAGIC, KGFW_MESH_CACHE_VERSION,
+		source_hash, mesh->vertices_count, mesh->indices_count,
+		mesh->lods_count,
+	};
+
+	if (fwrite(&header, sizeof(header), 1, fp) != 1 || fwrite(mesh->vertices, sizeof(kgfw_graphics_vertex_t), mesh->vertices_count, fp) != mesh->vertices_count || fwrite(mesh->indices, sizeof(unsigned int), mesh->indices_count, fp) != mesh->indices_count) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to write mesh cache \"%s\"", path);
+		fclose(fp);
+		return 2;
+	}
+
+	for (unsigned long long int i = 0; i < mesh->lods_count; ++i) {
+		mesh_cache_lod_t lod = { mesh->lods[i].indices_count, mesh->lods[i].error };
+		if (fwrite(&lod, sizeof(lod), 1, fp) != 1 || fwrite(mesh->lods[i].indices, sizeof(unsigned int), lod.indices_count, fp) != lod.indices_count) {
+			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to write mesh cache \"%s\" lods", path);
+			fclose(fp);
+			return 3;
+		}
+	}
+
+	fclose(fp);
+	return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef KRISVERS_KGFW_MESH_H
+#define KRISVERS_KGFW_MESH_H
+
+#include "kgfw_defines.h"
+#include "kgfw_graphics.h"
+#include "kgfw_hash.h"
+
+/* post-transform cache size the optimizer targets */
+#define KGFW_MESH_CACHE_SIZE 16
+
+typedef struct kgfw_mesh_stats {
+	/* average cache miss ratio, transformed vertices per triangle */
+	float acmr;
+	/* average transform to vertex ratio, transformed vertices per unique vertex */
+	float atvr;
+} kgfw_mesh_stats_t;
+
+/* simulates a fifo post-transform cache of cache_size entries */
+KGFW_PUBLIC void kgfw_mesh_analyze(const unsigned int * indices, unsigned long long int indices_count, unsigned long long int vertices_count, unsigned int cache_size, kgfw_mesh_stats_t * out_stats);
+/* tipsify triangle reordering for vertex cache locality, fails when indices_count is not a multiple of 3 */
+KGFW_PUBLIC int kgfw_mesh_optimize_vertex_cache(unsigned int * indices, unsigned long long int indices_count, unsigned long long int vertices_count, unsigned int cache_size);
+/* orders cache friendly triangle clusters outside in, keeps the input order if acmr would grow past threshold times the input acmr */
+KGFW_PUBLIC int kgfw_mesh_optimize_overdraw(unsigned int * indices, unsigned long long int indices_count, const kgfw_graphics_vertex_t * vertices, unsigned long long int vertices_count, unsigned int cache_size, float threshold);
+/* reorders vertices by first use and remaps indices, unreferenced vertices are dropped */
+KGFW_PUBLIC int kgfw_mesh_optimize_vertex_fetch(kgfw_graphics_mesh_t * mesh);
+/* runs all passes in order, either stats pointer may be NULL */
+KGFW_PUBLIC int kgfw_mesh_optimize(kgfw_graphics_mesh_t * mesh, kgfw_mesh_stats_t * out_before, kgfw_mesh_stats_t * out_after);
+
+/* quadric error edge collapse, returns the simplified index count written to out_indices which must hold indices_count indices */
+KGFW_PUBLIC unsigned long long int kgfw_mesh_simplify(const kgfw_graphics_vertex_t * vertices, unsigned long long int vertices_count, const unsigned int * indices, unsigned long long int indices_count, unsigned long long int target_indices_count, float target_error, unsigned int * out_indices, float * out_error);
+/* builds up to lods_count lods halving the triangle count each level, lods stop early once simplification stalls */
+KGFW_PUBLIC int kgfw_mesh_lods_generate(kgfw_graphics_mesh_t * mesh, unsigned long long int lods_count);
+KGFW_PUBLIC void kgfw_mesh_lods_destroy(kgfw_graphics_mesh_t * mesh);
+
+/* 16 bit copy of the indices for meshes that can address every vertex with 16 bits, returns NULL otherwise, free with kgfw_memory_free */
+KGFW_PUBLIC unsigned short int * kgfw_mesh_indices_narrow(const kgfw_graphics_mesh_t * mesh);
+
+/* optimized meshes and their lods are cached keyed by the hash of their source file, vertices, indices and lods are allocated with kgfw_memory on load */
+KGFW_PUBLIC int kgfw_mesh_cache_load(const char * path, kgfw_hash_t source_hash, kgfw_graphics_mesh_t * out_mesh);
+KGFW_PUBLIC int kgfw_mesh_cache_save(const char * path, kgfw_hash_t source_hash, const kgfw_graphics_mesh_t * mesh);
+
+#endif
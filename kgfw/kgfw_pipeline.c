@@ -0,0 +1,136 @@
+#include "kgfw_pipeline.h"
+#include "kgfw_log.h"
+#include "kgfw_memory.h"
+#include <stdlib.h>
+
+static int pipeline_worker(void * data) {
+	kgfw_pipeline_t * pipeline = data;
+
+	kgfw_mutex_lock(&pipeline->mutex);
+	while (1) {
+		while (!pipeline->exit && !pipeline->busy) {
+			kgfw_cond_wait(&pipeline->kick, &pipeline->mutex);
+		}
+
+		if (pipeline->exit) {
+			break;
+		}
+
+		void * back = pipeline->snapshots[pipeline->front ^ 1];
+		kgfw_mutex_unlock(&pipeline->mutex);
+		pipeline->simulate(pipeline->data, back);
+		kgfw_mutex_lock(&pipeline->mutex);
+
+		pipeline->busy = 0;
+		kgfw_cond_signal(&pipeline->done);
+	}
+	kgfw_mutex_unlock(&pipeline->mutex);
+
+	return 0;
+}
+
+int kgfw_pipeline_init(kgfw_pipeline_t * pipeline, unsigned long long int snapshot_size, kgfw_pipeline_simulate_f simulate, void * data, unsigned char threaded) {
+	pipeline->simulate = simulate;
+	pipeline->data = data;
+	pipeline->snapshot_size = snapshot_size;
+	pipeline->front = 0;
+	pipeline->threaded = 0;
+	pipeline->running = 0;
+	pipeline->busy = 0;
+	pipeline->pending = 0;
+	pipeline->exit = 0;
+
+	pipeline->snapshots[0] = kgfw_memory_calloc(2, snapshot_size, KGFW_MEMORY_TAG_ECS);
+	if (pipeline->snapshots[0] == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
+		return 1;
+	}
+	pipeline->snapshots[1] = (unsigned char *) pipeline->snapshots[0] + snapshot_size;
+
+	if (kgfw_mutex_init(&pipeline->mutex) != 0) {
+		kgfw_memory_free(pipeline->snapshots[0]);
+		return 2;
+	}
+	if (kgfw_cond_init(&pipeline->kick) != 0) {
+		kgfw_mutex_deinit(&pipeline->mutex);
+		kgfw_memory_free(pipeline->snapshots[0]);
+		return 2;
+	}
+	if (kgfw_cond_init(&pipeline->done) != 0) {
+		kgfw_cond_deinit(&pipeline->kick);
+		kgfw_mutex_deinit(&pipeline->mutex);
+		kgfw_memory_free(pipeline->snapshots[0]);
+		return 2;
+	}
+
+	if (kgfw_thread_create(&pipeline->thread, pipeline_worker, pipeline) != 0) {
+		kgfw_logf(KGFW_LOG_SEVERITY_WARN, "Failed to create simulation thread, simulating on the calling thread");
+		return 0;
+	}
+	pipeline->running = 1;
+	pipeline->threaded = threaded;
+
+	return 0;
+}
+
+void kgfw_pipeline_deinit(kgfw_pipeline_t * pipeline) {
+	kgfw_pipeline_sync(pipeline);
+
+	if (pipeline->running) {
+		kgfw_mutex_lock(&pipeline->mutex);
+		pipeline->exit = 1;
+		kgfw_cond_signal(&pipeline->kick);
+		kgfw_mutex_unlock(&pipeline->mutex);
+		kgfw_thread_join(&pipeline->thread);
+		pipeline->running = 0;
+	}
+
+	kgfw_cond_deinit(&pipeline->done);
+	kgfw_cond_deinit(&pipeline->kick);
+	kgfw_mutex_deinit(&pipeline->mutex);
+
+	kgfw_memory_free(pipeline->snapshots[0]);
+	pipeline->snapshots[0] = NULL;
+	pipeline->snapshots[1] = NULL;
+}
+
+void kgfw_pipeline_kick(kgfw_pipeline_t * pipeline) {
+	if (!pipeline->threaded) {
+		/* nothing to overlap with, so publish right away instead of a frame late */
+		pipeline->simulate(pipeline->data, pipeline->snapshots[pipeline->front ^ 1]);
+		pipeline->front ^= 1;
+		return;
+	}
+
+	kgfw_mutex_lock(&pipeline->mutex);
+	pipeline->busy = 1;
+	pipeline->pending = 1;
+	kgfw_cond_signal(&pipeline->kick);
+	kgfw_mutex_unlock(&pipeline->mutex);
+}
+
+void kgfw_pipeline_sync(kgfw_pipeline_t * pipeline) {
+	if (!pipeline->running) {
+		return;
+	}
+
+	kgfw_mutex_lock(&pipeline->mutex);
+	while (pipeline->busy) {
+		kgfw_cond_wait(&pipeline->done, &pipeline->mutex);
+	}
+
+	if (pipeline->pending) {
+		pipeline->front ^= 1;
+		pipeline->pending = 0;
+	}
+	kgfw_mutex_unlock(&pipeline->mutex);
+}
+
+const void * kgfw_pipeline_snapshot(kgfw_pipeline_t * pipeline) {
+	return pipeline->snapshots[pipeline->front];
+}
+
+void kgfw_pipeline_threaded_set(kgfw_pipeline_t * pipeline, unsigned char threaded) {
+	kgfw_pipeline_sync(pipeline);
+	pipeline->threaded = threaded && pipeline->running;
+}
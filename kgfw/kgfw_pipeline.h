@@ -0,0 +1,47 @@
+#ifndef KRISVERS_KGFW_PIPELINE_H
+#define KRISVERS_KGFW_PIPELINE_H
+
+#include "kgfw_defines.h"
+#include "kgfw_thread.h"
+
+/* simulates one frame and fills snapshot with everything the renderer will read, must not touch graphics or window state */
+typedef void (*kgfw_pipeline_simulate_f)(void * data, void * snapshot);
+
+/*
+	simulation of frame N + 1 runs on a worker while the caller renders frame N from its snapshot.
+	the two snapshots are swapped at the sync point, so the renderer only ever reads a snapshot the simulation is done with.
+ */
+typedef struct kgfw_pipeline {
+	kgfw_thread_t thread;
+	kgfw_mutex_t mutex;
+	kgfw_cond_t kick;
+	kgfw_cond_t done;
+	kgfw_pipeline_simulate_f simulate;
+	void * data;
+	void * snapshots[2];
+	unsigned long long int snapshot_size;
+	/* index of the snapshot the renderer reads */
+	unsigned int front;
+	unsigned char threaded;
+	/* the worker thread exists */
+	unsigned char running;
+	/* the worker is simulating */
+	unsigned char busy;
+	/* a finished simulation waits to be published by kgfw_pipeline_sync */
+	unsigned char pending;
+	unsigned char exit;
+} kgfw_pipeline_t;
+
+/* snapshots start zeroed, threaded = 0 runs the simulation inline in kgfw_pipeline_kick */
+KGFW_PUBLIC int kgfw_pipeline_init(kgfw_pipeline_t * pipeline, unsigned long long int snapshot_size, kgfw_pipeline_simulate_f simulate, void * data, unsigned char threaded);
+KGFW_PUBLIC void kgfw_pipeline_deinit(kgfw_pipeline_t * pipeline);
+/* starts simulating the next frame, input, time and console state must not change until kgfw_pipeline_sync */
+KGFW_PUBLIC void kgfw_pipeline_kick(kgfw_pipeline_t * pipeline);
+/* waits for the simulation in flight and publishes its snapshot */
+KGFW_PUBLIC void kgfw_pipeline_sync(kgfw_pipeline_t * pipeline);
+/* the latest published snapshot, stays valid until the next kgfw_pipeline_sync */
+KGFW_PUBLIC const void * kgfw_pipeline_snapshot(kgfw_pipeline_t * pipeline);
+/* waits for the simulation in flight before switching */
+KGFW_PUBLIC void kgfw_pipeline_threaded_set(kgfw_pipeline_t * pipeline, unsigned char threaded);
+
+#endif
@@ -0,0 +1,281 @@
+#include "kgfw_thread.h"
+#include "kgfw_log.h"
+#include "kgfw_memory.h"
+#include <stdlib.h>
+
+#ifdef KGFW_WINDOWS
+#include <windows.h>
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+	kgfw_thread_t * thread = param;
+	thread->ret = thread->func(thread->data);
+	return 0;
+}
+
+int kgfw_thread_create(kgfw_thread_t * thread, kgfw_thread_func_t func, void * data) {
+	thread->func = func;
+	thread->data = data;
+	thread->ret = 0;
+	thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+	if (thread->handle == NULL) {
+		return 1;
+	}
+
+	return 0;
+}
+
+int kgfw_thread_join(kgfw_thread_t * thread) {
+	if (WaitForSingleObject(thread->handle, INFINITE) != WAIT_OBJECT_0) {
+		return 1;
+	}
+
+	CloseHandle(thread->handle);
+	thread->handle = NULL;
+	return 0;
+}
+
+unsigned int kgfw_thread_hardware_count(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors == 0) ? 1 : info.dwNumberOfProcessors;
+}
+
+int kgfw_mutex_init(kgfw_mutex_t * mutex) {
+	InitializeSRWLock((PSRWLOCK) &mutex->handle);
+	return 0;
+}
+
+void kgfw_mutex_deinit(kgfw_mutex_t * mutex) {
+	return;
+}
+
+void kgfw_mutex_lock(kgfw_mutex_t * mutex) {
+	AcquireSRWLockExclusive((PSRWLOCK) &mutex->handle);
+}
+
+void kgfw_mutex_unlock(kgfw_mutex_t * mutex) {
+	ReleaseSRWLockExclusive((PSRWLOCK) &mutex->handle);
+}
+
+int kgfw_cond_init(kgfw_cond_t * cond) {
+	InitializeConditionVariable((PCONDITION_VARIABLE) &cond->handle);
+	return 0;
+}
+
+void kgfw_cond_deinit(kgfw_cond_t * cond) {
+	return;
+}
+
+void kgfw_cond_wait(kgfw_cond_t * cond, kgfw_mutex_t * mutex) {
+	SleepConditionVariableSRW((PCONDITION_VARIABLE) &cond->handle, (PSRWLOCK) &mutex->handle, INFINITE, 0);
+}
+
+void kgfw_cond_signal(kgfw_cond_t * cond) {
+	WakeConditionVariable((PCONDITION_VARIABLE) &cond->handle);
+}
+
+void kgfw_cond_broadcast(kgfw_cond_t * cond) {
+	WakeAllConditionVariable((PCONDITION_VARIABLE) &cond->handle);
+}
+
+#else
+#include <unistd.h>
+
+static void * thread_entry(void * param) {
+	kgfw_thread_t * thread = param;
+	thread->ret = thread->func(thread->data);
+	return NULL;
+}
+
+int kgfw_thread_create(kgfw_thread_t * thread, kgfw_thread_func_t func, void * data) {
+	thread->func = func;
+	thread->data = data;
+	thread->ret = 0;
+	if (pthread_create(&thread->handle, NULL, thread_entry, thread) != 0) {
+		return 1;
+	}
+
+	return 0;
+}
+
+int kgfw_thread_join(kgfw_thread_t * thread) {
+	if (pthread_join(thread->handle, NULL) != 0) {
+		return 1;
+	}
+
+	return 0;
+}
+
+unsigned int kgfw_thread_hardware_count(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count < 1) ? 1 : (unsigned int) count;
+}
+
+int kgfw_mutex_init(kgfw_mutex_t * mutex) {
+	return (pthread_mutex_init(&mutex->handle, NULL) == 0) ? 0 : 1;
+}
+
+void kgfw_mutex_deinit(kgfw_mutex_t * mutex) {
+	pthread_mutex_destroy(&mutex->handle);
+}
+
+void kgfw_mutex_lock(kgfw_mutex_t * mutex) {
+	pthread_mutex_lock(&mutex->handle);
+}
+
+void kgfw_mutex_unlock(kgfw_mutex_t * mutex) {
+	pthread_mutex_unlock(&mutex->handle);
+}
+
+int kgfw_cond_init(kgfw_cond_t * cond) {
+	return (pthread_cond_init(&cond->handle, NULL) == 0) ? 0 : 1;
+}
+
+void kgfw_cond_deinit(kgfw_cond_t * cond) {
+	pthread_cond_destroy(&cond->handle);
+}
+
+void kgfw_cond_wait(kgfw_cond_t * cond, kgfw_mutex_t * mutex) {
+	pthread_cond_wait(&cond->handle, &mutex->handle);
+}
+
+void kgfw_cond_signal(kgfw_cond_t * cond) {
+	pthread_cond_signal(&cond->handle);
+}
+
+void kgfw_cond_broadcast(kgfw_cond_t * cond) {
+	pthread_cond_broadcast(&cond->handle);
+}
+
+#endif
+
+/* takes and runs jobs until none are left, expects the pool mutex to be held */
+static void pool_drain(kgfw_thread_pool_t * pool) {
+	while (pool->next < pool->jobs) {
+		unsigned int index = pool->next++;
+		kgfw_thread_job_t job = pool->job;
+		void * data = pool->data;
+
+		kgfw_mutex_unlock(&pool->mutex);
+		job(data, index);
+		kgfw_mutex_lock(&pool->mutex);
+
+		if (++pool->finished == pool->jobs) {
+			kgfw_cond_broadcast(&pool->done);
+		}
+	}
+}
+
+static int pool_worker(void * data) {
+	kgfw_thread_pool_t * pool = data;
+
+	kgfw_mutex_lock(&pool->mutex);
+	while (1) {
+		while (!pool->exit && pool->next >= pool->jobs) {
+			kgfw_cond_wait(&pool->work, &pool->mutex);
+		}
+
+		if (pool->exit) {
+			break;
+		}
+
+		pool_drain(pool);
+	}
+	kgfw_mutex_unlock(&pool->mutex);
+
+	return 0;
+}
+
+int kgfw_thread_pool_init(kgfw_thread_pool_t * pool, unsigned int threads_count) {
+	pool->threads = NULL;
+	pool->threads_count = 0;
+	pool->job = NULL;
+	pool->data = NULL;
+	pool->jobs = 0;
+	pool->next = 0;
+	pool->finished = 0;
+	pool->exit = 0;
+
+	if (kgfw_mutex_init(&pool->mutex) != 0) {
+		return 1;
+	}
+	if (kgfw_cond_init(&pool->work) != 0) {
+		kgfw_mutex_deinit(&pool->mutex);
+		return 1;
+	}
+	if (kgfw_cond_init(&pool->done) != 0) {
+		kgfw_cond_deinit(&pool->work);
+		kgfw_mutex_deinit(&pool->mutex);
+		return 1;
+	}
+
+	if (threads_count == 0) {
+		return 0;
+	}
+
+	pool->threads = kgfw_memory_alloc(sizeof(kgfw_thread_t) * threads_count, KGFW_MEMORY_TAG_GENERAL);
+	if (pool->threads == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "Allocation failure");
+		kgfw_thread_pool_deinit(pool);
+		return 2;
+	}
+
+	for (unsigned int i = 0; i < threads_count; ++i) {
+		if (kgfw_thread_create(&pool->threads[i], pool_worker, pool) != 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_WARN, "Failed to create worker thread %u, continuing with %u", i, i);
+			break;
+		}
+		++pool->threads_count;
+	}
+
+	return 0;
+}
+
+void kgfw_thread_pool_deinit(kgfw_thread_pool_t * pool) {
+	kgfw_mutex_lock(&pool->mutex);
+	pool->exit = 1;
+	kgfw_cond_broadcast(&pool->work);
+	kgfw_mutex_unlock(&pool->mutex);
+
+	for (unsigned int i = 0; i < pool->threads_count; ++i) {
+		kgfw_thread_join(&pool->threads[i]);
+	}
+
+	kgfw_memory_free(pool->threads);
+	pool->threads = NULL;
+	pool->threads_count = 0;
+
+	kgfw_cond_deinit(&pool->done);
+	kgfw_cond_deinit(&pool->work);
+	kgfw_mutex_deinit(&pool->mutex);
+}
+
+void kgfw_thread_pool_run(kgfw_thread_pool_t * pool, unsigned int jobs, kgfw_thread_job_t job, void * data) {
+	if (jobs == 0) {
+		return;
+	}
+
+	if (pool->threads_count == 0 || jobs == 1) {
+		for (unsigned int i = 0; i < jobs; ++i) {
+			job(data, i);
+		}
+		return;
+	}
+
+	kgfw_mutex_lock(&pool->mutex);
+	pool->job = job;
+	pool->data = data;
+	pool->jobs = jobs;
+	pool->next = 0;
+	pool->finished = 0;
+	kgfw_cond_broadcast(&pool->work);
+
+	pool_drain(pool);
+	while (pool->finished < pool->jobs) {
+		kgfw_cond_wait(&pool->done, &pool->mutex);
+	}
+
+	pool->jobs = 0;
+	pool->next = 0;
+	kgfw_mutex_unlock(&pool->mutex);
+}
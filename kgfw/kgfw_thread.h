@@ -0,0 +1,81 @@
+#ifndef KRISVERS_KGFW_THREAD_H
+#define KRISVERS_KGFW_THREAD_H
+
+#include "kgfw_defines.h"
+
+#ifdef KGFW_WINDOWS
+#define KGFW_THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#define KGFW_THREAD_LOCAL _Thread_local
+#endif
+
+typedef int (*kgfw_thread_func_t)(void * data);
+/* called once per job index by kgfw_thread_pool_run */
+typedef void (*kgfw_thread_job_t)(void * data, unsigned int index);
+
+typedef struct kgfw_thread {
+	#ifdef KGFW_WINDOWS
+	void * handle;
+	#else
+	pthread_t handle;
+	#endif
+	kgfw_thread_func_t func;
+	void * data;
+	int ret;
+} kgfw_thread_t;
+
+typedef struct kgfw_mutex {
+	#ifdef KGFW_WINDOWS
+	/* SRWLOCK */
+	void * handle;
+	#else
+	pthread_mutex_t handle;
+	#endif
+} kgfw_mutex_t;
+
+typedef struct kgfw_cond {
+	#ifdef KGFW_WINDOWS
+	/* CONDITION_VARIABLE */
+	void * handle;
+	#else
+	pthread_cond_t handle;
+	#endif
+} kgfw_cond_t;
+
+typedef struct kgfw_thread_pool {
+	kgfw_thread_t * threads;
+	unsigned int threads_count;
+	kgfw_mutex_t mutex;
+	kgfw_cond_t work;
+	kgfw_cond_t done;
+	kgfw_thread_job_t job;
+	void * data;
+	unsigned int jobs;
+	unsigned int next;
+	unsigned int finished;
+	unsigned char exit;
+} kgfw_thread_pool_t;
+
+KGFW_PUBLIC int kgfw_thread_create(kgfw_thread_t * thread, kgfw_thread_func_t func, void * data);
+KGFW_PUBLIC int kgfw_thread_join(kgfw_thread_t * thread);
+KGFW_PUBLIC unsigned int kgfw_thread_hardware_count(void);
+
+KGFW_PUBLIC int kgfw_mutex_init(kgfw_mutex_t * mutex);
+KGFW_PUBLIC void kgfw_mutex_deinit(kgfw_mutex_t * mutex);
+KGFW_PUBLIC void kgfw_mutex_lock(kgfw_mutex_t * mutex);
+KGFW_PUBLIC void kgfw_mutex_unlock(kgfw_mutex_t * mutex);
+
+KGFW_PUBLIC int kgfw_cond_init(kgfw_cond_t * cond);
+KGFW_PUBLIC void kgfw_cond_deinit(kgfw_cond_t * cond);
+KGFW_PUBLIC void kgfw_cond_wait(kgfw_cond_t * cond, kgfw_mutex_t * mutex);
+KGFW_PUBLIC void kgfw_cond_signal(kgfw_cond_t * cond);
+KGFW_PUBLIC void kgfw_cond_broadcast(kgfw_cond_t * cond);
+
+/* threads_count workers are spawned, the calling thread also takes jobs while it waits in kgfw_thread_pool_run */
+KGFW_PUBLIC int kgfw_thread_pool_init(kgfw_thread_pool_t * pool, unsigned int threads_count);
+KGFW_PUBLIC void kgfw_thread_pool_deinit(kgfw_thread_pool_t * pool);
+/* runs job(data, i) for every i in [0, jobs) and returns once all of them have finished */
+KGFW_PUBLIC void kgfw_thread_pool_run(kgfw_thread_pool_t * pool, unsigned int jobs, kgfw_thread_job_t job, void * data);
+
+#endif
@@ -1,34 +1,160 @@
-#include "kgfw_defines.h"
-
-#if (KGFW_OPENGL == 33 || defined(KGFW_VULKAN) || KGFW_DIRECTX == 11)
+/* clock_gettime and CLOCK_MONOTONIC are POSIX, not ISO C */
+#if !defined(_POSIX_C_SOURCE) || _POSIX_C_SOURCE < 199309L
+#undef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
 
 #include "kgfw_time.h"
-#include <GLFW/glfw3.h>
 
-static float start = 0;
-static float end = 0;
+#ifdef KGFW_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static struct {
+	long long int origin;
+	long long int start;
+	long long int end;
+
+	unsigned char updated;
+	long long int last;
+	long long int frame_delta;
+	double smooth[KGFW_TIME_SMOOTH_FRAMES];
+	unsigned int smooth_count;
+	unsigned int smooth_head;
+
+	/* kept in nanoseconds so long sessions accumulate no rounding */
+	long long int game;
+	long long int game_delta;
+	float scale;
+	unsigned char paused;
+} state = {
+	0, 0, 0,
+	0, 0, 0, { 0 }, 0, 0,
+	0, 0, 1, 0,
+};
+
+static long long int clock_raw(void) {
+	#ifdef KGFW_WINDOWS
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	/* whole seconds and the remainder are scaled separately so the multiplication can not overflow */
+	long long int seconds = counter.QuadPart / frequency.QuadPart;
+	long long int rest = counter.QuadPart % frequency.QuadPart;
+	return seconds * 1000000000LL + rest * 1000000000LL / frequency.QuadPart;
+	#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long int) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+	#endif
+}
+
+long long int kgfw_time_ns(void) {
+	if (state.origin == 0) {
+		state.origin = clock_raw();
+	}
+
+	return clock_raw() - state.origin;
+}
+
+double kgfw_time_seconds(void) {
+	return kgfw_time_ns() / 1000000000.0;
+}
 
 float kgfw_time_get(void) {
-	return (float) glfwGetTime();
+	return (float) kgfw_time_seconds();
+}
+
+void kgfw_time_update(void) {
+	long long int now = kgfw_time_ns();
+	state.frame_delta = (state.updated) ? now - state.last : 0;
+	state.last = now;
+	state.updated = 1;
+
+	double delta = state.frame_delta / 1000000000.0;
+	if (delta > KGFW_TIME_DELTA_MAX) {
+		delta = KGFW_TIME_DELTA_MAX;
+	}
+
+	state.smooth[state.smooth_head] = delta;
+	state.smooth_head = (state.smooth_head + 1) % KGFW_TIME_SMOOTH_FRAMES;
+	if (state.smooth_count < KGFW_TIME_SMOOTH_FRAMES) {
+		++state.smooth_count;
+	}
+
+	state.game_delta = (state.paused) ? 0 : (long long int) (delta * state.scale * 1000000000.0);
+	state.game += state.game_delta;
+}
+
+double kgfw_time_frame_delta(void) {
+	return state.frame_delta / 1000000000.0;
+}
+
+float kgfw_time_delta_smooth(void) {
+	if (state.smooth_count == 0) {
+		return 0;
+	}
+
+	double sum = 0;
+	for (unsigned int i = 0; i < state.smooth_count; ++i) {
+		sum += state.smooth[i];
+	}
+	return (float) (sum / state.smooth_count);
+}
+
+double kgfw_time_game(void) {
+	return state.game / 1000000000.0;
+}
+
+float kgfw_time_game_delta(void) {
+	return (float) (state.game_delta / 1000000000.0);
+}
+
+void kgfw_time_scale_set(float scale) {
+	state.scale = (scale < 0) ? 0 : scale;
+}
+
+float kgfw_time_scale_get(void) {
+	return state.scale;
+}
+
+void kgfw_time_pause(unsigned char paused) {
+	state.paused = paused;
+}
+
+unsigned char kgfw_time_paused(void) {
+	return state.paused;
 }
 
 float kgfw_time_delta(void) {
-	return end - start;
+	return (float) ((state.end - state.start) / 1000000000.0);
 }
 
-void kgfw_time_start(void) {
-	start = kgfw_time_get();
+long long int kgfw_time_delta_ns(void) {
+	return state.end - state.start;
 }
 
-void kgfw_time_end(void) {
-	end = kgfw_time_get();
+void kgfw_time_start(void) {
+	state.start = kgfw_time_ns();
 }
 
-void kgfw_time_update(void) {
-	return;
+void kgfw_time_end(void) {
+	state.end = kgfw_time_ns();
 }
 
 void kgfw_time_init(void) {
-	return;
+	state.origin = clock_raw();
+	state.start = 0;
+	state.end = 0;
+	state.updated = 0;
+	state.smooth_count = 0;
+	state.smooth_head = 0;
+	state.game = 0;
+	state.game_delta = 0;
 }
-#endif
\ No newline at end of file
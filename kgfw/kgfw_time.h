@@ -3,9 +3,34 @@
 
 #include "kgfw_defines.h"
 
+/* frames longer than this count as this long in the smoothed and game deltas, so hitches and breakpoints do not launch the simulation */
+#define KGFW_TIME_DELTA_MAX 0.25
+#define KGFW_TIME_SMOOTH_FRAMES 16
+
+/* seconds since kgfw_time_init, float precision degrades after hours so prefer kgfw_time_seconds or kgfw_time_ns */
 KGFW_PUBLIC float kgfw_time_get(void);
+/* monotonic nanoseconds since kgfw_time_init */
+KGFW_PUBLIC long long int kgfw_time_ns(void);
+KGFW_PUBLIC double kgfw_time_seconds(void);
+
+/* advances the frame and game clocks, call once per frame */
 KGFW_PUBLIC void kgfw_time_update(void);
+/* unclamped seconds between the last two kgfw_time_update calls */
+KGFW_PUBLIC double kgfw_time_frame_delta(void);
+/* mean of the last KGFW_TIME_SMOOTH_FRAMES frame deltas */
+KGFW_PUBLIC float kgfw_time_delta_smooth(void);
+
+/* game clock, advances by the clamped frame delta times the scale and stops while paused */
+KGFW_PUBLIC double kgfw_time_game(void);
+KGFW_PUBLIC float kgfw_time_game_delta(void);
+KGFW_PUBLIC void kgfw_time_scale_set(float scale);
+KGFW_PUBLIC float kgfw_time_scale_get(void);
+KGFW_PUBLIC void kgfw_time_pause(unsigned char paused);
+KGFW_PUBLIC unsigned char kgfw_time_paused(void);
+
+/* seconds between the last kgfw_time_start and kgfw_time_end */
 KGFW_PUBLIC float kgfw_time_delta(void);
+KGFW_PUBLIC long long int kgfw_time_delta_ns(void);
 KGFW_PUBLIC void kgfw_time_start(void);
 KGFW_PUBLIC void kgfw_time_end(void);
 KGFW_PUBLIC void kgfw_time_init(void);
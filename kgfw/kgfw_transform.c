@@ -7,3 +7,18 @@ void kgfw_transform_identity(kgfw_transform_t * transform) {
 	transform->scale[1] = 1.0f;
 	transform->scale[2] = 1.0f;
 }
+
+const kgfw_quat_t * kgfw_transform_rotation(kgfw_transform_t * transform) {
+	return kgfw_quat_cache_get(&transform->rotation, transform->rot);
+}
+
+void kgfw_transform_rotation_set(kgfw_transform_t * transform, const kgfw_quat_t * rotation) {
+	kgfw_quat_normalize(&transform->rotation.quat, rotation);
+	kgfw_quat_to_euler(transform->rot, &transform->rotation.quat);
+	memcpy(transform->rotation.euler, transform->rot, sizeof(transform->rot));
+	transform->rotation.valid = 1;
+}
+
+void kgfw_transform_matrix(kgfw_transform_t * transform, kgfw_mat4_t * out) {
+	kgfw_mat4_trs_quat(out, transform->pos, kgfw_transform_rotation(transform), transform->scale);
+}
@@ -2,13 +2,20 @@
 #define KRISVERS_KGFW_TRANSFORM_H
 
 #include "kgfw_defines.h"
+#include "kgfw_math.h"
 
 typedef struct kgfw_transform {
 	float pos[3];
+	/* euler angles in degrees, writing these sets the rotation */
 	float rot[3];
 	float scale[3];
+	kgfw_quat_cache_t rotation;
 } kgfw_transform_t;
 
 KGFW_PUBLIC void kgfw_transform_identity(kgfw_transform_t * transform);
+/* only recomputed when rot has changed since the last call */
+KGFW_PUBLIC const kgfw_quat_t * kgfw_transform_rotation(kgfw_transform_t * transform);
+KGFW_PUBLIC void kgfw_transform_rotation_set(kgfw_transform_t * transform, const kgfw_quat_t * rotation);
+KGFW_PUBLIC void kgfw_transform_matrix(kgfw_transform_t * transform, kgfw_mat4_t * out);
 
 #endif
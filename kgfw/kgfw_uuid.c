@@ -1,8 +1,110 @@
 #include "kgfw_uuid.h"
-#include <stdlib.h>
+#include "kgfw_thread.h"
+#include <time.h>
+
+#ifdef KGFW_WINDOWS
+#include <windows.h>
+
+typedef volatile LONG64 uuid_atomic_t;
+
+#define uuid_atomic_add(a, v) ((unsigned long long int) InterlockedExchangeAdd64((a), (LONG64) (v)))
+#define uuid_atomic_load(a) ((unsigned long long int) InterlockedCompareExchange64((a), 0, 0))
+#define uuid_atomic_store(a, v) InterlockedExchange64((a), (LONG64) (v))
+#else
+#include <stdatomic.h>
+
+typedef atomic_ullong uuid_atomic_t;
+
+#define uuid_atomic_add(a, v) atomic_fetch_add_explicit((a), (v), memory_order_relaxed)
+#define uuid_atomic_load(a) atomic_load_explicit((a), memory_order_relaxed)
+#define uuid_atomic_store(a, v) atomic_store_explicit((a), (v), memory_order_relaxed)
+#endif
+
+static struct {
+	uuid_atomic_t counter;
+	/* handed out once per stream so threads seeded from the same value still differ */
+	uuid_atomic_t streams;
+	uuid_atomic_t seed;
+	/* bumped by kgfw_uuid_seed, streams from an older generation reseed */
+	uuid_atomic_t generation;
+	uuid_atomic_t mode;
+} state = {
+	0, 0, 0, 1, KGFW_UUID_MODE_RANDOM,
+};
+
+static KGFW_THREAD_LOCAL struct {
+	unsigned long long int s[4];
+	unsigned long long int generation;
+} stream;
+
+static unsigned long long int splitmix64(unsigned long long int * x) {
+	unsigned long long int z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static unsigned long long int rotl(unsigned long long int x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+static void stream_seed(unsigned long long int generation) {
+	unsigned long long int seed = uuid_atomic_load(&state.seed);
+	if (seed == 0) {
+		/* the address differs per thread and per run under ASLR */
+		seed = ((unsigned long long int) time(NULL) << 20) ^ (unsigned long long int) (size_t) &stream;
+	}
+
+	unsigned long long int x = seed ^ (uuid_atomic_add(&state.streams, 1) * 0xD1B54A32D192ED03ULL);
+	for (unsigned int i = 0; i < 4; ++i) {
+		stream.s[i] = splitmix64(&x);
+	}
+	stream.generation = generation;
+}
+
+static unsigned long long int stream_next(void) {
+	unsigned long long int * s = stream.s;
+	unsigned long long int result = rotl(s[1] * 5, 7) * 9;
+	unsigned long long int t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
 
 kgfw_uuid_t kgfw_uuid_gen(void) {
-	kgfw_uuid_t uuid = rand() | (((kgfw_uuid_t) rand()) << 32);
+	if (uuid_atomic_load(&state.mode) == KGFW_UUID_MODE_SEQUENTIAL) {
+		return uuid_atomic_add(&state.counter, 1) + 1;
+	}
+
+	unsigned long long int generation = uuid_atomic_load(&state.generation);
+	if (stream.generation != generation) {
+		stream_seed(generation);
+	}
+
+	kgfw_uuid_t uuid = 0;
+	while (uuid == 0) {
+		uuid = stream_next();
+	}
 
 	return uuid;
-}
\ No newline at end of file
+}
+
+void kgfw_uuid_mode_set(kgfw_uuid_mode_enum mode) {
+	uuid_atomic_store(&state.mode, mode);
+}
+
+kgfw_uuid_mode_enum kgfw_uuid_mode_get(void) {
+	return (kgfw_uuid_mode_enum) uuid_atomic_load(&state.mode);
+}
+
+void kgfw_uuid_seed(unsigned long long int seed) {
+	uuid_atomic_store(&state.seed, seed);
+	uuid_atomic_store(&state.streams, 0);
+	uuid_atomic_add(&state.generation, 1);
+}
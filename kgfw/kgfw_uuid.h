@@ -5,6 +5,18 @@
 
 typedef unsigned long long int kgfw_uuid_t;
 
+typedef enum kgfw_uuid_mode {
+	/* per thread xoshiro256** streams, no shared state touched per id */
+	KGFW_UUID_MODE_RANDOM = 0,
+	/* one atomic counter shared by all threads, ids never repeat */
+	KGFW_UUID_MODE_SEQUENTIAL,
+} kgfw_uuid_mode_enum;
+
+/* never returns 0, safe to call from any thread */
 KGFW_PUBLIC kgfw_uuid_t kgfw_uuid_gen(void);
+KGFW_PUBLIC void kgfw_uuid_mode_set(kgfw_uuid_mode_enum mode);
+KGFW_PUBLIC kgfw_uuid_mode_enum kgfw_uuid_mode_get(void);
+/* every thread reseeds its random stream from seed on its next id, 0 seeds from the clock */
+KGFW_PUBLIC void kgfw_uuid_seed(unsigned long long int seed);
 
-#endif
\ No newline at end of file
+#endif
@@ -18,6 +18,7 @@ int kgfw_window_create(kgfw_window_t * out_window, unsigned int width, unsigned
 	out_window->focused = 1;
 	out_window->disable_gamepad_on_unfocus = 1;
 	out_window->internal = NULL;
+	out_window->headless = 0;
 
 	#if (KGFW_OPENGL == 33)
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -51,13 +52,62 @@ int kgfw_window_create(kgfw_window_t * out_window, unsigned int width, unsigned
 	return 0;
 }
 
+int kgfw_window_create_headless(kgfw_window_t * out_window, unsigned int width, unsigned int height) {
+	out_window->width = width;
+	out_window->height = height;
+	out_window->closed = 0;
+	out_window->focused = 1;
+	out_window->disable_gamepad_on_unfocus = 0;
+	out_window->internal = NULL;
+	out_window->content_scale_x = 1;
+	out_window->content_scale_y = 1;
+	out_window->headless = 1;
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	#if (KGFW_OPENGL == 33)
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	#ifdef KGFW_APPLE_MACOS
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+	#endif
+
+	#elif (defined(KGFW_VULKAN))
+
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+	#endif
+
+	/* the window is only there to own a context, its framebuffer is never presented */
+	out_window->internal = glfwCreateWindow(width, height, "kgfw headless", NULL, NULL);
+	#if (KGFW_OPENGL == 33)
+	if (out_window->internal == NULL) {
+		kgfw_log(KGFW_LOG_SEVERITY_WARN, "GLFW headless window creation failed, retrying with an OSMesa context");
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+		out_window->internal = glfwCreateWindow(width, height, "kgfw headless", NULL, NULL);
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API);
+	}
+	#endif
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+	if (out_window->internal == NULL) {
+		kgfw_log(KGFW_LOG_SEVERITY_ERROR, "GLFW headless window creation failed");
+		return 1;
+	}
+	glfwSetWindowUserPointer(out_window->internal, (void *) out_window);
+
+	return 0;
+}
+
 void kgfw_window_destroy(kgfw_window_t * window) {
 	glfwDestroyWindow(window->internal);
 }
 
 int kgfw_window_update(kgfw_window_t * window) {
 	#if (KGFW_OPENGL == 33)
-	glfwSwapBuffers(window->internal);
+	if (!window->headless) {
+		glfwSwapBuffers(window->internal);
+	}
 	#endif
 
 	return 0;
@@ -71,6 +121,7 @@ static void kgfw_glfw_window_close(GLFWwindow * glfw_window) {
 	}
 
 	window->closed = 1;
+	kgfw_frame_request_redraw();
 }
 
 static void kgfw_glfw_window_resize(GLFWwindow * glfw_window, int width, int height) {
@@ -82,6 +133,7 @@ static void kgfw_glfw_window_resize(GLFWwindow * glfw_window, int width, int hei
 
 	window->width = (unsigned int) width;
 	window->height = (unsigned int) height;
+	kgfw_frame_request_redraw();
 }
 
 static void kgfw_glfw_window_focus(GLFWwindow * glfw_window, int focused) {
@@ -91,6 +143,7 @@ static void kgfw_glfw_window_focus(GLFWwindow * glfw_window, int focused) {
 	}
 
 	window->focused = focused;
+	kgfw_frame_request_redraw();
 	if (window->disable_gamepad_on_unfocus) {
 		if (focused) {
 			kgfw_input_gamepad_enable();
@@ -116,6 +169,7 @@ int kgfw_window_create(kgfw_window_t * out_window, unsigned int width, unsigned
 	out_window->focused = 1;
 	out_window->disable_gamepad_on_unfocus = 1;
 	out_window->internal = NULL;
+	out_window->headless = 0;
 	
 	const char * class_name = "krisvers' window class";
 	WNDCLASSA cls;
@@ -149,6 +203,35 @@ int kgfw_window_create(kgfw_window_t * out_window, unsigned int width, unsigned
 	return 0;
 }
 
+int kgfw_window_create_headless(kgfw_window_t * out_window, unsigned int width, unsigned int height) {
+	out_window->width = width;
+	out_window->height = height;
+	out_window->closed = 0;
+	out_window->focused = 1;
+	out_window->disable_gamepad_on_unfocus = 0;
+	out_window->internal = NULL;
+	out_window->content_scale_x = 1;
+	out_window->content_scale_y = 1;
+	out_window->headless = 1;
+
+	const char * class_name = "krisvers' window class";
+	WNDCLASSA cls;
+	ZeroMemory(&cls, sizeof(cls));
+	cls.lpfnWndProc = window_proc;
+	cls.hInstance = GetModuleHandle(NULL);
+	cls.lpszClassName = class_name;
+	RegisterClassA(&cls);
+
+	/* never shown, the swapchain still needs a window to belong to */
+	out_window->internal = CreateWindowExA(0, class_name, "kgfw headless", WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, width, height, NULL, NULL, NULL, NULL);
+	if (out_window->internal == NULL) {
+		kgfw_log(KGFW_LOG_SEVERITY_ERROR, "headless window creation failed");
+		return 1;
+	}
+
+	return 0;
+}
+
 void kgfw_window_destroy(kgfw_window_t * window) {
 	DestroyWindow(window->internal);
 	UnregisterClassA("krisvers' window class", GetModuleHandle(NULL));
@@ -234,9 +317,11 @@ static LRESULT CALLBACK window_proc(HWND hwnd, UINT msg, WPARAM w, LPARAM l) {
 			return 0;
 		case WM_KILLFOCUS:
 			kgfw_input_gamepad_disable();
+			kgfw_frame_request_redraw();
 			break;
 		case WM_SETFOCUS:
 			kgfw_input_gamepad_enable();
+			kgfw_frame_request_redraw();
 			break;
 	}
 
@@ -12,9 +12,12 @@ typedef struct kgfw_window {
 	unsigned int height;
     float content_scale_x;
     float content_scale_y;
+	/* hidden and without input, graphics render offscreen at width by height */
+	unsigned char headless;
 } kgfw_window_t;
 
 KGFW_PUBLIC int kgfw_window_create(kgfw_window_t * out_window, unsigned int width, unsigned int height, char * title);
+KGFW_PUBLIC int kgfw_window_create_headless(kgfw_window_t * out_window, unsigned int width, unsigned int height);
 KGFW_PUBLIC void kgfw_window_destroy(kgfw_window_t * window);
 KGFW_PUBLIC int kgfw_window_update(kgfw_window_t * window);
 
@@ -4,22 +4,59 @@
 #include <string.h>
 #include <ctype.h>
 
+static struct {
+	koml_alloc_f alloc;
+	koml_realloc_f resize;
+	koml_free_f release;
+} koml_allocator = {
+	malloc,
+	realloc,
+	free,
+};
+
+void koml_allocator_set(koml_alloc_f alloc, koml_realloc_f resize, koml_free_f release) {
+	koml_allocator.alloc = (alloc == NULL) ? malloc : alloc;
+	koml_allocator.resize = (resize == NULL) ? realloc : resize;
+	koml_allocator.release = (release == NULL) ? free : release;
+}
+
+static unsigned long long int koml_internal_hash_word(unsigned long long int w, unsigned long long int multiplier) {
+	w ^= w >> 32;
+	w *= multiplier;
+	return w ^ (w >> 29);
+}
+
+/* same hash as kgfw_hash_length, 8 byte words mixed independently and summed */
 static unsigned long long int koml_internal_hash(char * start, unsigned long long int length) {
-	unsigned long long int hash = 5381;
+	unsigned long long int sum = 0;
+	unsigned long long int multiplier = 0xD6E8FEB86659FD93ULL;
+	unsigned long long int i = 0;
+
+	for (; i + 8 <= length; i += 8) {
+		unsigned long long int w;
+		memcpy(&w, start + i, 8);
+		sum += koml_internal_hash_word(w, multiplier);
+		multiplier += 0xA0761D6478BD642EULL;
+	}
 
-	for (unsigned long long int i = 0; i < length; ++i) {
-		hash = (hash << 5) + hash + start[i];
+	if (i < length) {
+		unsigned long long int w = 0;
+		for (unsigned long long int k = 0; i + k < length; ++k) {
+			w |= (unsigned long long int) (unsigned char) start[i + k] << (k * 8);
+		}
+		sum += koml_internal_hash_word(w, multiplier);
 	}
 
-	return hash;
+	sum = (sum + (length + 1) * 0x9E3779B97F4A7C15ULL) * 0xD6E8FEB86659FD93ULL;
+	return sum ^ (sum >> 32);
 }
 
 static int koml_table_alloc_new(koml_table_t * table) {
 	++table->length;
 	if (table->hashes == NULL) {
-		table->hashes = malloc(table->length * sizeof(unsigned long long int));
+		table->hashes = koml_allocator.alloc(table->length * sizeof(unsigned long long int));
 	} else {
-		table->hashes = realloc(table->hashes, table->length * sizeof(unsigned long long int));
+		table->hashes = koml_allocator.resize(table->hashes, table->length * sizeof(unsigned long long int));
 	}
 
 	if (table->hashes == NULL) {
@@ -27,9 +64,9 @@ static int koml_table_alloc_new(koml_table_t * table) {
 	}
 
 	if (table->symbols == NULL) {
-		table->symbols = malloc(table->length * sizeof(koml_symbol_t));
+		table->symbols = koml_allocator.alloc(table->length * sizeof(koml_symbol_t));
 	} else {
-		table->symbols = realloc(table->symbols, table->length * sizeof(koml_symbol_t));
+		table->symbols = koml_allocator.resize(table->symbols, table->length * sizeof(koml_symbol_t));
 	}
 
 	if (table->symbols == NULL) {
@@ -44,9 +81,9 @@ static int koml_table_alloc_new(koml_table_t * table) {
 static int koml_array_alloc_new(koml_array_t * array) {
 	++array->length;
 	if (array->strides == NULL) {
-		array->strides = malloc(array->length * sizeof(unsigned long long int));
+		array->strides = koml_allocator.alloc(array->length * sizeof(unsigned long long int));
 	} else {
-		array->strides = realloc(array->strides, array->length * sizeof(unsigned long long int));
+		array->strides = koml_allocator.resize(array->strides, array->length * sizeof(unsigned long long int));
 	}
 
 	if (array->strides == NULL) {
@@ -70,9 +107,9 @@ static int koml_array_alloc_new(koml_array_t * array) {
 	}
 
 	if (array->elements.voidptr == NULL) {
-		array->elements.voidptr = malloc(array->length * stride);
+		array->elements.voidptr = koml_allocator.alloc(array->length * stride);
 	} else {
-		array->elements.voidptr = realloc(array->elements.voidptr, array->length * stride);
+		array->elements.voidptr = koml_allocator.resize(array->elements.voidptr, array->length * stride);
 	}
 
 	if (array->elements.voidptr == NULL) {
@@ -85,9 +122,9 @@ static int koml_array_alloc_new(koml_array_t * array) {
 static int koml_array_alloc_new_amount(koml_array_t * array, unsigned long long int amount) {
 	array->length = amount;
 	if (array->strides == NULL) {
-		array->strides = malloc(array->length * sizeof(unsigned long long int));
+		array->strides = koml_allocator.alloc(array->length * sizeof(unsigned long long int));
 	} else {
-		array->strides = realloc(array->strides, array->length * sizeof(unsigned long long int));
+		array->strides = koml_allocator.resize(array->strides, array->length * sizeof(unsigned long long int));
 	}
 
 	if (array->strides == NULL) {
@@ -111,9 +148,9 @@ static int koml_array_alloc_new_amount(koml_array_t * array, unsigned long long
 	}
 
 	if (array->elements.voidptr == NULL) {
-		array->elements.voidptr = malloc(array->length * stride);
+		array->elements.voidptr = koml_allocator.alloc(array->length * stride);
 	} else {
-		array->elements.voidptr = realloc(array->elements.voidptr, array->length * stride);
+		array->elements.voidptr = koml_allocator.resize(array->elements.voidptr, array->length * stride);
 	}
 
 	if (array->elements.voidptr == NULL) {
@@ -420,7 +457,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 					unsigned long long int tmp_length = 0;
 					if (section.start != NULL) {
 						tmp_length = word.length + section.length + 1;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL || section.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -437,7 +474,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 						memcpy(&out_table->symbols[out_table->length - 1].name[section.length + 1], word.start, word.length);
 					} else {
 						tmp_length = word.length;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -584,7 +621,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 					unsigned long long int tmp_length = 0;
 					if (section.start != NULL) {
 						tmp_length = word.length + section.length + 1;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL || section.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -601,7 +638,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 						memcpy(&out_table->symbols[out_table->length - 1].name[section.length + 1], word.start, word.length);
 					} else {
 						tmp_length = word.length;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -749,7 +786,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 					unsigned long long int tmp_length = 0;
 					if (section.start != NULL) {
 						tmp_length = word.length + section.length + 1;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL || section.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -766,7 +803,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 						memcpy(&out_table->symbols[out_table->length - 1].name[section.length + 1], word.start, word.length);
 					} else {
 						tmp_length = word.length;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -828,7 +865,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 					}
 
 					out_table->symbols[out_table->length - 1].stride = word.length;
-					out_table->symbols[out_table->length - 1].data.string = malloc(word.length + 1);
+					out_table->symbols[out_table->length - 1].data.string = koml_allocator.alloc(word.length + 1);
 					if (out_table->symbols[out_table->length - 1].data.string == NULL) {
 						printf("Failed to allocate string buffer (line %llu: column %llu)\n  | ", line + 1, column + 1);
 						koml_printline(buffer, line, column);
@@ -884,7 +921,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 						return 18;
 					}
 
-					out_table->symbols[out_table->length - 1].data.string = malloc(ptr->stride + 1);
+					out_table->symbols[out_table->length - 1].data.string = koml_allocator.alloc(ptr->stride + 1);
 					if (out_table->symbols[out_table->length - 1].data.string == NULL) {
 						printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 						koml_printline(buffer, line, column);
@@ -935,7 +972,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 					unsigned long long int tmp_length = 0;
 					if (section.start != NULL) {
 						tmp_length = word.length + section.length + 1;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL || section.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -952,7 +989,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 						memcpy(&out_table->symbols[out_table->length - 1].name[section.length + 1], word.start, word.length);
 					} else {
 						tmp_length = word.length;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -1120,7 +1157,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 					unsigned long long int tmp_length = 0;
 					if (section.start != NULL) {
 						tmp_length = word.length + section.length + 1;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL || section.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -1137,7 +1174,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 						memcpy(&out_table->symbols[out_table->length - 1].name[section.length + 1], word.start, word.length);
 					} else {
 						tmp_length = word.length;
-						out_table->symbols[out_table->length - 1].name = malloc(tmp_length + 1);
+						out_table->symbols[out_table->length - 1].name = koml_allocator.alloc(tmp_length + 1);
 						if (out_table->symbols[out_table->length - 1].name == NULL || word.start == NULL) {
 							printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 							koml_printline(buffer, line, column);
@@ -1273,7 +1310,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 							koml_array_alloc_new_amount(&out_table->symbols[out_table->length - 1].data.array, ptr->data.array.length);
 							memcpy(out_table->symbols[out_table->length - 1].data.array.strides, ptr->data.array.strides, ptr->data.array.length * 4);
 							for (unsigned long long int i = 0; i < ptr->data.array.length; ++i) {
-								out_table->symbols[out_table->length - 1].data.array.elements.string[i] = malloc(ptr->data.array.strides[i] + 1);
+								out_table->symbols[out_table->length - 1].data.array.elements.string[i] = koml_allocator.alloc(ptr->data.array.strides[i] + 1);
 								if (out_table->symbols[out_table->length - 1].data.array.elements.string[i] == NULL) {
 									printf("Internal error (line %llu: column %llu)\n  | ", line + 1, column + 1);
 									koml_printline(buffer, line, column);
@@ -1418,7 +1455,7 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 							}
 
 							out_table->symbols[out_table->length - 1].data.array.strides[out_table->symbols[out_table->length - 1].data.array.length - 1] = word.length;
-							out_table->symbols[out_table->length - 1].data.array.elements.string[out_table->symbols[out_table->length - 1].data.array.length - 1] = malloc(word.length + 1);
+							out_table->symbols[out_table->length - 1].data.array.elements.string[out_table->symbols[out_table->length - 1].data.array.length - 1] = koml_allocator.alloc(word.length + 1);
 							if (out_table->symbols[out_table->length - 1].data.array.elements.string[out_table->symbols[out_table->length - 1].data.array.length - 1] == NULL) {
 								printf("Failed to allocate string buffer (line %llu: column %llu)\n  | ", line + 1, column + 1);
 								koml_printline(buffer, line, column);
@@ -1562,22 +1599,15 @@ int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long
 }
 
 koml_symbol_t * koml_table_symbol(koml_table_t * table, char * name) {
-	unsigned long long int hash = koml_internal_hash(name, strlen(name));
-
-	for (unsigned long long int i = 0; i < table->length; ++i) {
-		if (table->hashes[i] == hash) {
-			return &table->symbols[i];
-		}
-	}
-
-	return NULL;
+	return koml_table_symbol_word(table, name, strlen(name));
 }
 
 koml_symbol_t * koml_table_symbol_word(koml_table_t * table, char * name, unsigned long long int name_length) {
 	unsigned long long int hash = koml_internal_hash(name, name_length);
 
 	for (unsigned long long int i = 0; i < table->length; ++i) {
-		if (table->hashes[i] == hash) {
+		/* a matching hash alone could be a collision */
+		if (table->hashes[i] == hash && strncmp(table->symbols[i].name, name, name_length) == 0 && table->symbols[i].name[name_length] == '\0') {
 			return &table->symbols[i];
 		}
 	}
@@ -1585,14 +1615,35 @@ koml_symbol_t * koml_table_symbol_word(koml_table_t * table, char * name, unsign
 	return NULL;
 }
 
+static void koml_symbol_destroy(koml_symbol_t * symbol) {
+	koml_allocator.release(symbol->name);
+	if (symbol->type == KOML_TYPE_STRING) {
+		koml_allocator.release(symbol->data.string);
+	} else if (symbol->type == KOML_TYPE_ARRAY) {
+		if (symbol->data.array.type == KOML_TYPE_STRING && symbol->data.array.elements.string != NULL) {
+			for (unsigned long long int i = 0; i < symbol->data.array.length; ++i) {
+				koml_allocator.release(symbol->data.array.elements.string[i]);
+			}
+		}
+		koml_allocator.release(symbol->data.array.strides);
+		koml_allocator.release(symbol->data.array.elements.voidptr);
+	}
+}
+
 int koml_table_destroy(koml_table_t * table) {
 	if (table->hashes != NULL) {
-		free(table->hashes);
+		koml_allocator.release(table->hashes);
+		table->hashes = NULL;
 	}
 
 	if (table->symbols != NULL) {
-		free(table->symbols);
+		for (unsigned long long int i = 0; i < table->length; ++i) {
+			koml_symbol_destroy(&table->symbols[i]);
+		}
+		koml_allocator.release(table->symbols);
+		table->symbols = NULL;
 	}
+	table->length = 0;
 
 	return 0;
 }
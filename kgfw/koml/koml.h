@@ -1,6 +1,8 @@
 #ifndef KRISVERS_KOML_H
 #define KRISVERS_KOML_H
 
+#include <stddef.h>
+
 typedef enum koml_type {
 	KOML_TYPE_UNKNOWN = 0,
 	KOML_TYPE_INT = 1,
@@ -42,6 +44,12 @@ typedef struct koml_table {
 	unsigned long long int length;
 } koml_table_t;
 
+typedef void * (*koml_alloc_f)(size_t size);
+typedef void * (*koml_realloc_f)(void * p, size_t size);
+typedef void (*koml_free_f)(void * p);
+
+/* NULL restores the libc function, set before any table is loaded since tables must be destroyed with the allocator that loaded them */
+void koml_allocator_set(koml_alloc_f alloc, koml_realloc_f resize, koml_free_f release);
 void koml_symbol_print(koml_symbol_t * symbol);
 void koml_table_print(koml_table_t * table);
 int koml_table_load(koml_table_t * out_table, char * buffer, unsigned long long int buffer_length);
@@ -37,6 +37,8 @@ struct {
 	} settings;
 
 	kgfw_gamepad_t * gamepad;
+	kgfw_pipeline_t pipeline;
+	unsigned char pipelined;
 } static state = {
 	{ 0 },
 	{
@@ -58,6 +60,7 @@ struct {
 	},
 
 	.gamepad = NULL,
+	.pipelined = 0,
 };
 
 struct {
@@ -73,21 +76,45 @@ struct {
 #define STORAGE_MAX_TEXTURES 64
 #define STORAGE_MAX_MESHES 64
 #define EVALUATION_MAX_CYCLES 100
+/* player velocity is distance per step at this rate, the handling was tuned with one step per 60 Hz tick */
+#define PLAYER_STEP_RATE 60.0f
+#define MESH_CACHE_FMT "assets/meshes/cache_%016llx.bin"
+#define BENCHMARK_WIDTH 1280
+#define BENCHMARK_HEIGHT 720
+#define BENCHMARK_FRAMES 1000
+#define BENCHMARK_WARMUP 30
+#define BENCHMARK_GRID 8
+/* small colored lights scattered over the grid, enough that most clusters are touched by several */
+#define BENCHMARK_LIGHTS 256
+/* matrices and vertices per math benchmark pass, small enough to stay in cache */
+#define BENCHMARK_MATH_COUNT 1024
+#define BENCHMARK_MATH_PASSES 2000
+
+/* asset names looked up by the game itself, hashed at compile time */
+#define HASH_FORKLIFT KGFW_HASH_CHARS('f', 'o', 'r', 'k', 'l', 'i', 'f', 't')
+#define HASH_RACETRACK KGFW_HASH_CHARS('r', 'a', 'c', 'e', 't', 'r', 'a', 'c', 'k')
+
+/* lights the whole track from above */
+static const kgfw_graphics_light_t overhead_light = { { 0, 100, 0 }, { 1, 1, 1 }, 2000, 1000 };
 
 struct {
 	ktga_t textures[STORAGE_MAX_TEXTURES];
 	unsigned long long int textures_count;
 	kgfw_hash_t texture_hashes[STORAGE_MAX_TEXTURES];
+	char * texture_names[STORAGE_MAX_TEXTURES];
 	kgfw_graphics_mesh_t meshes[STORAGE_MAX_MESHES];
 	unsigned long long int meshes_count;
 	kgfw_hash_t mesh_hashes[STORAGE_MAX_MESHES];
+	char * mesh_names[STORAGE_MAX_MESHES];
 } static storage = {
 	{ 0 },
 	0,
 	{ 0 },
 	{ 0 },
+	{ 0 },
 	0,
 	{ 0 },
+	{ 0 },
 };
 
 static int kgfw_log_handler(kgfw_log_severity_enum severity, char * string);
@@ -96,15 +123,21 @@ static void kgfw_key_handler(kgfw_input_key_enum key, unsigned char action);
 static void kgfw_mouse_button_handle(kgfw_input_mouse_button_enum button, unsigned char action);
 static void kgfw_gamepad_handle(kgfw_gamepad_t * gamepad);
 static ktga_t * texture_get(char * name);
+static ktga_t * texture_find(kgfw_hash_t hash, const char * name);
 static int textures_load(void);
 static void textures_cleanup(void);
 static kgfw_graphics_mesh_t * mesh_get(char * name);
+static kgfw_graphics_mesh_t * mesh_find(kgfw_hash_t hash, const char * name);
+static char * name_copy(const char * name);
 static int meshes_load(void);
 static void meshes_cleanup(void);
 
 static int exit_command(int argc, char ** argv);
 static int game_command(int argc, char ** argv);
 
+static int benchmark_main(unsigned int frames, unsigned int settings);
+static int benchmark_math(unsigned int passes);
+
 /* components */
 static void test_start(kgfw_component_t * self);
 static void test_update(kgfw_component_t * self);
@@ -123,10 +156,28 @@ typedef struct player {
 	kgfw_camera_t * camera;
 	kgfw_graphics_mesh_node_t * car;
 	vec3 velocity;
+	/* state at the start of the last tick, blended with the current state for rendering */
+	vec3 prev_pos;
+	vec3 prev_rot;
+	vec3 prev_velocity;
 } player_t;
 
+/* everything the renderer reads from the simulation, written on the simulation thread when pipelined */
+typedef struct render_snapshot {
+	unsigned char valid;
+	vec3 camera_pos;
+	vec3 camera_rot;
+	vec3 camera_focus;
+	float camera_fov;
+	vec3 car_pos;
+	vec3 car_rot;
+} render_snapshot_t;
+
 static void player_start(player_t * self);
 static void player_update(player_t * self);
+static void player_interpolate(player_t * self, float alpha, render_snapshot_t * snapshot);
+static void simulate(void * data, void * snapshot);
+static void snapshot_apply(player_t * player, const render_snapshot_t * snapshot);
 static void player_destroy(player_t * self);
 
 int main(int argc, char ** argv) {
@@ -138,19 +189,58 @@ int main(int argc, char ** argv) {
 
 	kgfw_time_init();
 
+	unsigned int benchmark_frames = 0;
+	unsigned int benchmark_math_passes = 0;
+	unsigned int benchmark_settings = KGFW_GRAPHICS_SETTINGS_DEFAULT;
+	char * directory = NULL;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--benchmark") == 0) {
+			benchmark_frames = BENCHMARK_FRAMES;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+				benchmark_frames = atoi(argv[++i]);
+			}
+		} else if (strcmp(argv[i], "--math-benchmark") == 0) {
+			benchmark_math_passes = BENCHMARK_MATH_PASSES;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+				benchmark_math_passes = atoi(argv[++i]);
+			}
+		} else if (strcmp(argv[i], "--prepass") == 0) {
+			benchmark_settings |= KGFW_GRAPHICS_SETTINGS_DEPTH_PREPASS;
+		} else if (strcmp(argv[i], "--unsorted") == 0) {
+			benchmark_settings &= ~KGFW_GRAPHICS_SETTINGS_SORT;
+		} else if (strcmp(argv[i], "--no-occlusion") == 0) {
+			benchmark_settings &= ~KGFW_GRAPHICS_SETTINGS_OCCLUSION;
+		} else if (strcmp(argv[i], "--pipelined") == 0) {
+			state.pipelined = 1;
+		} else if (directory == NULL) {
+			directory = argv[i];
+		}
+	}
+
 	/* work-around for pylauncher bug */
 	#ifndef KGFW_WINDOWS
-	if (argc > 1) {
-		if (chdir(argv[1]) != 0) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to chdir to %s", argv[1]);
+	if (directory != NULL) {
+		if (chdir(directory) != 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to chdir to %s", directory);
 		}
 	}
 	#endif
 
+	if (benchmark_math_passes > 0) {
+		int result = benchmark_math(benchmark_math_passes);
+		kgfw_deinit();
+		return result;
+	}
+
+	if (benchmark_frames > 0) {
+		return benchmark_main(benchmark_frames, benchmark_settings);
+	}
+
 	if (kgfw_window_create(&state.window, 800, 600, "KGFW Racing Game") != 0) {
 		kgfw_deinit();
 		return 2;
 	}
+	kgfw_frame_set_window(&state.window);
 
 	if (kgfw_audio_init() != 0) {
 		kgfw_window_destroy(&state.window);
@@ -164,6 +254,7 @@ int main(int argc, char ** argv) {
 		kgfw_deinit();
 		return 3;
 	}
+	kgfw_graphics_light_new(&overhead_light);
 
 	if (textures_load() != 0) {
 		textures_cleanup();
@@ -249,14 +340,14 @@ int main(int argc, char ** argv) {
 		player_component = (player_t *) kgfw_entity_attach_component(player, pc_id);
 		player_component->camera = &state.camera;
 		
-		kgfw_graphics_mesh_t * m = mesh_get("forklift");
+		kgfw_graphics_mesh_t * m = mesh_find(HASH_FORKLIFT, "forklift");
 		if (m == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_DEBUG, "failed to load car obj");
 			return 69420;
 		}
 		player_component->car = kgfw_graphics_mesh_new(m, NULL);
 
-		ktga_t * tga = texture_get("forklift");
+		ktga_t * tga = texture_find(HASH_FORKLIFT, "forklift");
 		kgfw_graphics_texture_t tex = {
 			.bitmap = tga->bitmap,
 			.width = tga->header.img_w,
@@ -271,12 +362,13 @@ int main(int argc, char ** argv) {
 
 	kgfw_graphics_mesh_node_t * racetrack = NULL;
 	{
-		kgfw_graphics_mesh_t * m = mesh_get("racetrack");
+		kgfw_graphics_mesh_t * m = mesh_find(HASH_RACETRACK, "racetrack");
 		if (m == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_DEBUG, "failed to load test obj");
 			goto skip_load_m;
 		}
 		kgfw_graphics_mesh_node_t * node = kgfw_graphics_mesh_new(m, NULL);
+		kgfw_graphics_mesh_set_static(node, 1);
 
 		/*ktga_t * tga = texture_get("racetrack");
 		kgfw_graphics_texture_t tex = {
@@ -304,18 +396,12 @@ int main(int argc, char ** argv) {
 	state.gamepad->deadzone.rx = 0.20f;
 	state.gamepad->deadzone.ry = 0.20f;
 
+	if (kgfw_pipeline_init(&state.pipeline, sizeof(render_snapshot_t), simulate, player_component, state.pipelined) != 0) {
+		return 7;
+	}
+
 	while (!state.window.closed && !state.exit) {
 		kgfw_time_start();
-		if (kgfw_graphics_draw() != 0) {
-			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to draw");
-			break;
-		}
-
-		if (kgfw_window_update(&state.window) != 0) {
-			state.exit = 1;
-			break;
-		}
-
 		{
 			unsigned int w = state.window.width;
 			unsigned int h = state.window.height;
@@ -329,8 +415,24 @@ int main(int argc, char ** argv) {
 			}
 		}
 
-		kgfw_time_end();
-		kgfw_ecs_update();
+		/* when pipelined the next frame simulates while this one renders from the previous snapshot */
+		kgfw_time_update();
+		kgfw_pipeline_kick(&state.pipeline);
+		snapshot_apply(player_component, kgfw_pipeline_snapshot(&state.pipeline));
+
+		if (kgfw_frame_should_draw()) {
+			if (kgfw_graphics_draw() != 0) {
+				kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to draw");
+				break;
+			}
+
+			if (kgfw_window_update(&state.window) != 0) {
+				state.exit = 1;
+				break;
+			}
+		}
+
+		kgfw_pipeline_sync(&state.pipeline);
 
 		kgfw_input_update();
 		if (!state.gamepad->status.connected) {
@@ -349,6 +451,7 @@ int main(int argc, char ** argv) {
 		}
 	}
 
+	kgfw_pipeline_deinit(&state.pipeline);
 	kgfw_ecs_deinit();
 	kgfw_console_deinit();
 	meshes_cleanup();
@@ -362,6 +465,277 @@ int main(int argc, char ** argv) {
 	return 0;
 }
 
+static int benchmark_compare(const void * a, const void * b) {
+	float fa = *(const float *) a;
+	float fb = *(const float *) b;
+	return (fa > fb) - (fa < fb);
+}
+
+static float benchmark_percentile(float * sorted, unsigned int count, float percentile) {
+	unsigned int i = (unsigned int) (percentile * (count - 1) + 0.5f);
+	return sorted[min(i, count - 1)];
+}
+
+/* fixed scene and camera path so runs on different machines and commits are comparable */
+static int benchmark_run(unsigned int frames) {
+	kgfw_graphics_mesh_t * m = mesh_find(HASH_FORKLIFT, "forklift");
+	if (m == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "benchmark needs the forklift mesh");
+		return 5;
+	}
+
+	float * times = malloc(sizeof(float) * frames);
+	void * pixels = malloc((unsigned long long int) BENCHMARK_WIDTH * BENCHMARK_HEIGHT * 4);
+	if (times == NULL || pixels == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to allocate benchmark buffers");
+		free(times);
+		free(pixels);
+		return 6;
+	}
+
+	int lights[BENCHMARK_LIGHTS];
+	for (unsigned int i = 0; i < BENCHMARK_LIGHTS; ++i) {
+		/* golden angle spiral keeps the layout deterministic and evenly spread */
+		float angle = i * 2.39996f;
+		float distance = sqrtf(i / (float) BENCHMARK_LIGHTS) * BENCHMARK_GRID * 3.5f;
+		kgfw_graphics_light_t light = {
+			{ cosf(angle) * distance, 1.5f + (i % 3), sinf(angle) * distance },
+			{ 0.5f + 0.5f * cosf(angle), 0.5f + 0.5f * cosf(angle + 2.094f), 0.5f + 0.5f * cosf(angle + 4.189f) },
+			20, 6
+		};
+		lights[i] = kgfw_graphics_light_new(&light);
+	}
+
+	/* the grid shares one texture source and never moves, so it exercises static batching */
+	ktga_t * tga = texture_find(HASH_FORKLIFT, "forklift");
+	kgfw_graphics_mesh_node_t * nodes[BENCHMARK_GRID * BENCHMARK_GRID + 1] = { NULL };
+	for (unsigned int i = 0; i < BENCHMARK_GRID * BENCHMARK_GRID; ++i) {
+		nodes[i] = kgfw_graphics_mesh_new(m, NULL);
+		nodes[i]->transform.pos[0] = ((i % BENCHMARK_GRID) - (BENCHMARK_GRID - 1) * 0.5f) * 6;
+		nodes[i]->transform.pos[2] = ((i / BENCHMARK_GRID) - (BENCHMARK_GRID - 1) * 0.5f) * 6;
+		nodes[i]->transform.rot[1] = i * 37.0f;
+		if (tga != NULL) {
+			kgfw_graphics_texture_t tex = {
+				.bitmap = tga->bitmap,
+				.width = tga->header.img_w,
+				.height = tga->header.img_h,
+				.fmt = KGFW_GRAPHICS_TEXTURE_FORMAT_BGRA,
+				.u_wrap = KGFW_GRAPHICS_TEXTURE_WRAP_CLAMP,
+				.v_wrap = KGFW_GRAPHICS_TEXTURE_WRAP_CLAMP,
+				.filtering = KGFW_GRAPHICS_TEXTURE_FILTERING_NEAREST,
+			};
+			kgfw_graphics_mesh_texture(nodes[i], &tex, KGFW_GRAPHICS_TEXTURE_USE_COLOR);
+		}
+		kgfw_graphics_mesh_set_static(nodes[i], 1);
+	}
+	if (mesh_find(HASH_RACETRACK, "racetrack") != NULL) {
+		nodes[BENCHMARK_GRID * BENCHMARK_GRID] = kgfw_graphics_mesh_new(mesh_find(HASH_RACETRACK, "racetrack"), NULL);
+		kgfw_graphics_mesh_set_static(nodes[BENCHMARK_GRID * BENCHMARK_GRID], 1);
+	}
+
+	state.camera.tp = 1;
+	state.camera.ratio = BENCHMARK_WIDTH / (float) BENCHMARK_HEIGHT;
+	state.camera.focus[0] = 0;
+	state.camera.focus[1] = 0;
+	state.camera.focus[2] = 0;
+
+	int result = 0;
+	for (unsigned int i = 0; i < BENCHMARK_WARMUP + frames; ++i) {
+		/* one orbit over the measured frames while bobbing between high and low views */
+		float t = (i < BENCHMARK_WARMUP) ? 0 : (i - BENCHMARK_WARMUP) / (float) frames;
+		float angle = t * 2 * 3.141592f;
+		state.camera.pos[0] = cosf(angle) * 40;
+		state.camera.pos[1] = 12 + sinf(angle * 2) * 8;
+		state.camera.pos[2] = sinf(angle) * 40;
+
+		kgfw_time_start();
+		if (kgfw_graphics_draw() != 0) {
+			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to draw");
+			result = 7;
+			break;
+		}
+		kgfw_graphics_finish();
+		kgfw_time_end();
+
+		if (i >= BENCHMARK_WARMUP) {
+			times[i - BENCHMARK_WARMUP] = kgfw_time_delta_ns() / 1000000.0;
+		}
+	}
+
+	/* a partial run would report over unmeasured frames */
+	if (result == 0) {
+		kgfw_hash_t image = 0;
+		if (kgfw_graphics_read_pixels(pixels) == 0) {
+			image = kgfw_hash_length(pixels, (unsigned long long int) BENCHMARK_WIDTH * BENCHMARK_HEIGHT * 4);
+		}
+
+		float mean = 0;
+		for (unsigned int i = 0; i < frames; ++i) {
+			mean += times[i];
+		}
+		mean /= frames;
+		qsort(times, frames, sizeof(float), benchmark_compare);
+
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "benchmark %u frames at %ux%u", frames, BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "frame ms: mean %.3f  p50 %.3f  p90 %.3f  p95 %.3f  p99 %.3f  max %.3f", mean, benchmark_percentile(times, frames, 0.5f), benchmark_percentile(times, frames, 0.9f), benchmark_percentile(times, frames, 0.95f), benchmark_percentile(times, frames, 0.99f), times[frames - 1]);
+		kgfw_logf(KGFW_LOG_SEVERITY_INFO, "final frame hash %016llx", image);
+	}
+
+	for (unsigned int i = 0; i < BENCHMARK_GRID * BENCHMARK_GRID + 1; ++i) {
+		kgfw_graphics_mesh_destroy(nodes[i]);
+	}
+	for (unsigned int i = 0; i < BENCHMARK_LIGHTS; ++i) {
+		kgfw_graphics_light_destroy(lights[i]);
+	}
+	free(times);
+	free(pixels);
+	return result;
+}
+
+static int benchmark_main(unsigned int frames, unsigned int settings) {
+	if (kgfw_window_create_headless(&state.window, BENCHMARK_WIDTH, BENCHMARK_HEIGHT) != 0) {
+		kgfw_deinit();
+		return 2;
+	}
+
+	if (kgfw_graphics_init(&state.window, &state.camera) != 0) {
+		kgfw_window_destroy(&state.window);
+		kgfw_deinit();
+		return 3;
+	}
+	kgfw_graphics_settings_set(KGFW_GRAPHICS_SETTINGS_ACTION_SET, settings);
+	kgfw_graphics_light_new(&overhead_light);
+	kgfw_logf(KGFW_LOG_SEVERITY_INFO, "benchmark sort %s, depth pre-pass %s, occlusion culling %s", (settings & KGFW_GRAPHICS_SETTINGS_SORT) ? "on" : "off", (settings & KGFW_GRAPHICS_SETTINGS_DEPTH_PREPASS) ? "on" : "off", (settings & KGFW_GRAPHICS_SETTINGS_OCCLUSION) ? "on" : "off");
+
+	if (textures_load() != 0 || meshes_load() != 0) {
+		meshes_cleanup();
+		textures_cleanup();
+		kgfw_graphics_deinit();
+		kgfw_window_destroy(&state.window);
+		kgfw_deinit();
+		return 4;
+	}
+
+	int result = benchmark_run(frames);
+
+	meshes_cleanup();
+	textures_cleanup();
+	kgfw_graphics_deinit();
+	kgfw_window_destroy(&state.window);
+	kgfw_deinit();
+	return result;
+}
+
+static void benchmark_math_report(const char * name, long long int linmath, long long int kgfw, unsigned long long int ops, float checksum) {
+	kgfw_logf(KGFW_LOG_SEVERITY_INFO, "%-10s linmath %7.2f ns/op  kgfw_math %7.2f ns/op  %.2fx  (%g)", name, linmath / (double) ops, kgfw / (double) ops, linmath / (double) max(kgfw, 1), checksum);
+}
+
+/* linmath against kgfw_math on the operations the renderer does per mesh and per static vertex */
+static int benchmark_math(unsigned int passes) {
+	mat4x4 * a = malloc(sizeof(mat4x4) * BENCHMARK_MATH_COUNT);
+	mat4x4 * out = malloc(sizeof(mat4x4) * BENCHMARK_MATH_COUNT);
+	vec3 * transforms = malloc(sizeof(vec3) * 3 * BENCHMARK_MATH_COUNT);
+	kgfw_graphics_vertex_t * vertices = malloc(sizeof(kgfw_graphics_vertex_t) * BENCHMARK_MATH_COUNT);
+	if (a == NULL || out == NULL || transforms == NULL || vertices == NULL) {
+		kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to allocate benchmark buffers");
+		free(a);
+		free(out);
+		free(transforms);
+		free(vertices);
+		return 6;
+	}
+
+	for (unsigned int i = 0; i < BENCHMARK_MATH_COUNT; ++i) {
+		for (unsigned int k = 0; k < 16; ++k) {
+			a[i][k / 4][k % 4] = (float) ((i * 16 + k) % 7) - 3;
+		}
+		transforms[i * 3][0] = (float) (i % 13);
+		transforms[i * 3][1] = (float) (i % 5);
+		transforms[i * 3][2] = (float) (i % 11);
+		transforms[i * 3 + 1][0] = i * 1.7f;
+		transforms[i * 3 + 1][1] = i * 3.1f;
+		transforms[i * 3 + 1][2] = i * 0.3f;
+		transforms[i * 3 + 2][0] = 1;
+		transforms[i * 3 + 2][1] = 2;
+		transforms[i * 3 + 2][2] = 1;
+		kgfw_graphics_vertex_t vertex = { (float) (i % 3), (float) (i % 7), (float) (i % 5), 1, 1, 1, 0, 1, 0, 0, 0 };
+		vertices[i] = vertex;
+	}
+
+	unsigned long long int ops = (unsigned long long int) passes * BENCHMARK_MATH_COUNT;
+	float checksum = 0;
+	long long int start;
+	long long int linmath;
+
+	start = kgfw_time_ns();
+	for (unsigned int p = 0; p < passes; ++p) {
+		for (unsigned int i = 0; i < BENCHMARK_MATH_COUNT; ++i) {
+			mat4x4_mul(out[i], a[p % BENCHMARK_MATH_COUNT], a[i]);
+		}
+		checksum += out[p % BENCHMARK_MATH_COUNT][3][3];
+	}
+	linmath = kgfw_time_ns() - start;
+	start = kgfw_time_ns();
+	for (unsigned int p = 0; p < passes; ++p) {
+		kgfw_mat4_mul_batch((kgfw_mat4_t *) out, (kgfw_mat4_t *) a[p % BENCHMARK_MATH_COUNT], (kgfw_mat4_t *) a, BENCHMARK_MATH_COUNT);
+		checksum += out[p % BENCHMARK_MATH_COUNT][3][3];
+	}
+	benchmark_math_report("mul", linmath, kgfw_time_ns() - start, ops, checksum);
+
+	checksum = 0;
+	start = kgfw_time_ns();
+	for (unsigned int p = 0; p < passes; ++p) {
+		for (unsigned int i = 0; i < BENCHMARK_MATH_COUNT; ++i) {
+			mat4x4_translate(out[i], transforms[i * 3][0], transforms[i * 3][1], transforms[i * 3][2]);
+			mat4x4_rotate_X(out[i], out[i], transforms[i * 3 + 1][0] * 3.141592f / 180.0f);
+			mat4x4_rotate_Y(out[i], out[i], transforms[i * 3 + 1][1] * 3.141592f / 180.0f);
+			mat4x4_rotate_Z(out[i], out[i], transforms[i * 3 + 1][2] * 3.141592f / 180.0f);
+			mat4x4_scale_aniso(out[i], out[i], transforms[i * 3 + 2][0], transforms[i * 3 + 2][1], transforms[i * 3 + 2][2]);
+		}
+		checksum += out[p % BENCHMARK_MATH_COUNT][1][1];
+	}
+	linmath = kgfw_time_ns() - start;
+	start = kgfw_time_ns();
+	for (unsigned int p = 0; p < passes; ++p) {
+		for (unsigned int i = 0; i < BENCHMARK_MATH_COUNT; ++i) {
+			kgfw_mat4_trs((kgfw_mat4_t *) out[i], transforms[i * 3], transforms[i * 3 + 1], transforms[i * 3 + 2]);
+		}
+		checksum += out[p % BENCHMARK_MATH_COUNT][1][1];
+	}
+	benchmark_math_report("trs", linmath, kgfw_time_ns() - start, ops, checksum);
+
+	/* transforms are close to identity scale so repeated passes stay finite */
+	mat4x4 m;
+	mat4x4_identity(m);
+	mat4x4_rotate_Y(m, m, 0.001f);
+	checksum = 0;
+	start = kgfw_time_ns();
+	for (unsigned int p = 0; p < passes; ++p) {
+		for (unsigned int i = 0; i < BENCHMARK_MATH_COUNT; ++i) {
+			vec4 v = { vertices[i].x, vertices[i].y, vertices[i].z, 1 };
+			vec4 t;
+			mat4x4_mul_vec4(t, m, v);
+			vertices[i].x = t[0];
+			vertices[i].y = t[1];
+			vertices[i].z = t[2];
+		}
+		checksum += vertices[p % BENCHMARK_MATH_COUNT].x;
+	}
+	linmath = kgfw_time_ns() - start;
+	start = kgfw_time_ns();
+	for (unsigned int p = 0; p < passes; ++p) {
+		kgfw_mat4_transform_batch((kgfw_mat4_t *) m, &vertices[0].x, sizeof(kgfw_graphics_vertex_t), BENCHMARK_MATH_COUNT, 1);
+		checksum += vertices[p % BENCHMARK_MATH_COUNT].x;
+	}
+	benchmark_math_report("transform", linmath, kgfw_time_ns() - start, ops, checksum);
+
+	free(a);
+	free(out);
+	free(transforms);
+	free(vertices);
+	return 0;
+}
+
 static int kgfw_log_handler(kgfw_log_severity_enum severity, char * string) {
 	char * severity_strings[] = { "CONSOLE", "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
 	printf("[%s] %s\n", severity_strings[severity % 6], string);
@@ -585,14 +959,9 @@ static int textures_load(void) {
 		ktga_load(&storage.textures[i], buffer, size);
 		free(buffer);
 
-		if (names == NULL) {
-			unsigned long long int len = strlen(files->data.array.elements.string[i]);
-			storage.texture_hashes[i] = kgfw_hash(files->data.array.elements.string[i]);
-		}
-		else {
-			unsigned long long int len = strlen(names->data.array.elements.string[i]);
-			storage.texture_hashes[i] = kgfw_hash(names->data.array.elements.string[i]);
-		}
+		char * name = (names == NULL) ? files->data.array.elements.string[i] : names->data.array.elements.string[i];
+		storage.texture_hashes[i] = kgfw_hash(name);
+		storage.texture_names[i] = name_copy(name);
 	}
 
 skip_tga_load:;
@@ -609,14 +978,19 @@ static void textures_cleanup(void) {
 		ktga_destroy(&storage.textures[i]);
 		memset(&storage.textures[i], 0, sizeof(ktga_t));
 		memset(&storage.texture_hashes[i], 0, sizeof(kgfw_hash_t));
+		free(storage.texture_names[i]);
+		storage.texture_names[i] = NULL;
 	}
 	storage.textures_count = 0;
 }
 
 static ktga_t * texture_get(char * name) {
-	kgfw_hash_t hash = kgfw_hash(name);
+	return texture_find(kgfw_hash(name), name);
+}
+
+static ktga_t * texture_find(kgfw_hash_t hash, const char * name) {
 	for (unsigned long long int i = 0; i < storage.textures_count; ++i) {
-		if (hash == storage.texture_hashes[i]) {
+		if (hash == storage.texture_hashes[i] && storage.texture_names[i] != NULL && strcmp(storage.texture_names[i], name) == 0) {
 			return &storage.textures[i];
 		}
 	}
@@ -664,6 +1038,8 @@ static int meshes_load(void) {
 
 	koml_symbol_t * files = koml_table_symbol(&ktable, "meshes:files");
 	koml_symbol_t * names = koml_table_symbol(&ktable, "meshes:names");
+	koml_symbol_t * optimize = koml_table_symbol(&ktable, "meshes:optimize");
+	koml_symbol_t * lods = koml_table_symbol(&ktable, "meshes:lods");
 	if (files == NULL) {
 		goto skip_mesh_load;
 	}
@@ -693,21 +1069,40 @@ static int meshes_load(void) {
 
 		fclose(fp);
 
-		kobj_t kobj;
-		kobj_load(&kobj, buffer, size);
-
 		storage.meshes[mi] = (kgfw_graphics_mesh_t) {
 			.pos = { 0, 0, 0 },
 			.rot = { 0, 0, 0 },
 			.scale = { 1, 1, 1 },
+			/* kobj meshes carry no vertex colors */
+			.vertex_format = KGFW_GRAPHICS_VERTEX_FORMAT_PACKED,
 		};
 
-		storage.meshes[mi].vertices = malloc(sizeof(kgfw_graphics_vertex_t) * kobj.vcount);
+		unsigned char optimize_mesh = (optimize != NULL && optimize->type == KOML_TYPE_BOOLEAN && optimize->data.boolean);
+		unsigned int lods_count = (lods != NULL && lods->type == KOML_TYPE_INT && lods->data.i32 > 0) ? lods->data.i32 : 0;
+		kgfw_hash_t source_hash = 0;
+		char cache_path[64];
+		/* only fully processed meshes are cached, a failed step is retried on the next load */
+		unsigned char cache_mesh = optimize_mesh;
+		if (optimize_mesh) {
+			/* a different lod count has to miss the cache, so it is hashed together with the source */
+			unsigned long long int key[2] = { kgfw_hash_length(buffer, size), lods_count };
+			source_hash = kgfw_hash_length((const char *) key, sizeof(key));
+			snprintf(cache_path, sizeof(cache_path), MESH_CACHE_FMT, source_hash);
+			if (kgfw_mesh_cache_load(cache_path, source_hash, &storage.meshes[mi]) == 0) {
+				free(buffer);
+				goto mesh_loaded;
+			}
+		}
+
+		kobj_t kobj;
+		kobj_load(&kobj, buffer, size);
+
+		storage.meshes[mi].vertices = kgfw_memory_alloc(sizeof(kgfw_graphics_vertex_t) * kobj.vcount, KGFW_MEMORY_TAG_GRAPHICS);
 		if (storage.meshes[mi].vertices == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to allocate mesh vertices buffer");
 			return 1;
 		}
-		storage.meshes[mi].indices = malloc(sizeof(unsigned int) * 3 * kobj.fcount);
+		storage.meshes[mi].indices = kgfw_memory_alloc(sizeof(unsigned int) * 3 * kobj.fcount, KGFW_MEMORY_TAG_GRAPHICS);
 		if (storage.meshes[mi].indices == NULL) {
 			kgfw_logf(KGFW_LOG_SEVERITY_ERROR, "failed to allocate mesh indices buffer");
 			return 2;
@@ -769,11 +1164,35 @@ static int meshes_load(void) {
 
 		free(buffer);
 
-		if (names == NULL) {
-			storage.mesh_hashes[mi] = kgfw_hash(files->data.array.elements.string[mi]);
-		} else {
-			storage.mesh_hashes[mi] = kgfw_hash(names->data.array.elements.string[mi]);
+		if (optimize_mesh) {
+			kgfw_mesh_stats_t before;
+			kgfw_mesh_stats_t after;
+			if (kgfw_mesh_optimize(&storage.meshes[mi], &before, &after) != 0) {
+				kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to optimize \"%s\"", files->data.array.elements.string[mi]);
+				cache_mesh = 0;
+			} else {
+				kgfw_logf(KGFW_LOG_SEVERITY_INFO, "optimized \"%s\": acmr %.3f -> %.3f atvr %.3f -> %.3f", files->data.array.elements.string[mi], before.acmr, after.acmr, before.atvr, after.atvr);
+			}
 		}
+
+		if (lods_count > 0) {
+			if (kgfw_mesh_lods_generate(&storage.meshes[mi], lods_count) != 0) {
+				kgfw_logf(KGFW_LOG_SEVERITY_WARN, "failed to generate lods for \"%s\"", files->data.array.elements.string[mi]);
+				cache_mesh = 0;
+			}
+			for (unsigned long long int l = 0; l < storage.meshes[mi].lods_count; ++l) {
+				kgfw_logf(KGFW_LOG_SEVERITY_INFO, "\"%s\" lod %llu: %llu triangles error %f", files->data.array.elements.string[mi], l + 1, storage.meshes[mi].lods[l].indices_count / 3, storage.meshes[mi].lods[l].error);
+			}
+		}
+
+		if (cache_mesh) {
+			kgfw_mesh_cache_save(cache_path, source_hash, &storage.meshes[mi]);
+		}
+
+	mesh_loaded:;
+		char * name = (names == NULL) ? files->data.array.elements.string[mi] : names->data.array.elements.string[mi];
+		storage.mesh_hashes[mi] = kgfw_hash(name);
+		storage.mesh_names[mi] = name_copy(name);
 	}
 
 skip_mesh_load:;
@@ -784,19 +1203,25 @@ skip_mesh_load:;
 static void meshes_cleanup(void) {
 	for (unsigned long long int i = 0; i < storage.meshes_count; ++i) {
 		if (storage.meshes[i].vertices != NULL) {
-			free(storage.meshes[i].vertices);
+			kgfw_memory_free(storage.meshes[i].vertices);
 		}
 		if (storage.meshes[i].indices != NULL) {
-			free(storage.meshes[i].indices);
+			kgfw_memory_free(storage.meshes[i].indices);
 		}
+		kgfw_mesh_lods_destroy(&storage.meshes[i]);
+		free(storage.mesh_names[i]);
+		storage.mesh_names[i] = NULL;
 	}
 	storage.meshes_count = 0;
 }
 
 static kgfw_graphics_mesh_t * mesh_get(char * name) {
-	kgfw_hash_t hash = kgfw_hash(name);
+	return mesh_find(kgfw_hash(name), name);
+}
+
+static kgfw_graphics_mesh_t * mesh_find(kgfw_hash_t hash, const char * name) {
 	for (unsigned long long int i = 0; i < storage.meshes_count; ++i) {
-		if (hash == storage.mesh_hashes[i]) {
+		if (hash == storage.mesh_hashes[i] && storage.mesh_names[i] != NULL && strcmp(storage.mesh_names[i], name) == 0) {
 			return &storage.meshes[i];
 		}
 	}
@@ -804,8 +1229,18 @@ static kgfw_graphics_mesh_t * mesh_get(char * name) {
 	return NULL;
 }
 
+static char * name_copy(const char * name) {
+	unsigned long long int len = strlen(name);
+	char * copy = malloc(len + 1);
+	if (copy != NULL) {
+		memcpy(copy, name, len + 1);
+	}
+
+	return copy;
+}
+
 static int game_command(int argc, char ** argv) {
-	const char * subcommands = "mesh    fov    movement    arrow_speed    mouse_speed    jump_force    gravity    pos";
+	const char * subcommands = "mesh    fov    movement    arrow_speed    mouse_speed    jump_force    gravity    pos    pipeline";
 	if (argc < 2) {
 		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "subcommands: %s", subcommands);
 		return 0;
@@ -917,6 +1352,13 @@ static int game_command(int argc, char ** argv) {
 		state.camera.pos[0] = player.pos[0];
 		state.camera.pos[1] = player.pos[1];
 		state.camera.pos[2] = player.pos[2];
+	} else if (strcmp(argv[1], "pipeline") == 0) {
+		if (argc < 3) {
+			kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "pipelined: %u", state.pipeline.threaded);
+			return 0;
+		}
+
+		kgfw_pipeline_threaded_set(&state.pipeline, argv[2][0] == '1');
 	} else {
 		kgfw_logf(KGFW_LOG_SEVERITY_CONSOLE, "subcommands: %s", subcommands);
 	}
@@ -928,11 +1370,17 @@ static int game_command(int argc, char ** argv) {
 /* components */
 static void player_start(player_t * self) {
 	self->entity->transform.pos[1] = 2;
+	memcpy(self->prev_pos, self->entity->transform.pos, sizeof(vec3));
+	memcpy(self->prev_rot, self->entity->transform.rot, sizeof(vec3));
+	memcpy(self->prev_velocity, self->velocity, sizeof(vec3));
 
 	return;
 }
 
 static void player_update(player_t * self) {
+	memcpy(self->prev_pos, self->entity->transform.pos, sizeof(vec3));
+	memcpy(self->prev_rot, self->entity->transform.rot, sizeof(vec3));
+	memcpy(self->prev_velocity, self->velocity, sizeof(vec3));
 	if (!state.input) {
 		return;
 	}
@@ -944,7 +1392,7 @@ static void player_update(player_t * self) {
 	float look_slow_sensitivity = state.settings.arrow_speed / 4.0f;
 	float mouse_sensitivity = state.settings.mouse_speed;
 	float jump_force = state.settings.jump_force;
-	float delta = kgfw_time_delta();
+	float delta = kgfw_frame_tick_delta();
 	float c_forcedrag = 0.925f;
 	float c_drag = 0.99f;
 
@@ -954,7 +1402,10 @@ static void player_update(player_t * self) {
 
 	up[0] = 0; up[1] = 1; up[2] = 0;
 	right[0] = 0; right[1] = 0; right[2] = 0;
-	forward[0] = -sinf(self->entity->transform.rot[1] * 3.141592f / 180.0f); forward[1] = 0; forward[2] = cosf(self->entity->transform.rot[1] * 3.141592f / 180.0f);
+	/* the car is drawn with its yaw negated, so forward is +z turned the opposite way */
+	kgfw_quat_t inverse;
+	kgfw_quat_conjugate(&inverse, kgfw_transform_rotation(&self->entity->transform));
+	kgfw_quat_rotate(forward, &inverse, (vec3) { 0, 0, 1 });
 	vec3_mul_cross(right, up, forward);
 
 	vec3 t = { self->velocity[0] * forward[0], self->velocity[1] * forward[1], self->velocity[2] * forward[2] };
@@ -981,41 +1432,84 @@ static void player_update(player_t * self) {
 	vec3_add(fin, movement, drag);
 	vec3_scale(fin, fin, delta);
 
+	/* drag and braking compound per step, so other tick rates cover the same distance */
+	float steps = delta * PLAYER_STEP_RATE;
 	vec3_add(self->velocity, self->velocity, fin);
-	vec3_scale(self->velocity, self->velocity, c_drag);
-	vec3_scale(self->velocity, self->velocity, 1 - (brake / 100));
+	vec3_scale(self->velocity, self->velocity, powf(c_drag, steps));
+	vec3_scale(self->velocity, self->velocity, powf(1 - (brake / 100), steps));
 
-	vec3_add(self->entity->transform.pos, self->entity->transform.pos, self->velocity);
+	vec3 step;
+	vec3_scale(step, self->velocity, steps);
+	vec3_add(self->entity->transform.pos, self->entity->transform.pos, step);
+}
+
+static void player_interpolate(player_t * self, float alpha, render_snapshot_t * snapshot) {
+	snapshot->valid = state.input;
+	if (!state.input) {
+		return;
+	}
+
+	vec3 pos;
+	vec3 rot;
+	vec3 velocity;
+	for (unsigned int i = 0; i < 3; ++i) {
+		pos[i] = self->prev_pos[i] + (self->entity->transform.pos[i] - self->prev_pos[i]) * alpha;
+		rot[i] = self->prev_rot[i] + (self->entity->transform.rot[i] - self->prev_rot[i]) * alpha;
+		velocity[i] = self->prev_velocity[i] + (self->velocity[i] - self->prev_velocity[i]) * alpha;
+	}
 
-	self->camera->focus[0] = self->entity->transform.pos[0];
-	self->camera->focus[1] = self->entity->transform.pos[1] + 0.5f;
-	self->camera->focus[2] = self->entity->transform.pos[2];
-	vec4 cam_pos = { -sinf(self->entity->transform.rot[1] * 3.141592f / 180.0f) * 2, 1.33f, cosf(self->entity->transform.rot[1] * 3.141592f / 180.0f) * 2, 1 };
+	snapshot->camera_focus[0] = pos[0];
+	snapshot->camera_focus[1] = pos[1] + 0.5f;
+	snapshot->camera_focus[2] = pos[2];
+	vec4 cam_pos = { -sinf(rot[1] * 3.141592f / 180.0f) * 2, 1.33f, cosf(rot[1] * 3.141592f / 180.0f) * 2, 1 };
 
 	kgfw_logf(KGFW_LOG_SEVERITY_DEBUG, "%f %f %f %f", cam_pos[0], cam_pos[1], cam_pos[2], cam_pos[3]);
 
-	self->camera->fov = state.settings.fov + vec3_len(self->velocity) * 10;
+	snapshot->camera_fov = state.settings.fov + vec3_len(velocity) * 10;
 
-	self->camera->pos[0] = self->entity->transform.pos[0] + cam_pos[0] - self->velocity[0] * 10;
-	self->camera->pos[1] = self->entity->transform.pos[1] + cam_pos[1] - self->velocity[1] * 10;
-	self->camera->pos[2] = self->entity->transform.pos[2] + cam_pos[2] - self->velocity[2] * 10;
-	self->camera->rot[0] = self->entity->transform.rot[0];
-	self->camera->rot[1] = self->entity->transform.rot[1];
-	self->camera->rot[2] = self->entity->transform.rot[2];
+	snapshot->camera_pos[0] = pos[0] + cam_pos[0] - velocity[0] * 10;
+	snapshot->camera_pos[1] = pos[1] + cam_pos[1] - velocity[1] * 10;
+	snapshot->camera_pos[2] = pos[2] + cam_pos[2] - velocity[2] * 10;
+	snapshot->camera_rot[0] = rot[0];
+	snapshot->camera_rot[1] = rot[1];
+	snapshot->camera_rot[2] = rot[2];
 
-	self->car->transform.pos[0] = self->entity->transform.pos[0];
-	self->car->transform.pos[1] = self->entity->transform.pos[1];
-	self->car->transform.pos[2] = self->entity->transform.pos[2];
+	snapshot->car_pos[0] = pos[0];
+	snapshot->car_pos[1] = pos[1];
+	snapshot->car_pos[2] = pos[2];
 
-	self->car->transform.rot[0] = self->entity->transform.rot[0];
-	self->car->transform.rot[1] = fmod(-self->entity->transform.rot[1], 360);
-	self->car->transform.rot[2] = self->entity->transform.rot[2];
+	snapshot->car_rot[0] = rot[0];
+	snapshot->car_rot[1] = fmod(-rot[1], 360);
+	snapshot->car_rot[2] = rot[2];
 
 	if (kgfw_input_gamepad_pressed(state.gamepad, KGFW_GAMEPAD_LBUMPER)) {
-		self->camera->rot[1] = fmod(self->camera->rot[1] + 180, 360);
+		snapshot->camera_rot[1] = fmod(snapshot->camera_rot[1] + 180, 360);
 	}
 }
 
+static void simulate(void * data, void * snapshot) {
+	kgfw_frame_simulate();
+	player_interpolate(data, kgfw_frame_alpha(), snapshot);
+}
+
+static void snapshot_apply(player_t * player, const render_snapshot_t * snapshot) {
+	if (!snapshot->valid) {
+		return;
+	}
+
+	/* the camera and car are written directly, so on demand frames only see movement through this */
+	if (memcmp(player->camera->pos, snapshot->camera_pos, sizeof(vec3)) != 0 || memcmp(player->camera->rot, snapshot->camera_rot, sizeof(vec3)) != 0 || memcmp(player->camera->focus, snapshot->camera_focus, sizeof(vec3)) != 0 || player->camera->fov != snapshot->camera_fov || memcmp(player->car->transform.pos, snapshot->car_pos, sizeof(vec3)) != 0 || memcmp(player->car->transform.rot, snapshot->car_rot, sizeof(vec3)) != 0) {
+		kgfw_frame_request_redraw();
+	}
+
+	memcpy(player->camera->pos, snapshot->camera_pos, sizeof(vec3));
+	memcpy(player->camera->rot, snapshot->camera_rot, sizeof(vec3));
+	memcpy(player->camera->focus, snapshot->camera_focus, sizeof(vec3));
+	player->camera->fov = snapshot->camera_fov;
+	memcpy(player->car->transform.pos, snapshot->car_pos, sizeof(vec3));
+	memcpy(player->car->transform.rot, snapshot->car_rot, sizeof(vec3));
+}
+
 void player_destroy(player_t * self) {
 	return;
 }